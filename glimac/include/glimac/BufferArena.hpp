@@ -0,0 +1,121 @@
+/**
+ * \file BufferArena.hpp
+ * \brief Grand buffer OpenGL sous-alloué
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Buffer OpenGL alloué une fois, découpé en plages pour les maillages et rempli par le tampon d'envoi
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "RangeAllocator.hpp"
+#include "UploadRing.hpp"
+
+namespace glimac {
+
+    /*! \class BufferArena
+    * \brief Classe de buffer sous-alloué
+    *
+    *  Le buffer est alloué une fois au départ, les maillages y prennent et rendent des plages
+    *  (comptées en éléments de taille fixe) sans passer par le pilote. Quand il est plein, sa
+    *  capacité double et son contenu est recopié sur le GPU : le buffer OpenGL change alors.
+    */
+    class BufferArena {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe BufferArena : alloue le buffer (contexte OpenGL requis)
+            *
+            *  \param elementSize : taille d'un élément en octets
+            *  \param capacity : nombre d'éléments alloués au départ
+            */
+            BufferArena(size_t elementSize, GLuint capacity);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe BufferArena : libère le buffer
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~BufferArena();
+
+            /*!
+            *  \brief Allocation
+            *
+            *  Renvoit le premier élément d'une plage de count éléments, le buffer grandit si besoin
+            *
+            *  \param count : nombre d'éléments
+            */
+            GLuint allocate(GLuint count);
+            /*!
+            *  \brief Libération
+            *
+            *  Rend une plage obtenue par allocate
+            *
+            *  \param offset : premier élément
+            *  \param count : nombre d'éléments
+            */
+            void release(GLuint offset, GLuint count);
+            /*!
+            *  \brief Envoi
+            *
+            *  Remplit une plage en passant par le tampon d'envoi
+            *
+            *  \param ring : tampon d'envoi
+            *  \param offset : premier élément
+            *  \param count : nombre d'éléments
+            *  \param data : données
+            */
+            void upload(UploadRing& ring, GLuint offset, GLuint count, const void* data);
+
+            // Getter
+            /*!
+            *  \brief Renvoit le buffer
+            *
+            *  Renvoit le buffer OpenGL (il change quand la capacité double)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint getBuffer() const{
+                return m_buffer;
+            };
+            /*!
+            *  \brief Renvoit la capacité
+            *
+            *  Renvoit le nombre d'éléments alloués sur le GPU
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint getCapacity() const{
+                return m_ranges.getCapacity();
+            };
+            /*!
+            *  \brief Renvoit l'espace utilisé
+            *
+            *  Renvoit le nombre d'éléments occupés par des plages
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint getUsed() const{
+                return m_ranges.getUsed();
+            };
+
+        private:
+            BufferArena(const BufferArena&);
+            BufferArena& operator=(const BufferArena&);
+
+            void grow(GLuint capacity);
+
+            // Attributes
+            GLuint m_buffer; /*!< Buffer OpenGL*/
+            size_t m_elementSize; /*!< Taille d'un élément en octets*/
+            RangeAllocator m_ranges; /*!< Plages libres*/
+    };
+
+}
@@ -0,0 +1,148 @@
+/**
+ * \file Chunk.hpp
+ * \brief Stockage compressé d'un bloc de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Stockage d'un bloc de 16x16x16 voxels avec palette et indices compactés sur 1/2/4/8 bits
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+
+namespace glimac {
+
+    /*! \class Chunk
+    * \brief Classe representant un bloc de voxels compressé
+    *
+    *  Chaque voxel ne stocke qu'un indice dans la palette du bloc. La largeur des indices
+    *  (1, 2, 4 puis 8 bits) augmente uniquement lorsque la palette ne tient plus.
+    */
+    class Chunk {
+
+        public:
+            static const int SIZE = 16; /*!< Nombre de voxels par arête*/
+            static const int VOLUME = SIZE*SIZE*SIZE; /*!< Nombre de voxels du bloc*/
+            static const GLuint EMPTY = 0; /*!< Valeur d'un voxel vide (toujours en tête de palette)*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe Chunk : bloc vide, indices sur 1 bit
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            Chunk();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe Chunk
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~Chunk(){};
+
+            // Getter & setter
+            /*!
+            *  \brief Lecture d'un voxel
+            *
+            *  Renvoit la valeur du voxel (EMPTY si vide)
+            *
+            *  \param x : coordonnée locale sur l'axe x (0 à SIZE-1)
+            *  \param y : coordonnée locale sur l'axe y (0 à SIZE-1)
+            *  \param z : coordonnée locale sur l'axe z (0 à SIZE-1)
+            */
+            GLuint get(int x, int y, int z) const{
+                return m_palette[readIndex(index(x, y, z))];
+            };
+            /*!
+            *  \brief Ecriture d'un voxel
+            *
+            *  Modifie la valeur du voxel, la palette grandit si besoin
+            *
+            *  \param x : coordonnée locale sur l'axe x (0 à SIZE-1)
+            *  \param y : coordonnée locale sur l'axe y (0 à SIZE-1)
+            *  \param z : coordonnée locale sur l'axe z (0 à SIZE-1)
+            *  \param value : nouvelle valeur du voxel
+            */
+            void set(int x, int y, int z, GLuint value);
+            /*!
+            *  \brief Bloc vide
+            *
+            *  Renvoit vrai si tous les voxels du bloc sont vides
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isEmpty() const{
+                return m_counts[0] == VOLUME;
+            };
+            /*!
+            *  \brief Nombre de voxels pleins
+            *
+            *  Renvoit le nombre de voxels non vides du bloc
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getSolidCount() const{
+                return VOLUME - m_counts[0];
+            };
+            /*!
+            *  \brief Largeur des indices
+            *
+            *  Renvoit le nombre de bits utilisés par voxel (1, 2, 4, 8 ou 16)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            unsigned int getBitsPerIndex() const{
+                return m_bits;
+            };
+            /*!
+            *  \brief Taille de la palette
+            *
+            *  Renvoit le nombre d'entrées de la palette réellement utilisées
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            unsigned int getPaletteSize() const;
+            /*!
+            *  \brief Mémoire occupée
+            *
+            *  Renvoit le nombre d'octets occupés par le bloc (palette et indices)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getMemoryUsage() const;
+            /*!
+            *  \brief Indice linéaire
+            *
+            *  Renvoit l'indice linéaire d'un voxel (x varie le plus vite)
+            *
+            *  \param x : coordonnée locale sur l'axe x
+            *  \param y : coordonnée locale sur l'axe y
+            *  \param z : coordonnée locale sur l'axe z
+            */
+            static int index(int x, int y, int z){
+                return (y*SIZE + z)*SIZE + x;
+            };
+
+        private:
+            unsigned int readIndex(int i) const{
+                const unsigned int perWord = 32/m_bits;
+                const uint32_t mask = (1u << m_bits) - 1u;
+                return (m_data[i/perWord] >> ((i%perWord)*m_bits)) & mask;
+            };
+            void writeIndex(int i, unsigned int paletteIndex);
+            unsigned int findOrAddPalette(GLuint value);
+            void grow();
+
+            // Attributes
+            std::vector<GLuint> m_palette; /*!< Palette des valeurs du bloc*/
+            std::vector<uint16_t> m_counts; /*!< Nombre de voxels par entrée de palette*/
+            std::vector<uint32_t> m_data; /*!< Indices de palette compactés*/
+            unsigned int m_bits; /*!< Nombre de bits par indice*/
+    };
+
+}
@@ -0,0 +1,176 @@
+/**
+ * \file ChunkGrid.hpp
+ * \brief Grille de blocs de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Grille creuse de blocs (Chunk) indexée par coordonnées entières
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "Chunk.hpp"
+#include "VoxelStorage.hpp"
+
+namespace glimac {
+
+    /*! \class ChunkGrid
+    * \brief Classe representant une grille de blocs de voxels
+    *
+    *  Seuls les blocs contenant au moins un voxel plein sont alloués.
+    */
+    class ChunkGrid : public VoxelStorage {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe ChunkGrid
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ChunkGrid(){};
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe ChunkGrid
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~ChunkGrid(){};
+
+            // Getter & setter
+            /*!
+            *  \brief Lecture d'un voxel
+            *
+            *  Renvoit la valeur du voxel à la position donnée (Chunk::EMPTY si vide)
+            *
+            *  \param position : coordonnées entières du voxel
+            */
+            GLuint get(const glm::ivec3& position) const;
+            /*!
+            *  \brief Ecriture d'un voxel
+            *
+            *  Modifie la valeur du voxel, alloue ou libère le bloc si besoin
+            *
+            *  \param position : coordonnées entières du voxel
+            *  \param value : nouvelle valeur du voxel
+            */
+            void set(const glm::ivec3& position, GLuint value);
+            /*!
+            *  \brief Vide la grille
+            *
+            *  Supprime tous les blocs
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void clear(){
+                m_chunks.clear();
+            };
+            /*!
+            *  \brief Liste des voxels pleins
+            *
+            *  Ajoute au vecteur une cellule unitaire par voxel non vide
+            *
+            *  \param out : vecteur destination
+            */
+            void getCells(std::vector<VoxelCell>& out) const;
+            /*!
+            *  \brief Lancer de rayon
+            *
+            *  Parcours DDA qui ne recherche le bloc courant qu'au changement de bloc
+            *
+            *  \param origin : origine du rayon (espace monde)
+            *  \param direction : direction du rayon
+            *  \param maxDistance : distance maximale parcourue
+            *  \param hit : voxel et face touchés
+            */
+            bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, VoxelRayHit& hit) const;
+            /*!
+            *  \brief Lecture d'un pavé
+            *
+            *  Copie le pavé bloc par bloc : une seule recherche dans la table par bloc traversé
+            *
+            *  \param minCorner : coin minimal du pavé
+            *  \param size : dimensions du pavé
+            *  \param out : destination (size.x*size.y*size.z valeurs)
+            */
+            void getBlock(const glm::ivec3& minCorner, const glm::ivec3& size, GLuint* out) const;
+            /*!
+            *  \brief Renvoit un bloc
+            *
+            *  Renvoit un pointeur sur le bloc (nullptr s'il n'est pas alloué)
+            *
+            *  \param chunkCoord : coordonnées du bloc
+            */
+            const Chunk* getChunk(const glm::ivec3& chunkCoord) const;
+            /*!
+            *  \brief Liste des blocs
+            *
+            *  Renvoit les coordonnées de tous les blocs alloués
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            std::vector<glm::ivec3> getChunkCoords() const;
+            /*!
+            *  \brief Nombre de blocs
+            *
+            *  Renvoit le nombre de blocs alloués
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getChunkCount() const{
+                return m_chunks.size();
+            };
+            /*!
+            *  \brief Mémoire occupée
+            *
+            *  Renvoit le nombre d'octets occupés par les blocs
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getMemoryUsage() const;
+
+            // Coordinates
+            /*!
+            *  \brief Coordonnées du bloc
+            *
+            *  Renvoit les coordonnées du bloc contenant un voxel
+            *
+            *  \param position : coordonnées entières du voxel
+            */
+            static glm::ivec3 toChunkCoord(const glm::ivec3& position);
+            /*!
+            *  \brief Coordonnées locales
+            *
+            *  Renvoit les coordonnées du voxel dans son bloc (0 à Chunk::SIZE-1)
+            *
+            *  \param position : coordonnées entières du voxel
+            */
+            static glm::ivec3 toLocalCoord(const glm::ivec3& position);
+            /*!
+            *  \brief Clé de hachage
+            *
+            *  Compacte des coordonnées entières (21 bits signés par axe) dans un entier 64 bits
+            *
+            *  \param coord : coordonnées à compacter
+            */
+            static int64_t packKey(const glm::ivec3& coord);
+            /*!
+            *  \brief Coordonnées depuis une clé
+            *
+            *  Opération inverse de packKey
+            *
+            *  \param key : clé compactée
+            */
+            static glm::ivec3 unpackKey(int64_t key);
+
+        private:
+            // Attributes
+            std::unordered_map<int64_t, Chunk> m_chunks; /*!< Blocs alloués*/
+    };
+
+}
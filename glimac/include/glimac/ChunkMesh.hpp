@@ -0,0 +1,202 @@
+/**
+ * \file ChunkMesh.hpp
+ * \brief Maillage d'un bloc de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Construction sur le CPU du maillage d'un bloc : faces visibles uniquement, occlusion ambiante et lumière par sommet, sommets compactés, niveaux de détail
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "Chunk.hpp"
+#include "VoxelStorage.hpp"
+#include "VoxelLight.hpp"
+
+namespace glimac {
+
+    /*! \struct PackedVoxelVertex
+    * \brief Sommet compacté d'un maillage de voxels (8 octets)
+    *
+    *  Mot 0 : coordonnées locales au bloc x, y, z (5 bits chacune, 0 à 16, en cellules de 2^lod voxels), indice de normale (3 bits),
+    *  coin de la face (2 bits, donne les coordonnées de texture), occlusion ambiante (2 bits, 0 à 3).
+    *  Mot 1 : matériau (8 bits), lumière du ciel puis des blocs (4 bits chacune, voir VoxelLight), les bits restants sont réservés.
+    *  Le décodage est fait dans vertex.vs.glsl, l'origine et le niveau de détail du bloc sont un attribut constant par bloc.
+    */
+    struct PackedVoxelVertex {
+        GLuint data[2]; /*!< Mots compactés*/
+
+        PackedVoxelVertex(){}
+        PackedVoxelVertex(const glm::ivec3& local, GLuint normal, GLuint corner, GLuint occlusion, GLuint material, GLuint light){
+            data[0] = GLuint(local.x) | (GLuint(local.y) << 5) | (GLuint(local.z) << 10) | (normal << 15) | (corner << 18) | (occlusion << 20);
+            data[1] = (material & 0xFFu) | ((light & 0xFFu) << 8);
+        }
+        glm::ivec3 getLocal() const{
+            return glm::ivec3(data[0] & 31u, (data[0] >> 5) & 31u, (data[0] >> 10) & 31u);
+        };
+        GLuint getNormal() const{
+            return (data[0] >> 15) & 7u;
+        };
+        GLuint getCorner() const{
+            return (data[0] >> 18) & 3u;
+        };
+        GLuint getOcclusion() const{
+            return (data[0] >> 20) & 3u;
+        };
+        GLuint getMaterial() const{
+            return data[1] & 0xFFu;
+        };
+        GLuint getLight() const{
+            return (data[1] >> 8) & 0xFFu;
+        };
+    };
+
+    /*! \struct ChunkSubMesh
+    * \brief Plage d'indices d'un même matériau
+    *
+    *  Les faces d'une même valeur de voxel (donc d'une même texture) sont contiguës dans l'IBO.
+    */
+    struct ChunkSubMesh {
+        GLuint value; /*!< Valeur des voxels (indice de texture + 1)*/
+        GLuint indexOffset; /*!< Premier indice de la plage*/
+        GLsizei indexCount; /*!< Nombre d'indices de la plage*/
+
+        ChunkSubMesh(){}
+        ChunkSubMesh(GLuint value, GLuint indexOffset, GLsizei indexCount):value(value), indexOffset(indexOffset), indexCount(indexCount){}
+    };
+
+    /*! \class ChunkMesh
+    * \brief Classe representant le maillage d'un bloc de voxels
+    *
+    *  Seules les faces entre un voxel plein et un voxel vide sont émises. Chaque sommet reçoit
+    *  l'occlusion ambiante classique à 3 échantillons (deux côtés et le coin) : le coût est payé
+    *  une fois au maillage et rien n'est ajouté au rendu.
+    *  Au niveau de détail lod, le bloc est sous-échantillonné en cellules de 2^lod voxels d'arête.
+    */
+    class ChunkMesh {
+
+        public:
+            static const int MAX_LOD = 3; /*!< Niveau de détail le plus grossier (cellules de 8 voxels)*/
+            static const int MAX_OCCLUDERS = 4; /*!< Nombre maximal de pavés occultants par bloc*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe ChunkMesh : maillage vide
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ChunkMesh():m_chunkCoord(0), m_lod(0){};
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe ChunkMesh
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~ChunkMesh(){};
+
+            /*!
+            *  \brief Construction du maillage
+            *
+            *  Reconstruit le maillage du bloc à partir du stockage (le bloc et une couche de cellules voisines).
+            *  Une cellule sous-échantillonnée est pleine si l'un de ses voxels l'est et prend le matériau majoritaire.
+            *  Au-delà du niveau 0, les faces du bord du bloc sont toujours émises pour fermer les raccords
+            *  avec des blocs voisins d'un autre niveau.
+            *
+            *  \param storage : stockage des voxels
+            *  \param chunkCoord : coordonnées du bloc
+            *  \param lod : niveau de détail (0 à MAX_LOD)
+            *  \param light : lumière des voxels, moyennée aux coins des faces (plein ciel si nulle)
+            */
+            void build(const VoxelStorage& storage, const glm::ivec3& chunkCoord, int lod = 0, const VoxelLight* light = nullptr);
+
+            // Getter
+            /*!
+            *  \brief Maillage vide
+            *
+            *  Renvoit vrai si le bloc n'a aucune face visible
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isEmpty() const{
+                return m_indices.empty();
+            };
+            /*!
+            *  \brief Renvoit les sommets
+            *
+            *  Renvoit le tableau des sommets
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const std::vector<PackedVoxelVertex>& getVertices() const{
+                return m_vertices;
+            };
+            /*!
+            *  \brief Renvoit les indices
+            *
+            *  Renvoit le tableau des indices (triangles), rangés par matériau
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const std::vector<uint32_t>& getIndices() const{
+                return m_indices;
+            };
+            /*!
+            *  \brief Renvoit les plages par matériau
+            *
+            *  Renvoit les plages d'indices de chaque matériau
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const std::vector<ChunkSubMesh>& getSubMeshes() const{
+                return m_subMeshes;
+            };
+            /*!
+            *  \brief Renvoit les coordonnées du bloc
+            *
+            *  Renvoit les coordonnées du bloc maillé
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            glm::ivec3 getChunkCoord() const{
+                return m_chunkCoord;
+            };
+            /*!
+            *  \brief Renvoit le niveau de détail
+            *
+            *  Renvoit le niveau de détail du maillage (arête des cellules = 2^lod voxels)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getLOD() const{
+                return m_lod;
+            };
+            /*!
+            *  \brief Renvoit les occultants
+            *
+            *  Renvoit les plus grands pavés pleins du bloc (au plus MAX_OCCLUDERS, toujours à pleine résolution)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const std::vector<VoxelBox>& getOccluders() const{
+                return m_occluders;
+            };
+
+        private:
+            // Attributes
+            glm::ivec3 m_chunkCoord; /*!< Coordonnées du bloc*/
+            int m_lod; /*!< Niveau de détail*/
+            std::vector<PackedVoxelVertex> m_vertices; /*!< Sommets compactés*/
+            std::vector<uint32_t> m_indices; /*!< Indices, rangés par matériau*/
+            std::vector<ChunkSubMesh> m_subMeshes; /*!< Plages d'indices par matériau*/
+            std::vector<VoxelBox> m_occluders; /*!< Pavés pleins servant d'occultants*/
+    };
+
+    // Meshes rebuilt by key of chunk (ChunkGrid::packKey), nullptr for a chunk left without faces
+    typedef std::unordered_map<int64_t, std::shared_ptr<const ChunkMesh> > ChunkMeshUpdates;
+
+}
@@ -0,0 +1,220 @@
+/**
+ * \file ChunkRenderer.hpp
+ * \brief Rendu des maillages de blocs
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Envoi au GPU des maillages de blocs reconstruits et affichage par matériau
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "CubeList.hpp"
+#include "Texture.hpp"
+#include "OcclusionCuller.hpp"
+#include "BufferArena.hpp"
+
+namespace glimac {
+
+    /*! \class ChunkRenderer
+    * \brief Classe gérant les buffers OpenGL des blocs de voxels
+    *
+    *  Tous les blocs partagent un VAO, un VBO et un IBO alloués au départ, dans lesquels chacun occupe
+    *  une plage. Seuls les blocs remaillés par la liste de cubes sont renvoyés au GPU, via un tampon
+    *  circulaire projeté en mémoire (aucune allocation du pilote pendant l'image). Les blocs visibles sont
+    *  dessinés par un glMultiDrawElementsIndirect par matériau si le contexte le permet (OpenGL 4.3 ou
+    *  ARB_multi_draw_indirect), sinon par une boucle de glDrawElementsBaseVertex.
+    */
+    class ChunkRenderer {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe ChunkRenderer : crée les buffers partagés (contexte OpenGL requis)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ChunkRenderer();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe ChunkRenderer : libère les buffers
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~ChunkRenderer();
+
+            /*!
+            *  \brief Mise à jour
+            *
+            *  Envoie au GPU les maillages reconstruits par le thread de scène (à appeler à chaque image,
+            *  même sans maillage : les blocs modifiés de l'image précédente sont oubliés)
+            *
+            *  \param meshes : maillages des blocs modifiés ou changeant de niveau de détail
+            */
+            void update(const ChunkMeshUpdates& meshes);
+            /*!
+            *  \brief Elimination des blocs cachés
+            *
+            *  Rastérise les occultants des blocs les plus proches dans le culler, puis marque comme
+            *  invisibles les blocs hors du champ de vision ou cachés (ils ne sont plus dessinés)
+            *
+            *  \param culler : tampon de profondeur logiciel
+            *  \param viewProjection : matrice Projection * View
+            *  \param viewerPosition : position de la caméra
+            */
+            void cull(OcclusionCuller& culler, const glm::mat4& viewProjection, const glm::vec3& viewerPosition);
+            /*!
+            *  \brief Affichage
+            *
+            *  Dessine les blocs visibles, la texture d'une plage est textures[valeur - 1] (unité GL_TEXTURE0).
+            *  Le shader doit décoder les sommets compactés (uniforme uPackedVertices à vrai).
+            *
+            *  \param textures : textures de la scène
+            */
+            void draw(const std::vector<Texture>& textures);
+            /*!
+            *  \brief Affichage de la profondeur
+            *
+            *  Dessine tous les blocs dont la boîte touche le volume de la matrice donnée, sans matériau
+            *  (un appel par bloc), pour les cartes d'ombres
+            *
+            *  \param viewProjection : matrice Projection * View du volume (celle du programme en cours)
+            */
+            void drawDepth(const glm::mat4& viewProjection);
+
+            // Getter & setter
+            /*!
+            *  \brief Blocs modifiés
+            *
+            *  Renvoit le coin minimal des blocs remaillés, ajoutés ou supprimés par le dernier update
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const std::vector<glm::ivec3>& getUpdatedOrigins() const{
+                return m_updatedOrigins;
+            };
+            /*!
+            *  \brief Boîte de la scène
+            *
+            *  Calcule la boîte englobant tous les blocs présents sur le GPU (faux si aucun bloc)
+            *
+            *  \param boxMin : coin minimal (sortie)
+            *  \param boxMax : coin maximal (sortie)
+            */
+            bool getBounds(glm::vec3& boxMin, glm::vec3& boxMax) const;
+            /*!
+            *  \brief Multi-draw indirect disponible
+            *
+            *  Renvoit vrai si le contexte permet glMultiDrawElementsIndirect
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isMultiDrawSupported() const{
+                return m_multiDrawSupported;
+            };
+            /*!
+            *  \brief Mode de dessin
+            *
+            *  Renvoit vrai si les blocs sont dessinés par glMultiDrawElementsIndirect
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isMultiDraw() const{
+                return m_multiDraw;
+            };
+            /*!
+            *  \brief Choix du mode de dessin
+            *
+            *  Active le multi-draw indirect (ignoré s'il n'est pas disponible) ou la boucle par bloc
+            *
+            *  \param multiDraw : vrai pour le multi-draw indirect
+            */
+            void setMultiDraw(bool multiDraw){
+                m_multiDraw = multiDraw && m_multiDrawSupported;
+            };
+            /*!
+            *  \brief Nombre de blocs
+            *
+            *  Renvoit le nombre de blocs présents sur le GPU
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getChunkCount() const{
+                return m_chunks.size();
+            };
+            /*!
+            *  \brief Nombre de blocs visibles
+            *
+            *  Renvoit le nombre de blocs gardés par le dernier appel à cull
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getVisibleChunkCount() const{
+                return m_visibleCount;
+            };
+            /*!
+            *  \brief Nombre d'appels de dessin
+            *
+            *  Renvoit le nombre d'appels de dessin OpenGL du dernier draw
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getDrawCallCount() const{
+                return m_drawCallCount;
+            };
+
+        private:
+            ChunkRenderer(const ChunkRenderer&);
+            ChunkRenderer& operator=(const ChunkRenderer&);
+
+            struct GPUChunk {
+                GLuint vertexOffset; /*!< Premier sommet dans le VBO partagé*/
+                GLuint vertexCount;
+                GLuint indexOffset; /*!< Premier indice dans l'IBO partagé*/
+                GLuint indexCount;
+                glm::ivec3 origin;
+                int lod;
+                std::vector<ChunkSubMesh> subMeshes;
+                std::vector<VoxelBox> occluders;
+                bool visible;
+            };
+
+            // Layout imposed by glMultiDrawElementsIndirect
+            struct DrawElementsIndirectCommand {
+                GLuint count;
+                GLuint instanceCount;
+                GLuint firstIndex;
+                GLint baseVertex;
+                GLuint baseInstance;
+            };
+
+            void upload(GPUChunk& chunk, const ChunkMesh& mesh);
+            void release(GPUChunk& chunk);
+            void setupVertexArray();
+
+            // Attributes
+            std::unordered_map<int64_t, GPUChunk> m_chunks; /*!< Blocs non vides*/
+            size_t m_visibleCount; /*!< Nombre de blocs gardés par cull*/
+            size_t m_drawCallCount; /*!< Nombre d'appels de dessin du dernier draw*/
+            GLuint m_vao; /*!< VAO partagé*/
+            GLuint m_vaoVertexBuffer; /*!< VBO attaché au VAO*/
+            GLuint m_vaoIndexBuffer; /*!< IBO attaché au VAO*/
+            BufferArena m_vertices; /*!< VBO partagé (sommets compactés)*/
+            BufferArena m_indices; /*!< IBO partagé*/
+            UploadRing m_uploads; /*!< Envoi des maillages, des origines et des commandes*/
+            bool m_multiDrawSupported; /*!< Contexte compatible multi-draw indirect*/
+            bool m_multiDraw; /*!< Multi-draw indirect actif*/
+            std::vector<DrawElementsIndirectCommand> m_commands; /*!< Commandes de l'image, rangées par matériau*/
+            std::vector<glm::ivec4> m_instances; /*!< Origine et niveau de détail de chaque commande*/
+            std::vector<std::pair<GLuint, size_t> > m_batches; /*!< Matériau et nombre de commandes de chaque lot*/
+            std::vector<glm::ivec3> m_updatedOrigins; /*!< Blocs modifiés par le dernier update*/
+            const GLuint VERTEX_ATTR_PACKED = 3;
+            const GLuint VERTEX_ATTR_CHUNK_ORIGIN = 4;
+    };
+
+}
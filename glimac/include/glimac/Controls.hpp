@@ -19,6 +19,8 @@ namespace glimac {
     * \brief Classe representant une camera
     *
     *  La classe gère la création et la manipulation de la caméra dans une scène 3D.
+    *  Les modifications marquent les vecteurs et les matrices à recalculer : ils ne le sont
+    *  qu'à leur prochaine lecture, une fois quel que soit le nombre de modifications.
     */
 
 
@@ -47,7 +49,7 @@ namespace glimac {
             /*!
             *  \brief Mise à jour des informations caméra
             *
-            *  Mise à jours de direction & right & up
+            *  Mise à jours de direction & right & up, seulement si les angles ont changé
             *
             *  \param null : aucuns parametres nécéssaires
             */
@@ -55,11 +57,30 @@ namespace glimac {
             /*!
             *  \brief Mise à jour des informations caméra
             *
-            *  Mise à jour de la ProjectionMatrix & ViewMatrix
+            *  Mise à jour de la ProjectionMatrix & ViewMatrix, seulement si la caméra a changé
             *
             *  \param null : aucuns parametres nécéssaires
             */
             void computeFinalMatrices();
+            /*!
+            *  \brief Déplacement continu
+            *
+            *  Déplace la caméra à vitesse constante quelle que soit la fréquence d'affichage
+            *
+            *  \param axes : sens du déplacement sur right, up et direction (entre -1 et 1)
+            *  \param deltaTime : temps écoulé depuis l'image précédente, en secondes
+            */
+            void move(glm::vec3 axes, float deltaTime);
+            /*!
+            *  \brief Rotation continue
+            *
+            *  Tourne la caméra à vitesse constante quelle que soit la fréquence d'affichage
+            *
+            *  \param horizontal : sens de rotation de l'angle horizontal (entre -1 et 1)
+            *  \param vertical : sens de rotation de l'angle vertical (entre -1 et 1)
+            *  \param deltaTime : temps écoulé depuis l'image précédente, en secondes
+            */
+            void turn(float horizontal, float vertical, float deltaTime);
 
             // Getter & setter
             /*!
@@ -190,23 +211,51 @@ namespace glimac {
             *  \param newDirection : nouveau vecteur rigdirectionht
             */
             void setDirection(glm::vec3 newDirection);
+            /*!
+            *  \brief Edition du rapport largeur / hauteur
+            *
+            *  Modifier le rapport de la ProjectionMatrix (celui de la fenêtre)
+            *
+            *  \param aspectRatio : largeur divisée par hauteur
+            */
+            void setAspectRatio(float aspectRatio);
+            /*!
+            *  \brief Rayon sous la souris
+            *
+            *  Déprojette une position écran à travers les matrices de vue et de projection
+            *
+            *  \param mousePosition : position de la souris en pixels (origine en haut à gauche)
+            *  \param viewport : zone d'affichage (x, y, largeur, hauteur)
+            *  \param origin : origine du rayon (sur le plan proche)
+            *  \param direction : direction normalisée du rayon
+            */
+            void getRay(glm::ivec2 mousePosition, glm::vec4 viewport, glm::vec3& origin, glm::vec3& direction) const;
 
 
         private :
+            void update() const;
+
             // Attributes
-            glm::mat4 m_ViewMatrix; /*!< Matrice de Vue*/
-            glm::mat4 m_ProjectionMatrix; /*!< Matrice de Projection*/
+            mutable glm::mat4 m_ViewMatrix; /*!< Matrice de Vue*/
+            mutable glm::mat4 m_ProjectionMatrix; /*!< Matrice de Projection*/
+            float m_aspectRatio; /*!< Rapport largeur / hauteur de la fenêtre*/
 
             float m_horizontalAngle; /*!< Valeur de l'angle horizontal*/
             float m_verticalAngle; /*!< Valeur de l'angle vertical*/
             float m_initialFoV; /*!< Valeur du champ de vision (niveau de zoom)*/
 
             float m_speed; /*!< Valeur de la vitesse*/
+            float m_moveSpeed; /*!< Vitesse de déplacement continu, en unités par seconde*/
+            float m_turnSpeed; /*!< Vitesse de rotation continue, en radians par seconde*/
 
             glm::vec3 m_position; /*!< Vecteur de postion*/
-            glm::vec3 m_direction; //*!< Vecteur de sur l'axe z */
-            glm::vec3 m_right; /*!< Vecteur de sur l'axe x */
-            glm::vec3 m_up; /*!< Vecteur de sur l'axe y */
+            mutable glm::vec3 m_direction; //*!< Vecteur de sur l'axe z */
+            mutable glm::vec3 m_right; /*!< Vecteur de sur l'axe x */
+            mutable glm::vec3 m_up; /*!< Vecteur de sur l'axe y */
+
+            mutable bool m_vectorsDirty; /*!< Angles modifiés : direction, right et up à recalculer*/
+            mutable bool m_viewDirty; /*!< ViewMatrix à recalculer*/
+            mutable bool m_projectionDirty; /*!< ProjectionMatrix à recalculer*/
 
     };
 
@@ -12,6 +12,12 @@
 #pragma once
 #include "common.hpp"
 #include "Cube.hpp"
+#include "ChunkGrid.hpp"
+#include "SparseVoxelOctree.hpp"
+#include "ChunkMesh.hpp"
+#include "VoxelLight.hpp"
+#include "JobSystem.hpp"
+#include <unordered_set>
 
 namespace glimac {
 
@@ -150,7 +156,7 @@ namespace glimac {
             /*!
             *  \brief Génère une liste de vertex buffer
             *
-            *  Génère une liste de vertex buffer pour les cubes de la cube list
+            *  Associe à chaque cube de la cube list le vertex buffer partagé
             *
             *  \param null : aucun paramètre nécessaire
             */
@@ -158,7 +164,7 @@ namespace glimac {
             /*!
             *  \brief Génère une liste de vao
             *
-            *  Génère une liste de vao pour les cubes de la cube list
+            *  Associe à chaque cube de la cube list le vao partagé
             *
             *  \param null : aucun paramètre nécessaire
             */
@@ -166,7 +172,7 @@ namespace glimac {
             /*!
             *  \brief Génère une liste de ibo
             *
-            *  Génère une liste de ibo pour les cubes de la cube list
+            *  Associe à chaque cube de la cube list l'ibo partagé
             *
             *  \param null : aucun paramètre nécessaire
             */
@@ -340,6 +346,14 @@ namespace glimac {
             */
             void deleteCube(int index);
             /*!
+            *  \brief Suppression du dernier cube
+            *
+            *  Supprime le dernier cube de la liste sans renuméroter les autres (vidage rapide)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void popCube();
+            /*!
             *  \brief Tri de la liste
             *
             *  Tri de la liste de cubes
@@ -398,7 +412,7 @@ namespace glimac {
             *  \param points : matrice de points
             *  \param rbf : choix de la RBF utilisée
             */
-            Eigen::VectorXd radialBasisFunction(Eigen::MatrixXd points, std::string rbf="default", float epsilon = 1.0);
+            static Eigen::VectorXd radialBasisFunction(Eigen::MatrixXd points, std::string rbf="default", float epsilon = 1.0);
             /*!
             *  \brief Interpolation de points
             *
@@ -409,14 +423,159 @@ namespace glimac {
             *  \param points : matrice de points
             *  \param rbf : choix de la RBF utilisée
             */
-            double interpolatePoints(double x, double y, Eigen::MatrixXd points, std::string rbf="default", float epsilon = 1.0);
+            static double interpolatePoints(double x, double y, Eigen::MatrixXd points, std::string rbf="default", float epsilon = 1.0);
+            /*!
+            *  \brief Interpolation de points
+            *
+            *  Interpolation avec des poids déjà calculés par radialBasisFunction (une résolution pour toute une grille)
+            *
+            *  \param x : point x
+            *  \param z : point z
+            *  \param points : matrice de points
+            *  \param weights : poids des points
+            */
+            static double interpolatePoints(double x, double z, const Eigen::MatrixXd& points, const Eigen::VectorXd& weights);
+            /*!
+            *  \brief Recherche d'un voxel
+            *
+            *  Renvoit la valeur du voxel à une position (0 si vide, sinon index de texture + 1)
+            *
+            *  \param x : coordonnée x
+            *  \param y : coordonnée y
+            *  \param z : coordonnée z
+            */
+            GLuint findAt(int x, int y, int z) const{
+                return m_storage->get(glm::ivec3(x, y, z));
+            };
+            /*!
+            *  \brief Renvoit le stockage des voxels
+            *
+            *  Renvoit la représentation voxel (grille de blocs ou octree) qui reflète la liste de cubes
+            *
+            *  \param null : aucun paramètre nécessaire
+            */
+            const VoxelStorage& getStorage() const{
+                return *m_storage;
+            };
+            /*!
+            *  \brief Renvoit la lumière des voxels
+            *
+            *  Renvoit la lumière du ciel et des blocs lumineux, tenue à jour à chaque modification de voxel
+            *
+            *  \param null : aucun paramètre nécessaire
+            */
+            const VoxelLight& getLight() const{
+                return m_light;
+            };
+            /*!
+            *  \brief Emission d'une texture
+            *
+            *  Fait briller (ou éteint) les cubes d'une texture : leur lumière est propagée dans les voxels vides
+            *
+            *  \param textureIndex : indice de texture des cubes
+            *  \param level : niveau émis (0 à VoxelLight::MAX_LEVEL)
+            */
+            void setEmission(GLuint textureIndex, int level){
+                m_light.setEmission(*m_storage, textureIndex + 1, level);
+            };
+            /*!
+            *  \brief Renvoit l'émission d'une texture
+            *
+            *  Renvoit le niveau de lumière émis par les cubes d'une texture
+            *
+            *  \param textureIndex : indice de texture des cubes
+            */
+            int getEmission(GLuint textureIndex) const{
+                return m_light.getEmission(textureIndex + 1);
+            };
+            /*!
+            *  \brief Choix du stockage des voxels
+            *
+            *  Bascule entre la grille de blocs compressés et l'octree creux (les voxels sont recopiés)
+            *
+            *  \param sparse : vrai pour l'octree creux, faux pour la grille de blocs
+            */
+            void setSparseStorage(bool sparse);
+            /*!
+            *  \brief Stockage creux
+            *
+            *  Renvoit vrai si les voxels sont stockés dans l'octree creux
+            *
+            *  \param null : aucun paramètre nécessaire
+            */
+            bool isSparseStorage() const{
+                return m_sparseStorage;
+            };
+            /*!
+            *  \brief Mise à jour des maillages
+            *
+            *  Reconstruit uniquement les maillages des blocs modifiés depuis le dernier appel et ceux
+            *  dont le niveau de détail change (choisi selon la distance à l'observateur, avec hystérésis).
+            *  Les blocs sont remaillés en parallèle par le système de tâches s'il est donné.
+            *
+            *  \param viewerPosition : position de la caméra
+            *  \param jobs : système de tâches (optionnel)
+            */
+            void updateMeshes(const glm::vec3& viewerPosition, JobSystem* jobs = nullptr);
+            /*!
+            *  \brief Blocs remaillés
+            *
+            *  Renvoit (et oublie) les clés des blocs dont le maillage a changé depuis le dernier appel
+            *
+            *  \param null : aucun paramètre nécessaire
+            */
+            std::vector<int64_t> takeUpdatedChunks();
+            /*!
+            *  \brief Renvoit le maillage d'un bloc
+            *
+            *  Renvoit le maillage du bloc de clé donnée (nullptr si le bloc n'a aucune face)
+            *
+            *  \param key : clé du bloc (ChunkGrid::packKey)
+            */
+            const ChunkMesh* getChunkMesh(int64_t key) const;
       
         private:
+            /*!
+            *  \brief Valeur de voxel d'un cube
+            *
+            *  Renvoit la valeur stockée dans la grille pour un cube (index de texture + 1)
+            *
+            *  \param cube : cube concerné
+            */
+            static GLuint voxelValue(const Cube& cube){
+                return cube.getTextureIndex() + 1;
+            };
+            /*!
+            *  \brief Position de voxel d'un cube
+            *
+            *  Renvoit la cellule de la grille occupée par un cube
+            *
+            *  \param cube : cube concerné
+            */
+            static glm::ivec3 voxelPosition(const Cube& cube){
+                return glm::ivec3(glm::floor(cube.getTrans() + glm::vec3(0.5f)));
+            };
+            void placeVoxel(const Cube& cube);
+            void removeVoxel(const Cube& cube);
+            void writeVoxel(const glm::ivec3& position, GLuint value);
+            void markDirty(const glm::ivec3& position);
+            void createCubeBuffers();
+
             // Attributes
             std::vector<Cube> m_cubeList; /*!< Liste de cubes*/
             std::vector<GLuint> vboList; /*!< Liste vbo*/
             std::vector<GLuint> vaoList; /*!< Liste vao*/
             std::vector<GLuint> iboList; /*!< Liste ibo*/
+            GLuint m_cubeVBO; /*!< VBO partagé par tous les cubes*/
+            GLuint m_cubeVAO; /*!< VAO partagé par tous les cubes*/
+            GLuint m_cubeIBO; /*!< IBO partagé par tous les cubes*/
+            std::unique_ptr<VoxelStorage> m_storage; /*!< Stockage des voxels (grille de blocs ou octree creux)*/
+            VoxelLight m_light; /*!< Lumière du ciel et des blocs lumineux*/
+            bool m_sparseStorage; /*!< Vrai si le stockage est l'octree creux*/
+            std::unordered_map<int64_t, std::vector<GLuint> > m_stacked; /*!< Valeurs des cubes superposés sur une même cellule, dans l'ordre de pose*/
+            std::unordered_map<int64_t, ChunkMesh> m_meshes; /*!< Maillages des blocs non vides*/
+            std::unordered_set<int64_t> m_dirtyChunks; /*!< Blocs à remailler*/
+            std::vector<int64_t> m_updatedChunks; /*!< Blocs remaillés pas encore envoyés au GPU*/
             const GLuint VERTEX_ATTR_POSITION = 0;
             const GLuint VERTEX_ATTR_NORMAL = 1;
             const GLuint VERTEX_ATTR_TEXTURE = 2;
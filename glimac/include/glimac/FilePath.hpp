@@ -68,6 +68,16 @@ public:
         return offset >= 0 && m_FilePath.substr(offset, ext.size()) == ext;
     }
 
+    /*! replaces the file extension (or adds it if there is none), ext without the dot */
+    FilePath replaceExt(const std::string& ext) const {
+        size_t dot = m_FilePath.find_last_of('.');
+        size_t separator = m_FilePath.find_last_of(PATH_SEPARATOR);
+        if (dot == std::string::npos || dot == 0 || (separator != std::string::npos && dot < separator)) {
+            return FilePath(m_FilePath + "." + ext);
+        }
+        return FilePath(m_FilePath.substr(0, dot + 1) + ext);
+    }
+
     /*! adds file extension */
     FilePath addExt(const std::string& ext = "") const {
         return FilePath(m_FilePath + ext);
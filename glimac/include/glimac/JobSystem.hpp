@@ -0,0 +1,189 @@
+/**
+ * \file JobSystem.hpp
+ * \brief Système de tâches à vol de travail
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Petites tâches de l'image (remaillage des blocs) réparties sur tous les coeurs, chaque thread
+ * ayant sa propre file et volant celles des autres quand elle est vide
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace glimac {
+
+    /*! \class JobGroup
+    * \brief Groupe de tâches attendues ensemble
+    *
+    *  Compte les tâches lancées et pas encore terminées (voir JobSystem::wait)
+    */
+    class JobGroup {
+
+        public:
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe JobGroup : aucune tâche
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            JobGroup():
+                m_pending(0) {};
+
+            /*!
+            *  \brief Fin des tâches
+            *
+            *  Renvoit vrai si toutes les tâches du groupe sont terminées
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isDone() const{
+                return m_pending.load() == 0;
+            };
+
+        private:
+            friend class JobSystem;
+            JobGroup(const JobGroup&);
+            JobGroup& operator=(const JobGroup&);
+
+            std::atomic<int> m_pending; /*!< Tâches non terminées*/
+    };
+
+    /*! \class JobSystem
+    * \brief Classe de système de tâches
+    *
+    *  Chaque thread de travail a sa file : il y ajoute et reprend ses tâches par la fin (les plus
+    *  récentes, encore en cache), et quand elle est vide il vole la plus ancienne d'une autre file.
+    *  Les threads extérieurs (le thread principal) partagent une file supplémentaire. Attendre un
+    *  groupe exécute des tâches au lieu de bloquer. Contrairement à ThreadPool, fait pour les tâches de
+    *  chargement, les tâches ne renvoient rien, ne doivent pas lever d'exception ni appeler OpenGL.
+    */
+    class JobSystem {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe JobSystem : démarre les threads
+            *
+            *  \param workerCount : nombre de threads (0 = un par coeur, moins le thread principal)
+            */
+            JobSystem(unsigned int workerCount = 0);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe JobSystem : termine les tâches en file puis arrête les threads
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~JobSystem();
+
+            /*!
+            *  \brief Lancement d'une tâche
+            *
+            *  Ajoute une tâche à la file du thread appelant
+            *
+            *  \param group : groupe de la tâche
+            *  \param job : fonction sans paramètre
+            */
+            void run(JobGroup& group, std::function<void()> job);
+            /*!
+            *  \brief Attente
+            *
+            *  Exécute des tâches (de toutes les files) jusqu'à la fin de celles du groupe
+            *
+            *  \param group : groupe attendu
+            */
+            void wait(JobGroup& group);
+            /*!
+            *  \brief Boucle parallèle
+            *
+            *  Appelle function(i) pour i de begin à end-1 et attend la fin. L'intervalle est coupé en
+            *  deux jusqu'à grain éléments : les moitiés hautes, mises en file, sont volées en premier.
+            *
+            *  \param begin : premier index
+            *  \param end : fin de l'intervalle (exclue)
+            *  \param grain : nombre d'éléments en dessous duquel un intervalle n'est plus coupé
+            *  \param function : fonction void(size_t), appelée en même temps par plusieurs threads
+            */
+            template<typename Function>
+            void parallelFor(size_t begin, size_t end, size_t grain, const Function& function){
+                JobGroup group;
+                split(group, begin, end, std::max<size_t>(grain, 1), function);
+                wait(group);
+            };
+
+            // Getters
+            /*!
+            *  \brief Nombre de threads
+            *
+            *  Renvoit le nombre de threads de travail
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getWorkerCount() const{
+                return m_workers.size();
+            };
+            /*!
+            *  \brief Nombre de vols
+            *
+            *  Renvoit le nombre de tâches prises dans la file d'un autre thread depuis le départ
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            uint64_t getStealCount() const{
+                return m_stealCount.load();
+            };
+
+        private:
+            JobSystem(const JobSystem&);
+            JobSystem& operator=(const JobSystem&);
+
+            struct Job {
+                std::function<void()> function;
+                JobGroup* group;
+            };
+
+            struct WorkQueue {
+                std::mutex mutex;
+                std::deque<Job> jobs;
+            };
+
+            template<typename Function>
+            void split(JobGroup& group, size_t begin, size_t end, size_t grain, const Function& function){
+                // Both references outlive the jobs : parallelFor waits for the group
+                while(end - begin > grain){
+                    const size_t middle = begin + (end - begin)/2;
+                    run(group, [this, &group, middle, end, grain, &function](){ split(group, middle, end, grain, function); });
+                    end = middle;
+                }
+                for(size_t i=begin; i<end; i++){
+                    function(i);
+                }
+            };
+
+            size_t currentQueue() const;
+            bool runOne(size_t queue);
+            void work(size_t queue);
+
+            // Attributes
+            std::vector<std::unique_ptr<WorkQueue> > m_queues; /*!< File des threads extérieurs, puis une par thread de travail*/
+            std::vector<std::thread> m_workers; /*!< Threads de travail*/
+            std::atomic<int> m_queuedJobs; /*!< Tâches en file, toutes files confondues*/
+            std::atomic<uint64_t> m_stealCount; /*!< Tâches volées*/
+            std::mutex m_sleepMutex; /*!< Protège l'endormissement et m_stopping*/
+            std::condition_variable m_wake; /*!< Réveille les threads à l'arrivée d'une tâche*/
+            bool m_stopping; /*!< Les threads s'arrêtent quand les files sont vides*/
+    };
+
+}
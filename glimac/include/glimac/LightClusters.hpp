@@ -0,0 +1,146 @@
+/**
+ * \file LightClusters.hpp
+ * \brief Répartition des lumières ponctuelles en clusters
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Eclairage forward par clusters : les lumières ponctuelles sont réparties chaque image dans une grille
+ * de l'espace View, le fragment shader ne parcourt que les lumières de son cluster
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "UniformBuffer.hpp"
+
+namespace glimac {
+
+    /*! \struct PointLight
+    * \brief Lumière ponctuelle
+    *
+    *  Lumière ponctuelle en espace monde, sans effet au-delà de son rayon
+    */
+    struct PointLight {
+        glm::vec3 position; /*!< Position (espace monde)*/
+        glm::vec3 color; /*!< Couleur*/
+        float intensity; /*!< Intensité*/
+        float radius; /*!< Portée*/
+
+        PointLight(const glm::vec3& p = glm::vec3(0.0f), const glm::vec3& c = glm::vec3(1.0f), float i = 1.0f, float r = 8.0f):
+            position(p), color(c), intensity(i), radius(r) {};
+    };
+
+    /*! \class LightClusters
+    * \brief Classe de répartition des lumières en clusters
+    *
+    *  Le champ de vision est découpé en GRID_X * GRID_Y tuiles et GRID_Z tranches de profondeur
+    *  (exponentielles). Chaque image, chaque lumière est ajoutée aux clusters que sa sphère peut toucher,
+    *  puis les lumières, la grille (début et nombre) et les listes d'indices sont envoyées dans trois
+    *  textures buffer, de taille fixe (aucune allocation pendant l'image).
+    */
+    class LightClusters {
+
+        public:
+            static const int GRID_X = 16; /*!< Tuiles en largeur*/
+            static const int GRID_Y = 16; /*!< Tuiles en hauteur*/
+            static const int GRID_Z = 24; /*!< Tranches de profondeur*/
+            static const int MAX_LIGHTS = 1024; /*!< Lumières prises en compte*/
+            static const int MAX_LIGHT_INDICES = 1 << 18; /*!< Références de lumières, tous clusters confondus*/
+            static const GLuint FIRST_TEXTURE_UNIT = 1; /*!< Unités de texture des trois textures buffer*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe LightClusters : alloue les textures buffer (contexte OpenGL requis)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            LightClusters();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe LightClusters : libère les buffers et les textures
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~LightClusters();
+
+            /*!
+            *  \brief Répartition
+            *
+            *  Répartit les lumières dans les clusters de la caméra et envoie le résultat au GPU
+            *
+            *  \param lights : lumières ponctuelles (les MAX_LIGHTS premières sont prises en compte)
+            *  \param view : matrice View
+            *  \param projection : matrice Projection (perspective)
+            */
+            void update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+            /*!
+            *  \brief Liaison
+            *
+            *  Attache les trois textures buffer aux unités FIRST_TEXTURE_UNIT et suivantes
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void bind() const;
+            /*!
+            *  \brief Paramètres de l'image
+            *
+            *  Ecrit la taille de la grille et les paramètres des tranches dans les données de l'image
+            *
+            *  \param frame : données de l'image
+            */
+            void fillFrameData(FrameData& frame) const;
+            /*!
+            *  \brief Liaison des samplers
+            *
+            *  Relie les samplers uLightData, uClusterRanges et uLightIndices du programme courant à leurs unités
+            *
+            *  \param program : identifiant du programme (en cours d'utilisation)
+            */
+            static void bindSamplers(GLuint program);
+
+            // Getter
+            /*!
+            *  \brief Nombre de lumières
+            *
+            *  Renvoit le nombre de lumières réparties par le dernier update
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getLightCount() const{
+                return m_lightCount;
+            };
+            /*!
+            *  \brief Nombre de références
+            *
+            *  Renvoit le nombre de références de lumières dans les clusters (dernier update)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getIndexCount() const{
+                return m_indices.size();
+            };
+
+        private:
+            LightClusters(const LightClusters&);
+            LightClusters& operator=(const LightClusters&);
+
+            int sliceOf(float depth) const;
+
+            // Attributes
+            GLuint m_buffers[3]; /*!< Lumières, grille, indices*/
+            GLuint m_textures[3]; /*!< Textures buffer associées*/
+            float m_near; /*!< Plan proche de la dernière projection*/
+            float m_far; /*!< Plan lointain de la dernière projection*/
+            float m_sliceScale; /*!< GRID_Z / log(far / near)*/
+            size_t m_lightCount; /*!< Lumières réparties*/
+            std::vector<glm::vec4> m_lightData; /*!< Deux texels par lumière : position View + rayon, couleur * intensité*/
+            std::vector<GLuint> m_grid; /*!< Début et nombre de références de chaque cluster*/
+            std::vector<GLushort> m_indices; /*!< Références de lumières, rangées par cluster*/
+            std::vector<glm::ivec3> m_ranges; /*!< Premier et dernier cluster de chaque lumière (deux par lumière)*/
+    };
+
+}
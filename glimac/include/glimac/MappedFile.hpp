@@ -0,0 +1,100 @@
+/**
+ * \file MappedFile.hpp
+ * \brief Fichier projeté en mémoire
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Lecture d'un fichier entier sans copie, par projection en mémoire
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "FilePath.hpp"
+#include <stdint.h>
+
+namespace glimac {
+
+    /*! \class MappedFile
+    * \brief Classe de fichier projeté en mémoire (lecture seule)
+    *
+    *  Le contenu est projeté par mmap : les pages sont lues à la demande par le système, sans copie
+    *  dans un tampon. Sous Windows le fichier est simplement lu en mémoire.
+    */
+    class MappedFile {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe MappedFile : aucun fichier ouvert
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            MappedFile();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe MappedFile : libère la projection
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~MappedFile();
+
+            /*!
+            *  \brief Ouverture
+            *
+            *  Projette un fichier (le précédent est fermé), renvoit false s'il est absent ou vide
+            *
+            *  \param filepath : chemin du fichier
+            */
+            bool open(const FilePath& filepath);
+            /*!
+            *  \brief Fermeture
+            *
+            *  Libère la projection
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void close();
+
+            // Getters
+            /*!
+            *  \brief Renvoit le contenu
+            *
+            *  Renvoit le début du fichier (nul si aucun fichier ouvert)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const unsigned char* getData() const{
+                return m_data;
+            };
+            /*!
+            *  \brief Renvoit la taille
+            *
+            *  Renvoit la taille du fichier en octets
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getSize() const{
+                return m_size;
+            };
+
+        private:
+            MappedFile(const MappedFile&);
+            MappedFile& operator=(const MappedFile&);
+
+            // Attributes
+            const unsigned char* m_data; /*!< Contenu projeté*/
+            size_t m_size; /*!< Taille en octets*/
+#ifdef _WIN32
+            std::vector<unsigned char> m_buffer; /*!< Contenu lu (sans mmap)*/
+#endif
+    };
+
+    // Size and modification time of a file, stored by the caches to notice a changed source
+    bool getFileStamp(const FilePath& filepath, uint64_t& size, int64_t& time);
+
+}
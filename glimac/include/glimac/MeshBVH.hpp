@@ -0,0 +1,201 @@
+/**
+ * \file MeshBVH.hpp
+ * \brief Hiérarchie de volumes englobants des maillages
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * BVH des triangles d'un maillage importé (heuristique des surfaces, SAH), pour la sélection à la
+ * souris et les tests de collision ; uniquement sur le CPU
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+
+namespace glimac {
+
+    /*! \struct BVHNode
+    * \brief Noeud de la BVH
+    *
+    *  Boîte englobante et contenu, 32 octets : les noeuds sont écrits tels quels dans le cache des maillages
+    */
+    struct BVHNode {
+        glm::vec3 boundsMin; /*!< Coin minimal de la boîte*/
+        uint32_t first; /*!< Noeud interne : enfant gauche (le droit suit), feuille : premier triangle de la liste*/
+        glm::vec3 boundsMax; /*!< Coin maximal de la boîte*/
+        uint32_t count; /*!< Triangles de la feuille, 0 pour un noeud interne*/
+    };
+
+    /*! \struct MeshRayHit
+    * \brief Triangle touché par un rayon
+    */
+    struct MeshRayHit {
+        uint32_t triangle; /*!< Triangle touché (indices 3*triangle à 3*triangle+2)*/
+        float distance; /*!< Paramètre du point d'impact (en longueurs de la direction)*/
+        glm::vec3 normal; /*!< Normale géométrique du triangle, du côté de l'origine du rayon*/
+    };
+
+    /*! \class MeshBVH
+    * \brief Classe de BVH d'un maillage
+    *
+    *  Les triangles sont répartis récursivement par la SAH évaluée sur BIN_COUNT intervalles de leurs
+    *  centres. Les noeuds sont rangés dans un tableau (les deux enfants côte à côte) et les feuilles
+    *  désignent un intervalle d'une liste de triangles, l'ordre des indices du maillage n'est donc pas
+    *  modifié. Les premiers niveaux sont découpés sur ce thread, les sous-arbres construits en parallèle.
+    *  La BVH construite peut aussi être rattachée à des tableaux déjà en mémoire (cache des maillages).
+    */
+    class MeshBVH {
+
+        public:
+            static const int BIN_COUNT = 12; /*!< Intervalles évalués par axe*/
+            static const uint32_t MAX_LEAF_SIZE = 16; /*!< Triangles au-delà desquels une feuille est toujours découpée*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe MeshBVH : BVH vide
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            MeshBVH();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe MeshBVH
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~MeshBVH(){};
+
+            /*!
+            *  \brief Construction
+            *
+            *  Construit la BVH d'un maillage (les sommets et les indices doivent rester valides)
+            *
+            *  \param vertices : sommets
+            *  \param indices : triangles, trois indices chacun
+            *  \param triangleCount : nombre de triangles
+            *  \param pool : threads pour les sous-arbres (optionnel)
+            */
+            void build(const ShapeVertex* vertices, const uint32_t* indices, uint32_t triangleCount, ThreadPool* pool = nullptr);
+            /*!
+            *  \brief Rattachement
+            *
+            *  Utilise une BVH déjà construite, sans copie (tous les tableaux doivent rester valides)
+            *
+            *  \param vertices : sommets
+            *  \param indices : triangles, trois indices chacun
+            *  \param nodes : noeuds
+            *  \param nodeCount : nombre de noeuds
+            *  \param triangles : liste des triangles des feuilles
+            *  \param triangleCount : nombre de triangles
+            */
+            void attach(const ShapeVertex* vertices, const uint32_t* indices, const BVHNode* nodes, uint32_t nodeCount, const uint32_t* triangles, uint32_t triangleCount);
+            /*!
+            *  \brief Validation
+            *
+            *  Vérifie que les noeuds et la liste de triangles sont cohérents (données lues d'un fichier)
+            *
+            *  \param vertexCount : nombre de sommets du maillage
+            */
+            bool isValid(uint32_t vertexCount) const;
+
+            /*!
+            *  \brief Lancer de rayon
+            *
+            *  Cherche le triangle le plus proche touché par le rayon (espace du maillage, les deux faces)
+            *
+            *  \param origin : origine du rayon
+            *  \param direction : direction du rayon (non normalisée : les distances sont en longueurs de direction)
+            *  \param maxDistance : distance maximale
+            *  \param hit : résultat si un triangle est touché
+            */
+            bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, MeshRayHit& hit) const;
+            /*!
+            *  \brief Recherche dans une boîte
+            *
+            *  Ajoute les triangles qui touchent la boîte (test exact) à la liste, renvoit leur nombre
+            *
+            *  \param boxMin : coin minimal de la boîte
+            *  \param boxMax : coin maximal de la boîte
+            *  \param triangles : triangles trouvés (ajoutés à la fin)
+            */
+            size_t queryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& triangles) const;
+
+            // Getters
+            /*!
+            *  \brief Renvoit les noeuds
+            *
+            *  Renvoit les noeuds, la racine en premier
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const BVHNode* getNodes() const{
+                return m_nodes;
+            };
+            /*!
+            *  \brief Renvoit le nombre de noeuds
+            *
+            *  Renvoit le nombre de noeuds (0 pour un maillage vide)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            uint32_t getNodeCount() const{
+                return m_nodeCount;
+            };
+            /*!
+            *  \brief Renvoit la liste des triangles
+            *
+            *  Renvoit les triangles dans l'ordre des feuilles
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const uint32_t* getTriangles() const{
+                return m_triangles;
+            };
+            /*!
+            *  \brief Renvoit le nombre de triangles
+            *
+            *  Renvoit le nombre de triangles
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            uint32_t getTriangleCount() const{
+                return m_triangleCount;
+            };
+            /*!
+            *  \brief Renvoit le nombre de sous-arbres
+            *
+            *  Renvoit le nombre de sous-arbres construits sur les threads à la dernière construction (0 sans threads
+            *  ou pour un petit maillage)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            uint32_t getSubtreeCount() const{
+                return m_subtreeCount;
+            };
+
+        private:
+            MeshBVH(const MeshBVH&);
+            MeshBVH& operator=(const MeshBVH&);
+
+            // Attributes
+            const ShapeVertex* m_vertices; /*!< Sommets du maillage*/
+            const uint32_t* m_indices; /*!< Indices du maillage*/
+            const BVHNode* m_nodes; /*!< Noeuds (m_builtNodes ou cache)*/
+            const uint32_t* m_triangles; /*!< Triangles des feuilles (m_builtTriangles ou cache)*/
+            uint32_t m_nodeCount; /*!< Nombre de noeuds*/
+            uint32_t m_triangleCount; /*!< Nombre de triangles*/
+            uint32_t m_subtreeCount; /*!< Sous-arbres construits sur les threads*/
+            std::vector<BVHNode> m_builtNodes; /*!< Noeuds construits*/
+            std::vector<uint32_t> m_builtTriangles; /*!< Triangles des feuilles construits*/
+    };
+
+    // Separating axis test (Akenine-Möller) between a triangle and an axis aligned box
+    bool triangleOverlapsBox(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+}
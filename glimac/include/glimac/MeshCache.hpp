@@ -0,0 +1,160 @@
+/**
+ * \file MeshCache.hpp
+ * \brief Maillages importés mis en cache
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Format binaire des objets 3D importés, relu par projection en mémoire et envoyé au GPU en un bloc
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "FilePath.hpp"
+#include "MappedFile.hpp"
+#include "MeshBVH.hpp"
+#include "ObjMesh.hpp"
+
+namespace glimac {
+
+    /*! \class BakedMesh
+    * \brief Classe de maillage préparé
+    *
+    *  Au premier import l'OBJ est lu (loadObjMesh) puis écrit à côté de la source (même nom, extension
+    *  .wmesh) : un en-tête avec la taille et la date de la source, les sommets entrelacés, les
+    *  indices, puis la BVH des triangles (noeuds et liste des feuilles). Aux lancements suivants le
+    *  fichier est projeté en mémoire ; sommets et indices se suivent, un seul glBufferData les envoie
+    *  dans un buffer qui sert à la fois de VBO et d'IBO, et la BVH est utilisée sans être reconstruite.
+    */
+    class BakedMesh {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe BakedMesh : aucune donnée
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            BakedMesh();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe BakedMesh
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~BakedMesh(){};
+
+            /*!
+            *  \brief Chargement
+            *
+            *  Ouvre le cache d'un OBJ s'il est à jour, sinon l'importe et écrit le cache (nul si l'import échoue)
+            *
+            *  \param source : fichier OBJ
+            *  \param flipV : inverser la coordonnée V (textures DDS)
+            *  \param pool : threads pour l'import et la BVH (optionnel)
+            */
+            static std::unique_ptr<BakedMesh> load(const FilePath& source, bool flipV, ThreadPool* pool = nullptr);
+            /*!
+            *  \brief Envoi au GPU
+            *
+            *  Envoie sommets et indices en un seul buffer et crée le VAO (attributs 0 à 2 de ShapeVertex)
+            *
+            *  \param vao : VAO créé
+            *  \param buffer : buffer créé (sommets puis indices, à getIndexOffset)
+            */
+            void upload(GLuint& vao, GLuint& buffer) const;
+
+            // Getters
+            /*!
+            *  \brief Renvoit le nombre de sommets
+            *
+            *  Renvoit le nombre de sommets
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            uint32_t getVertexCount() const{
+                return m_vertexCount;
+            };
+            /*!
+            *  \brief Renvoit le nombre d'indices
+            *
+            *  Renvoit le nombre d'indices (trois par triangle)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            uint32_t getIndexCount() const{
+                return m_indexCount;
+            };
+            /*!
+            *  \brief Position des indices
+            *
+            *  Renvoit la position des indices dans le buffer, en octets (pour glDrawElements)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getIndexOffset() const{
+                return m_vertexCount*sizeof(ShapeVertex);
+            };
+            /*!
+            *  \brief Renvoit les sommets
+            *
+            *  Renvoit les sommets (valides tant que l'objet existe)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const ShapeVertex* getVertices() const{
+                return (const ShapeVertex*)m_data;
+            };
+            /*!
+            *  \brief Renvoit les indices
+            *
+            *  Renvoit les indices (valides tant que l'objet existe)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const uint32_t* getIndices() const{
+                return (const uint32_t*)(m_data + getIndexOffset());
+            };
+            /*!
+            *  \brief Renvoit la BVH
+            *
+            *  Renvoit la BVH des triangles (espace du maillage), pour les lancers de rayon et les collisions
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            const MeshBVH& getBVH() const{
+                return m_bvh;
+            };
+            /*!
+            *  \brief Provenance
+            *
+            *  Renvoit true si le maillage vient du cache, false s'il vient d'être importé
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isFromCache() const{
+                return m_fromCache;
+            };
+
+        private:
+            BakedMesh(const BakedMesh&);
+            BakedMesh& operator=(const BakedMesh&);
+
+            bool open(const FilePath& cacheFile, const FilePath& source, bool flipV);
+            bool bake(const FilePath& source, const FilePath& cacheFile, bool flipV, ThreadPool* pool);
+
+            // Attributes
+            MappedFile m_file; /*!< Fichier du cache projeté*/
+            std::vector<unsigned char> m_baked; /*!< Données importées, si elles ne viennent pas du cache*/
+            const unsigned char* m_data; /*!< Sommets puis indices*/
+            uint32_t m_vertexCount; /*!< Nombre de sommets*/
+            uint32_t m_indexCount; /*!< Nombre d'indices*/
+            MeshBVH m_bvh; /*!< BVH des triangles*/
+            bool m_fromCache; /*!< Lu depuis le cache*/
+    };
+
+}
@@ -0,0 +1,28 @@
+/**
+ * \file MeshOptimizer.hpp
+ * \brief Optimisation des maillages indexés
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Ordre des triangles et des sommets pour les caches de sommets du GPU
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "ObjMesh.hpp"
+
+namespace glimac {
+
+    // Reorder the triangles so that consecutive ones share vertices still in the post-transform cache
+    // (Forsyth, "Linear-Speed Vertex Cache Optimisation"), the indices keep their values
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    // Renumber the vertices in order of first use by the indices, for sequential vertex fetch
+    void optimizeVertexFetch(IndexedMesh& mesh);
+
+    // Average vertices transformed per triangle with a FIFO cache (between 0.5 and 3, lower is better)
+    float computeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = 16);
+
+}
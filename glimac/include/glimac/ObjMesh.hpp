@@ -0,0 +1,37 @@
+/**
+ * \file ObjMesh.hpp
+ * \brief Import rapide des objets 3D
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Lecture des fichiers OBJ projetés en mémoire, découpés en morceaux lus en parallèle, vers un
+ * maillage indexé
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "FilePath.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+
+namespace glimac {
+
+    /*! \struct IndexedMesh
+    * \brief Maillage indexé
+    *
+    *  Sommets uniques (position, normale, coordonnées de texture) et triangles, trois indices chacun
+    */
+    struct IndexedMesh {
+        std::vector<ShapeVertex> vertices; /*!< Sommets*/
+        std::vector<uint32_t> indices; /*!< Triangles*/
+    };
+
+    // Read an OBJ file : v, vt, vn and faces of any size (v, v/vt, v//vn, v/vt/vn, negative indices),
+    // polygons become fans of triangles and missing normals are smoothed from the faces.
+    // Identical corners share one vertex, triangles and vertices are then ordered for the GPU caches (see MeshOptimizer).
+    // The file is split at line boundaries and parsed on the pool (or on this thread without one).
+    bool loadObjMesh(const FilePath& filepath, IndexedMesh& mesh, ThreadPool* pool = nullptr);
+
+}
@@ -0,0 +1,146 @@
+/**
+ * \file OcclusionCuller.hpp
+ * \brief Elimination des objets cachés sur le CPU
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Tampon de profondeur basse résolution rempli par quelques grands pavés occultants, pyramide Hi-Z
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+
+namespace glimac {
+
+    /*! \class OcclusionCuller
+    * \brief Classe d'élimination des boîtes cachées
+    *
+    *  A chaque image : les pavés occultants sont rastérisés (SSE si disponible) dans un petit tampon
+    *  de profondeur, puis une pyramide Hi-Z (profondeur maximale de chaque bloc 2x2) est construite.
+    *  Une boîte est cachée si elle est entièrement derrière la profondeur stockée sur toute son
+    *  emprise à l'écran. Tout se fait sur le CPU, sans requête au GPU.
+    */
+    class OcclusionCuller {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe OcclusionCuller (dimensions arrondies à une puissance de 2, au moins 4)
+            *
+            *  \param width : largeur du tampon de profondeur
+            *  \param height : hauteur du tampon de profondeur
+            */
+            OcclusionCuller(int width = 128, int height = 128);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe OcclusionCuller
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~OcclusionCuller(){};
+
+            /*!
+            *  \brief Début d'image
+            *
+            *  Vide le tampon de profondeur et retient la matrice de projection de l'image
+            *
+            *  \param viewProjection : matrice Projection * View
+            */
+            void beginFrame(const glm::mat4& viewProjection);
+            /*!
+            *  \brief Ajout d'un occultant
+            *
+            *  Rastérise un pavé plein (espace monde) dans le tampon de profondeur : seuls les texels
+            *  entièrement couverts sont écrits, avec la profondeur la plus lointaine du pavé sur le texel
+            *
+            *  \param boxMin : coin minimal
+            *  \param boxMax : coin maximal
+            */
+            void addOccluder(const glm::vec3& boxMin, const glm::vec3& boxMax);
+            /*!
+            *  \brief Construction de la pyramide
+            *
+            *  Construit la pyramide Hi-Z, à appeler après le dernier occultant et avant les tests
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void buildPyramid();
+            /*!
+            *  \brief Test de visibilité
+            *
+            *  Renvoit faux si la boîte est hors du champ de vision ou cachée par les occultants
+            *
+            *  \param boxMin : coin minimal
+            *  \param boxMax : coin maximal
+            */
+            bool isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+            /*!
+            *  \brief Test du champ de vision
+            *
+            *  Renvoit faux si la boîte est entièrement hors du champ de vision
+            *
+            *  \param boxMin : coin minimal
+            *  \param boxMax : coin maximal
+            */
+            bool isInFrustum(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+            // Getter
+            /*!
+            *  \brief Renvoit la largeur
+            *
+            *  Renvoit la largeur du tampon de profondeur
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getWidth() const{
+                return m_width;
+            };
+            /*!
+            *  \brief Renvoit la hauteur
+            *
+            *  Renvoit la hauteur du tampon de profondeur
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getHeight() const{
+                return m_height;
+            };
+            /*!
+            *  \brief Lecture de la profondeur
+            *
+            *  Renvoit la profondeur (0 proche, 1 lointain) d'un texel d'un niveau de la pyramide
+            *
+            *  \param level : niveau (0 = pleine résolution)
+            *  \param x : colonne
+            *  \param y : ligne
+            */
+            float getDepth(int level, int x, int y) const;
+            /*!
+            *  \brief Nombre d'occultants
+            *
+            *  Renvoit le nombre de pavés rastérisés depuis beginFrame
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getOccluderCount() const{
+                return m_occluderCount;
+            };
+
+        private:
+            void rasterizeBox(const glm::vec3 screen[8]);
+            void project(const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec4 clip[8]) const;
+
+            // Attributes
+            int m_width; /*!< Largeur du niveau 0*/
+            int m_height; /*!< Hauteur du niveau 0*/
+            std::vector<std::vector<float> > m_levels; /*!< Pyramide Hi-Z, le niveau 0 est le tampon rastérisé*/
+            glm::mat4 m_viewProjection; /*!< Matrice Projection * View de l'image*/
+            int m_occluderCount; /*!< Nombre de pavés rastérisés*/
+    };
+
+}
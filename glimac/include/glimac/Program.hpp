@@ -26,12 +26,13 @@ public:
 		glDeleteProgram(m_nGLId);
 	}
 
-	Program(Program&& rvalue): m_nGLId(rvalue.m_nGLId) {
+	Program(Program&& rvalue): m_nGLId(rvalue.m_nGLId), m_uniforms(std::move(rvalue.m_uniforms)) {
 		rvalue.m_nGLId = 0;
 	}
 
 	Program& operator =(Program&& rvalue) {
 		m_nGLId = rvalue.m_nGLId;
+		m_uniforms = std::move(rvalue.m_uniforms);
 		rvalue.m_nGLId = 0;
 		return *this;
 	}
@@ -46,6 +47,18 @@ public:
 
 	bool link();
 
+	// Link from a binary returned by getBinary (same driver only), false if the driver rejects it
+	bool loadBinary(GLenum format, const std::vector<char>& binary);
+
+	// Binary of the linked program, false if the driver cannot provide one
+	bool getBinary(GLenum& format, std::vector<char>& binary) const;
+
+	// Location of an active uniform (-1 if absent), looked up in the table filled at link time
+	GLint getUniformLocation(const std::string& name) const {
+		auto it = m_uniforms.find(name);
+		return (it == m_uniforms.end()) ? -1 : it->second;
+	}
+
 	const std::string getInfoLog() const;
 
 	void use() const {
@@ -56,7 +69,11 @@ private:
 	Program(const Program&);
 	Program& operator =(const Program&);
 
+	// Once linked : blocks bound, active uniforms reflected
+	void linked();
+
 	GLuint m_nGLId;
+	std::unordered_map<std::string, GLint> m_uniforms;
 };
 
 // Build a GLSL program from source code
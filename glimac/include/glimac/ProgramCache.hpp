@@ -0,0 +1,89 @@
+/**
+ * \file ProgramCache.hpp
+ * \brief Cache des programmes compilés
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Sauvegarde des programmes liés par le pilote, pour ne plus compiler les shaders à chaque lancement
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "Program.hpp"
+
+namespace glimac {
+
+    /*! \class ProgramCache
+    * \brief Classe de cache des binaires de programmes
+    *
+    *  Chaque paire de shaders a un fichier dans le dossier du cache : le binaire du programme
+    *  (glGetProgramBinary) précédé d'une empreinte des sources et du pilote. Au lancement suivant, le
+    *  binaire est rechargé tel quel si l'empreinte correspond ; sinon (shader modifié, autre pilote,
+    *  binaire refusé) le programme est compilé puis le fichier réécrit. Sans OpenGL 4.1 ni
+    *  ARB_get_program_binary, les programmes sont simplement compilés.
+    */
+    class ProgramCache {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe ProgramCache (contexte OpenGL requis)
+            *
+            *  \param directory : dossier existant où ranger les binaires
+            */
+            ProgramCache(const FilePath& directory);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe ProgramCache
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~ProgramCache(){};
+
+            /*!
+            *  \brief Chargement
+            *
+            *  Renvoit le programme des deux shaders, depuis le cache si possible (exception si la compilation échoue)
+            *
+            *  \param vsFile : fichier du vertex shader
+            *  \param fsFile : fichier du fragment shader
+            */
+            Program load(const FilePath& vsFile, const FilePath& fsFile);
+
+            // Getters
+            /*!
+            *  \brief Programmes du cache
+            *
+            *  Renvoit le nombre de programmes rechargés depuis le cache
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getHitCount() const{
+                return m_hits;
+            };
+            /*!
+            *  \brief Programmes compilés
+            *
+            *  Renvoit le nombre de programmes compilés depuis les sources
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getMissCount() const{
+                return m_misses;
+            };
+
+        private:
+            // Attributes
+            FilePath m_directory; /*!< Dossier des binaires*/
+            bool m_supported; /*!< Le pilote sait lire et écrire des binaires*/
+            std::string m_driver; /*!< Vendeur, carte et version du pilote (dans l'empreinte)*/
+            int m_hits; /*!< Programmes rechargés*/
+            int m_misses; /*!< Programmes compilés*/
+    };
+
+}
@@ -0,0 +1,250 @@
+/**
+ * \file PropList.hpp
+ * \brief Objets 3D posés dans la scène
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Décors de la scène : des maillages importés, référencés par leur identifiant et dessinés par instances
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "MeshCache.hpp"
+
+namespace glimac {
+
+    /*! \struct Prop
+    * \brief Objet posé
+    *
+    *  Instance d'un maillage de la PropList : position, rotation autour de l'axe Y et échelle
+    */
+    struct Prop {
+        int meshId; /*!< Identifiant du maillage (ordre d'ajout dans la PropList)*/
+        glm::vec3 position; /*!< Position (espace monde)*/
+        float rotation; /*!< Rotation autour de Y, en degrés*/
+        float scale; /*!< Echelle*/
+
+        Prop(int id = 0, const glm::vec3& p = glm::vec3(0.0f), float r = 0.0f, float s = 1.0f):
+            meshId(id), position(p), rotation(r), scale(s) {};
+
+        // Model matrix : scaled, then turned, then moved
+        glm::mat4 getModelMatrix() const{
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+            model = glm::rotate(model, glm::radians(rotation), glm::vec3(0.0f, 1.0f, 0.0f));
+            return glm::scale(model, glm::vec3(scale));
+        };
+    };
+
+    /*! \struct PropRayHit
+    * \brief Objet touché par un rayon
+    */
+    struct PropRayHit {
+        int prop; /*!< Index de l'objet touché*/
+        uint32_t triangle; /*!< Triangle touché dans son maillage*/
+        float distance; /*!< Distance entre l'origine et le point d'impact*/
+        glm::vec3 normal; /*!< Normale du triangle touché (espace monde), du côté de l'origine du rayon*/
+    };
+
+    /*! \class PropList
+    * \brief Classe de liste d'objets posés
+    *
+    *  Chaque maillage est envoyé une fois au GPU (BakedMesh::upload). Les matrices Model de ses
+    *  instances sont rangées dans un buffer propre au maillage (attributs INSTANCE_ATTRIBUTE à +3,
+    *  un par instance), renvoyé seulement après une modification : tous les objets d'un même
+    *  maillage sont dessinés par un seul glDrawElementsInstanced. Les rayons et les boîtes sont
+    *  ramenés dans l'espace de chaque maillage pour y parcourir sa BVH.
+    */
+    class PropList {
+
+        public:
+            static const GLuint INSTANCE_ATTRIBUTE = 5; /*!< Première colonne de la matrice Model d'instance (mat4 : 4 attributs)*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe PropList : aucun maillage
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            PropList();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe PropList : libère les VAO et les buffers
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~PropList();
+
+            /*!
+            *  \brief Ajout d'un maillage
+            *
+            *  Envoie un maillage au GPU et renvoit son identifiant (contexte OpenGL requis)
+            *
+            *  \param mesh : maillage chargé
+            *  \param texture : texture du maillage (non libérée par la PropList)
+            */
+            int addMesh(std::unique_ptr<BakedMesh> mesh, GLuint texture);
+            /*!
+            *  \brief Ajout d'un objet
+            *
+            *  Ajoute un objet et renvoit son index (-1 si son maillage n'existe pas)
+            *
+            *  \param prop : objet à poser
+            */
+            int addProp(const Prop& prop);
+            /*!
+            *  \brief Modification d'un objet
+            *
+            *  Remplace un objet (ignoré si le maillage n'existe pas)
+            *
+            *  \param index : index de l'objet
+            *  \param prop : nouvel objet
+            */
+            void setProp(int index, const Prop& prop);
+            /*!
+            *  \brief Suppression d'un objet
+            *
+            *  Supprime un objet, les suivants sont décalés
+            *
+            *  \param index : index de l'objet
+            */
+            void deleteProp(int index);
+            /*!
+            *  \brief Suppression des objets
+            *
+            *  Supprime tous les objets (les maillages restent chargés)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void clear();
+
+            /*!
+            *  \brief Dessin
+            *
+            *  Renvoie les instances modifiées puis dessine chaque maillage en une fois, texture sur l'unité 0
+            *  (uniform uInstanced du shader à activer avant)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void draw();
+
+            /*!
+            *  \brief Lancer de rayon
+            *
+            *  Cherche le triangle d'objet le plus proche touché par le rayon (sélection à la souris)
+            *
+            *  \param origin : origine du rayon (espace monde)
+            *  \param direction : direction du rayon
+            *  \param maxDistance : distance maximale
+            *  \param hit : résultat si un objet est touché
+            */
+            bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, PropRayHit& hit) const;
+            /*!
+            *  \brief Recherche dans une boîte
+            *
+            *  Renvoit le premier objet dont un triangle touche la boîte (-1 si aucun)
+            *
+            *  \param boxMin : coin minimal de la boîte (espace monde)
+            *  \param boxMax : coin maximal de la boîte (espace monde)
+            */
+            int findInBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+            /*!
+            *  \brief Sauvegarde
+            *
+            *  Ecrit une ligne par objet : identifiant du maillage, position, rotation, échelle
+            *
+            *  \param filepath : chemin de sauvegarde
+            */
+            bool save(const std::string& filepath) const;
+            /*!
+            *  \brief Chargement
+            *
+            *  Remplace les objets par ceux du fichier (aucun si le fichier n'existe pas)
+            *
+            *  \param filepath : chemin d'accès
+            */
+            bool load(const std::string& filepath);
+
+            // Getters
+            /*!
+            *  \brief Renvoit le nombre d'objets
+            *
+            *  Renvoit le nombre d'objets posés
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getSize() const{
+                return m_props.size();
+            };
+            /*!
+            *  \brief Renvoit un objet
+            *
+            *  Renvoit un objet posé
+            *
+            *  \param index : index de l'objet
+            */
+            const Prop& getProp(int index) const{
+                return m_props[index];
+            };
+            /*!
+            *  \brief Renvoit le nombre de maillages
+            *
+            *  Renvoit le nombre de maillages ajoutés (identifiants 0 à getMeshCount()-1)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getMeshCount() const{
+                return m_meshes.size();
+            };
+            /*!
+            *  \brief Renvoit un maillage
+            *
+            *  Renvoit le maillage d'un identifiant
+            *
+            *  \param meshId : identifiant du maillage
+            */
+            const BakedMesh& getMesh(int meshId) const{
+                return *m_meshes[meshId].mesh;
+            };
+            /*!
+            *  \brief Renvoit le nombre d'appels de dessin
+            *
+            *  Renvoit le nombre de glDrawElementsInstanced du dernier dessin
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getDrawCallCount() const{
+                return m_drawCallCount;
+            };
+
+        private:
+            PropList(const PropList&);
+            PropList& operator=(const PropList&);
+
+            /*! \struct MeshSlot
+            * \brief Maillage envoyé au GPU et ses instances
+            */
+            struct MeshSlot {
+                std::unique_ptr<BakedMesh> mesh; /*!< Maillage*/
+                GLuint texture; /*!< Texture du maillage*/
+                GLuint vao; /*!< VAO (sommets, indices et instances)*/
+                GLuint buffer; /*!< Sommets puis indices*/
+                GLuint instanceBuffer; /*!< Matrices Model des instances*/
+                GLsizei instanceCount; /*!< Instances dans instanceBuffer*/
+            };
+
+            void uploadInstances();
+
+            // Attributes
+            std::vector<MeshSlot> m_meshes; /*!< Maillages, par identifiant*/
+            std::vector<Prop> m_props; /*!< Objets posés*/
+            bool m_dirty; /*!< Instances à renvoyer*/
+            int m_drawCallCount; /*!< Appels de dessin du dernier draw*/
+    };
+
+}
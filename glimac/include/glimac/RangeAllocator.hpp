@@ -0,0 +1,106 @@
+/**
+ * \file RangeAllocator.hpp
+ * \brief Sous-allocation de plages dans un buffer
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Allocation de plages contiguës (en éléments) dans un grand buffer, sans appel OpenGL
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include <map>
+
+namespace glimac {
+
+    /*! \class RangeAllocator
+    * \brief Classe de sous-allocation de plages
+    *
+    *  Les plages libres sont rangées par position et par taille : l'allocation prend la plus petite
+    *  plage assez grande (en O(log n)), la libération fusionne la plage avec ses voisines libres.
+    */
+    class RangeAllocator {
+
+        public:
+            static const GLuint INVALID = 0xFFFFFFFFu; /*!< Résultat d'une allocation impossible*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe RangeAllocator : toute la capacité est libre
+            *
+            *  \param capacity : nombre d'éléments gérés
+            */
+            RangeAllocator(GLuint capacity = 0);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe RangeAllocator
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~RangeAllocator(){};
+
+            /*!
+            *  \brief Allocation
+            *
+            *  Renvoit le début d'une plage libre de size éléments (INVALID si aucune ne convient)
+            *
+            *  \param size : nombre d'éléments
+            */
+            GLuint allocate(GLuint size);
+            /*!
+            *  \brief Libération
+            *
+            *  Rend une plage obtenue par allocate
+            *
+            *  \param offset : début de la plage
+            *  \param size : nombre d'éléments
+            */
+            void release(GLuint offset, GLuint size);
+            /*!
+            *  \brief Agrandissement
+            *
+            *  Ajoute des éléments libres à la fin (le contenu déjà alloué ne bouge pas)
+            *
+            *  \param capacity : nouvelle capacité (plus grande que l'actuelle)
+            */
+            void grow(GLuint capacity);
+
+            // Getter
+            /*!
+            *  \brief Renvoit la capacité
+            *
+            *  Renvoit le nombre d'éléments gérés
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint getCapacity() const{
+                return m_capacity;
+            };
+            /*!
+            *  \brief Renvoit l'espace utilisé
+            *
+            *  Renvoit le nombre d'éléments alloués
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint getUsed() const{
+                return m_used;
+            };
+
+        private:
+            void insertFree(GLuint offset, GLuint size);
+            void eraseFree(std::map<GLuint, GLuint>::iterator it);
+
+            // Attributes
+            std::map<GLuint, GLuint> m_free; /*!< Plages libres : début -> taille*/
+            std::multimap<GLuint, GLuint> m_bySize; /*!< Plages libres : taille -> début*/
+            GLuint m_capacity; /*!< Nombre d'éléments gérés*/
+            GLuint m_used; /*!< Nombre d'éléments alloués*/
+    };
+
+}
@@ -34,6 +34,9 @@ public:
 
     glm::ivec2 getMousePosition() const;
 
+    // Size of the window in pixels
+    glm::ivec2 getWindowSize() const;
+
     void swapBuffers();
 
     // Return the time in seconds
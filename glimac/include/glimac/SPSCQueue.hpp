@@ -0,0 +1,109 @@
+/**
+ * \file SPSCQueue.hpp
+ * \brief File sans verrou à un producteur et un consommateur
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Tampon circulaire de taille fixe entre deux threads : un seul thread écrit, un seul lit
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include <atomic>
+
+namespace glimac {
+
+    /*! \class SPSCQueue
+    * \brief Classe de file à un producteur et un consommateur
+    *
+    *  Les deux index ne sont écrits que par leur propriétaire (tête par le consommateur, queue par
+    *  le producteur) et lus par l'autre thread : un store release publie la case écrite, le load
+    *  acquire de l'autre côté la voit entière. Aucun verrou ni allocation après la construction.
+    *  Une case sert encore après avoir été lue : T doit pouvoir être déplacé et réaffecté.
+    */
+    template<typename T>
+    class SPSCQueue {
+
+        public:
+            // Constructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe SPSCQueue : file vide
+            *
+            *  \param capacity : nombre d'éléments en attente au maximum (arrondi à une puissance de 2)
+            */
+            SPSCQueue(size_t capacity = 64):
+                m_head(0),
+                m_tail(0) {
+                size_t size = 2;
+                while(size < capacity){
+                    size *= 2;
+                }
+                m_slots.resize(size);
+                m_mask = size - 1;
+            };
+
+            /*!
+            *  \brief Ajout
+            *
+            *  Ajoute un élément en fin de file, renvoit faux si elle est pleine (thread producteur seulement)
+            *
+            *  \param value : élément, déplacé dans la file
+            */
+            bool push(T&& value){
+                const size_t tail = m_tail.load(std::memory_order_relaxed);
+                if(tail - m_head.load(std::memory_order_acquire) == m_slots.size()){
+                    return false;
+                }
+                m_slots[tail & m_mask] = std::move(value);
+                m_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            };
+            /*!
+            *  \brief Retrait
+            *
+            *  Retire le premier élément de la file, renvoit faux si elle est vide (thread consommateur seulement)
+            *
+            *  \param value : reçoit l'élément
+            */
+            bool pop(T& value){
+                const size_t head = m_head.load(std::memory_order_relaxed);
+                if(head == m_tail.load(std::memory_order_acquire)){
+                    return false;
+                }
+                value = std::move(m_slots[head & m_mask]);
+                m_head.store(head + 1, std::memory_order_release);
+                return true;
+            };
+
+            // Getters
+            /*!
+            *  \brief File vide
+            *
+            *  Renvoit vrai si aucun élément n'attend (valeur déjà ancienne pour l'autre thread)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isEmpty() const{
+                return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+            };
+
+        private:
+            SPSCQueue(const SPSCQueue&);
+            SPSCQueue& operator=(const SPSCQueue&);
+
+            // Attributes
+            std::vector<T> m_slots; /*!< Cases du tampon circulaire*/
+            size_t m_mask; /*!< Taille du tampon - 1*/
+            // Each index on its own cache line : the two threads do not invalidate each other's writes
+            char m_padding0[64];
+            std::atomic<size_t> m_head; /*!< Prochaine case lue (écrit par le consommateur)*/
+            char m_padding1[64];
+            std::atomic<size_t> m_tail; /*!< Prochaine case écrite (écrit par le producteur)*/
+            char m_padding2[64];
+    };
+
+}
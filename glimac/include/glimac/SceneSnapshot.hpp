@@ -0,0 +1,73 @@
+/**
+ * \file SceneSnapshot.hpp
+ * \brief Copie figée d'une scène
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Contenu d'une scène (cubes, lumières, objets) échangé entre le thread de scène et le thread de rendu :
+ * lecture, écriture et génération procédurale
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "CubeList.hpp"
+#include "PropList.hpp"
+
+namespace glimac {
+
+    /*! \struct SceneLights
+    * \brief Réglages des lumières d'une scène
+    *
+    *  Les valeurs du menu des lumières, enregistrées à la fin des fichiers de scène
+    */
+    struct SceneLights {
+        int item_LightD; /*!< Lumière directionnelle on / off (0 ou 1)*/
+        std::vector<int> positionLightD; /*!< Position de la lumière directionnelle*/
+        int item_LightP; /*!< Lumière ponctuelle on / off (0 ou 1)*/
+        std::vector<int> positionLightP; /*!< Position de la lumière ponctuelle*/
+        std::vector<int> lightIntensity; /*!< Intensités (directionnelle, ponctuelle)*/
+
+        SceneLights():
+            item_LightD(0), positionLightD{1,1,1}, item_LightP(0), positionLightP{1,1,1}, lightIntensity{2,2} {};
+    };
+
+    /*! \struct SceneCube
+    * \brief Cube d'une scène
+    */
+    struct SceneCube {
+        glm::ivec3 position; /*!< Position du cube*/
+        GLuint texture; /*!< Index de texture*/
+    };
+
+    /*! \struct SceneSnapshot
+    * \brief Copie d'une scène
+    *
+    *  Remplie par un seul thread puis partagée en const (std::shared_ptr<const SceneSnapshot>) :
+    *  les threads qui la lisent ne se synchronisent pas
+    */
+    struct SceneSnapshot {
+        std::vector<SceneCube> cubes; /*!< Cubes, dans l'ordre de la liste*/
+        SceneLights lights; /*!< Réglages des lumières*/
+        bool hasLights; /*!< Faux si la scène ne change pas les lumières (génération)*/
+        std::vector<Prop> props; /*!< Objets posés*/
+        bool hasProps; /*!< Faux si la scène ne change pas les objets (génération)*/
+
+        SceneSnapshot():
+            hasLights(false), hasProps(false) {};
+
+        // Copy of a cube list (on the thread owning it), props left out without a list
+        static std::shared_ptr<SceneSnapshot> capture(const CubeList& cubeList, const SceneLights& lights, const PropList* propList = nullptr);
+    };
+
+    // Write the cubes and lights in filepath, and the props in filepath.props
+    bool writeSceneFile(const std::string& filepath, const SceneSnapshot& scene);
+
+    // Read a file written by writeSceneFile (no props when filepath.props is missing)
+    bool readSceneFile(const std::string& filepath, SceneSnapshot& scene);
+
+    // Height field interpolated between the control points (one RBF solve for the whole grid)
+    void generateScene(const Eigen::MatrixXd& controlPoints, const std::string& rbf, float epsilon, SceneSnapshot& scene);
+
+}
@@ -0,0 +1,314 @@
+/**
+ * \file SceneThread.hpp
+ * \brief Thread de scène
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Le thread de scène possède la liste de cubes : les éditions, le chargement, la sauvegarde et la
+ * génération lui sont envoyés par une file de commandes, il remaille les blocs modifiés et publie
+ * des images figées que le thread de rendu envoie au GPU
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "SceneSnapshot.hpp"
+#include "ChunkMesh.hpp"
+#include "JobSystem.hpp"
+#include "SPSCQueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace glimac {
+
+    /*! \enum SceneCommandType
+    * \brief Type de commande du thread de scène
+    */
+    enum SceneCommandType {
+        SCENE_LOAD, /*!< Lire un fichier et remplacer la scène*/
+        SCENE_SAVE, /*!< Ecrire la scène*/
+        SCENE_GENERATE, /*!< Générer une scène à partir de points de contrôle et remplacer la scène*/
+        SCENE_ADD_CUBE, /*!< Poser un cube sur une cellule*/
+        SCENE_DELETE_CUBE, /*!< Retirer le premier cube d'une cellule*/
+        SCENE_SET_TEXTURE, /*!< Changer la texture du premier cube d'une cellule*/
+        SCENE_EXTRUDE, /*!< Poser un cube au-dessus d'une cellule pleine*/
+        SCENE_DIG, /*!< Retirer le cube d'une cellule posée sur une colonne*/
+        SCENE_SET_EMISSION, /*!< Changer la lumière émise par une texture*/
+        SCENE_SET_SPARSE, /*!< Changer de stockage des voxels*/
+        SCENE_PICK /*!< Lancer le rayon de sélection de la souris*/
+    };
+
+    /*! \struct SceneCommand
+    * \brief Commande du thread de scène
+    */
+    struct SceneCommand {
+        SceneCommandType type; /*!< Type de commande*/
+        std::string path; /*!< Fichier lu ou écrit*/
+        SceneLights lights; /*!< Lumières à écrire*/
+        std::vector<Prop> props; /*!< Objets à écrire*/
+        Eigen::MatrixXd controlPoints; /*!< Points de contrôle de la génération*/
+        std::string rbf; /*!< RBF de la génération*/
+        float epsilon; /*!< Paramètre de la RBF*/
+        glm::ivec3 cell; /*!< Cellule éditée*/
+        GLuint texture; /*!< Index de texture (pose, changement de texture, émission)*/
+        int level; /*!< Niveau d'émission*/
+        bool sparse; /*!< Octree creux*/
+        glm::vec3 origin; /*!< Origine du rayon de sélection*/
+        glm::vec3 direction; /*!< Direction du rayon de sélection*/
+        bool frontCell; /*!< Sélection de la cellule devant la face touchée (clic droit)*/
+        bool propFound; /*!< Un objet est touché par le rayon*/
+        PropRayHit propHit; /*!< Objet touché (thread de rendu)*/
+
+        SceneCommand():
+            type(SCENE_SAVE), epsilon(1.0f), cell(0), texture(0), level(0), sparse(false),
+            origin(0.0f), direction(0.0f), frontCell(false), propFound(false), propHit() {};
+    };
+
+    /*! \struct SceneStatus
+    * \brief Etat de la scène au moment d'une publication
+    */
+    struct SceneStatus {
+        glm::ivec3 cursor; /*!< Cellule du curseur décrite*/
+        int cursorCube; /*!< Index du premier cube de la cellule du curseur, -1 si elle est vide*/
+        GLuint cursorTexture; /*!< Texture de ce cube*/
+        bool cubeAbove; /*!< Cellule au-dessus du curseur pleine*/
+        bool cubeUnder; /*!< Cellule au-dessous du curseur pleine*/
+        size_t cubeCount; /*!< Nombre de cubes*/
+        size_t storageMemory; /*!< Mémoire du stockage des voxels, en octets*/
+        size_t lightMemory; /*!< Mémoire de la lumière des voxels, en octets*/
+
+        SceneStatus():
+            cursor(0), cursorCube(-1), cursorTexture(0), cubeAbove(false), cubeUnder(false), cubeCount(0), storageMemory(0), lightMemory(0) {};
+    };
+
+    /*! \struct ScenePick
+    * \brief Résultat d'un rayon de sélection
+    */
+    struct ScenePick {
+        bool found; /*!< Un voxel ou un objet est touché*/
+        glm::ivec3 cell; /*!< Nouvelle cellule du curseur*/
+        int prop; /*!< Objet sélectionné (clic gauche sur un objet devant les voxels), -1 sinon*/
+
+        ScenePick():
+            found(false), cell(0), prop(-1) {};
+    };
+
+    /*! \struct SceneFrame
+    * \brief Image publiée par le thread de scène
+    *
+    *  Une image non prise par le thread de rendu est fusionnée dans la suivante : aucun maillage ni
+    *  aucune scène chargée ne se perd.
+    */
+    struct SceneFrame {
+        ChunkMeshUpdates meshes; /*!< Maillages des blocs reconstruits depuis l'image précédente prise*/
+        std::vector<std::shared_ptr<const SceneSnapshot> > scenes; /*!< Scènes lues ou générées, dans l'ordre : lumières et objets à appliquer (sans cubes)*/
+        bool picked; /*!< Un rayon de sélection a été lancé*/
+        ScenePick pick; /*!< Résultat du dernier rayon*/
+        SceneStatus status; /*!< Etat de la scène*/
+
+        SceneFrame():
+            picked(false) {};
+    };
+
+    /*! \class SceneThread
+    * \brief Classe de thread de scène
+    *
+    *  Le thread de rendu (seul producteur) ajoute les commandes à une SPSCQueue, le thread de scène
+    *  (seul consommateur) les exécute dans l'ordre sur sa CubeList : un chargement suivi d'éditions
+    *  les voit appliquées après lui. Après chaque lot de commandes, les blocs modifiés sont remaillés
+    *  sur le système de tâches et une image est publiée par un échange atomique de pointeur partagé :
+    *  le thread de rendu la prend sans jamais attendre. La caméra et le curseur sont de simples
+    *  valeurs remplacées (seule la dernière compte). Aucune commande ne touche à OpenGL.
+    */
+    class SceneThread {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe SceneThread : démarre le thread
+            *
+            *  \param jobs : système de tâches du remaillage (optionnel, doit survivre au thread)
+            */
+            SceneThread(JobSystem* jobs = nullptr);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe SceneThread : exécute les commandes en attente (sauvegardes) puis arrête le thread
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~SceneThread();
+
+            /*!
+            *  \brief Chargement
+            *
+            *  Demande la lecture d'un fichier de scène
+            *
+            *  \param filepath : chemin d'accès
+            */
+            void load(const std::string& filepath);
+            /*!
+            *  \brief Sauvegarde
+            *
+            *  Demande l'écriture de la scène (cubes du thread de scène, lumières et objets copiés ici)
+            *
+            *  \param filepath : chemin de sauvegarde
+            *  \param lights : réglages des lumières
+            *  \param propList : objets posés
+            */
+            void save(const std::string& filepath, const SceneLights& lights, const PropList& propList);
+            /*!
+            *  \brief Génération
+            *
+            *  Demande la génération d'une scène (voir generateScene)
+            *
+            *  \param controlPoints : matrice de points de contrôle
+            *  \param rbf : choix de la RBF utilisée
+            *  \param epsilon : paramètre de la RBF
+            */
+            void generate(const Eigen::MatrixXd& controlPoints, const std::string& rbf, float epsilon);
+
+            /*!
+            *  \brief Ajout d'un cube
+            *
+            *  Demande la pose d'un cube
+            *
+            *  \param cell : cellule du cube
+            *  \param texture : index de texture
+            */
+            void addCube(const glm::ivec3& cell, GLuint texture);
+            /*!
+            *  \brief Suppression d'un cube
+            *
+            *  Demande le retrait du premier cube posé sur une cellule
+            *
+            *  \param cell : cellule du cube
+            */
+            void deleteCube(const glm::ivec3& cell);
+            /*!
+            *  \brief Texture d'un cube
+            *
+            *  Demande le changement de texture du premier cube posé sur une cellule
+            *
+            *  \param cell : cellule du cube
+            *  \param texture : index de texture
+            */
+            void setTexture(const glm::ivec3& cell, GLuint texture);
+            /*!
+            *  \brief Extrusion
+            *
+            *  Demande la pose d'un cube au-dessus d'une cellule pleine, si la place est libre
+            *
+            *  \param cell : cellule extrudée
+            *  \param texture : index de texture du nouveau cube
+            */
+            void extrude(const glm::ivec3& cell, GLuint texture);
+            /*!
+            *  \brief Creusement
+            *
+            *  Demande le retrait du cube d'une cellule posée sur une colonne et libre au-dessus
+            *
+            *  \param cell : cellule creusée
+            */
+            void dig(const glm::ivec3& cell);
+            /*!
+            *  \brief Emission d'une texture
+            *
+            *  Demande le changement de la lumière émise par les cubes d'une texture
+            *
+            *  \param texture : index de texture
+            *  \param level : niveau émis (0 à VoxelLight::MAX_LEVEL)
+            */
+            void setEmission(GLuint texture, int level);
+            /*!
+            *  \brief Stockage des voxels
+            *
+            *  Demande le passage à l'octree creux ou à la grille de blocs
+            *
+            *  \param sparse : vrai pour l'octree creux
+            */
+            void setSparseStorage(bool sparse);
+            /*!
+            *  \brief Sélection
+            *
+            *  Demande le lancer d'un rayon dans les voxels, comparé à l'objet touché par le thread de rendu
+            *
+            *  \param origin : origine du rayon
+            *  \param direction : direction du rayon
+            *  \param frontCell : vrai pour la cellule devant la face touchée (clic droit)
+            *  \param propHit : objet touché par le même rayon (nullptr si aucun)
+            */
+            void pick(const glm::vec3& origin, const glm::vec3& direction, bool frontCell, const PropRayHit* propHit);
+            /*!
+            *  \brief Vue
+            *
+            *  Remplace la position de la caméra (niveaux de détail) et la cellule du curseur (état publié)
+            *
+            *  \param viewerPosition : position de la caméra
+            *  \param cursor : cellule du curseur
+            */
+            void setView(const glm::vec3& viewerPosition, const glm::ivec3& cursor);
+
+            /*!
+            *  \brief Image publiée
+            *
+            *  Renvoit l'image publiée depuis l'appel précédent (nullptr sinon)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            std::shared_ptr<const SceneFrame> takeFrame();
+
+            // Getters
+            /*!
+            *  \brief Fichiers en cours
+            *
+            *  Renvoit vrai si un chargement, une sauvegarde ou une génération n'est pas terminé
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isBusy() const{
+                return m_pending.load() > 0;
+            };
+
+        private:
+            SceneThread(const SceneThread&);
+            SceneThread& operator=(const SceneThread&);
+
+            static bool isFileCommand(SceneCommandType type){
+                return type == SCENE_LOAD || type == SCENE_SAVE || type == SCENE_GENERATE;
+            };
+
+            void push(SceneCommand& command);
+            void execute(SceneCommand& command);
+            void replaceCubes(const SceneSnapshot& scene);
+            int findCube(const glm::ivec3& cell) const;
+            void publish();
+            void work();
+
+            // Attributes
+            SPSCQueue<SceneCommand> m_commands; /*!< Commandes du thread de rendu*/
+            std::shared_ptr<SceneFrame> m_published; /*!< Dernière image publiée (accès atomiques seulement)*/
+            std::atomic<int> m_pending; /*!< Chargements, sauvegardes et générations ajoutés et pas encore terminés*/
+            std::mutex m_sleepMutex; /*!< Protège l'endormissement, la vue et m_stopping*/
+            std::condition_variable m_wake; /*!< Réveille le thread à l'arrivée d'une commande*/
+            bool m_stopping; /*!< Le thread s'arrête quand la file est vide*/
+            glm::vec3 m_viewer; /*!< Dernière position de la caméra donnée (protégée)*/
+            glm::ivec3 m_cursor; /*!< Dernière cellule du curseur donnée (protégée)*/
+            bool m_viewChanged; /*!< La vue a changé depuis la dernière publication (protégé)*/
+            // Scene thread only
+            JobSystem* m_jobs; /*!< Système de tâches du remaillage*/
+            CubeList m_cubeList; /*!< Cubes, voxels et maillages de la scène*/
+            glm::vec3 m_meshViewer; /*!< Position de la caméra du remaillage*/
+            glm::ivec3 m_statusCursor; /*!< Cellule du curseur décrite par les images*/
+            std::vector<std::shared_ptr<const SceneSnapshot> > m_loadedScenes; /*!< Scènes appliquées depuis la dernière publication*/
+            bool m_picked; /*!< Rayon lancé depuis la dernière publication*/
+            ScenePick m_pick; /*!< Résultat de ce rayon*/
+            std::thread m_thread; /*!< Thread de scène*/
+    };
+
+}
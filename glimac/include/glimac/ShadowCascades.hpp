@@ -0,0 +1,134 @@
+/**
+ * \file ShadowCascades.hpp
+ * \brief Ombres de la lumière directionnelle
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Cartes d'ombres en cascades pour la lumière directionnelle, gardées en cache tant que la scène
+ * et la lumière ne changent pas
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "UniformBuffer.hpp"
+#include "ChunkRenderer.hpp"
+
+namespace glimac {
+
+    /*! \class ShadowCascades
+    * \brief Classe de cartes d'ombres en cascades
+    *
+    *  Le champ de vision (jusqu'à MAX_DISTANCE) est découpé en CASCADE_COUNT tranches, chacune
+    *  couverte par une projection orthographique dans une couche d'une texture de profondeur.
+    *  Chaque projection couvre un peu plus que sa tranche : une cascade n'est redessinée que si sa
+    *  tranche en sort, si la lumière tourne, ou si un bloc qu'elle couvre est remaillé. Seuls les
+    *  blocs qui touchent une cascade y sont dessinés.
+    */
+    class ShadowCascades {
+
+        public:
+            static const int CASCADE_COUNT = 3; /*!< Nombre de cascades (taille de FrameData::shadowMatrices)*/
+            static const int RESOLUTION = 2048; /*!< Taille d'une carte d'ombre*/
+            static const GLuint TEXTURE_UNIT = 4; /*!< Unité de texture de la carte d'ombre (après LightClusters)*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe ShadowCascades : alloue la texture et le framebuffer (contexte OpenGL requis)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ShadowCascades();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe ShadowCascades : libère la texture et le framebuffer
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~ShadowCascades();
+
+            /*!
+            *  \brief Mise à jour
+            *
+            *  Calcule les tranches de la caméra et marque les cascades à redessiner
+            *
+            *  \param chunkRenderer : blocs de la scène (après son update de l'image)
+            *  \param view : matrice View
+            *  \param projection : matrice Projection (perspective)
+            *  \param lightDirection : direction de propagation de la lumière (espace monde)
+            */
+            void update(const ChunkRenderer& chunkRenderer, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightDirection);
+            /*!
+            *  \brief Rendu
+            *
+            *  Redessine les cascades marquées, puis rétablit le framebuffer et le viewport
+            *
+            *  \param chunkRenderer : blocs de la scène
+            *  \param uLightViewProjection : uniforme de la matrice du programme d'ombre (en cours d'utilisation)
+            */
+            void render(ChunkRenderer& chunkRenderer, GLint uLightViewProjection);
+            /*!
+            *  \brief Liaison
+            *
+            *  Attache la carte d'ombre à l'unité TEXTURE_UNIT
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void bind() const;
+            /*!
+            *  \brief Paramètres de l'image
+            *
+            *  Ecrit les matrices (depuis l'espace View) et les limites des cascades dans les données de l'image
+            *
+            *  \param frame : données de l'image
+            */
+            void fillFrameData(FrameData& frame) const;
+            /*!
+            *  \brief Liaison du sampler
+            *
+            *  Relie le sampler uShadowMap du programme courant à son unité
+            *
+            *  \param program : identifiant du programme (en cours d'utilisation)
+            */
+            static void bindSamplers(GLuint program);
+
+            // Getter
+            /*!
+            *  \brief Cascades redessinées
+            *
+            *  Renvoit le nombre de cascades redessinées par le dernier render
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getRenderedCount() const{
+                return m_renderedCount;
+            };
+
+        private:
+            ShadowCascades(const ShadowCascades&);
+            ShadowCascades& operator=(const ShadowCascades&);
+
+            struct Cascade {
+                glm::vec2 center; /*!< Centre de la projection (espace lumière)*/
+                float halfSize; /*!< Demi-largeur de la projection*/
+                glm::vec2 depthRange; /*!< Profondeurs couvertes (espace lumière)*/
+                glm::mat4 viewProjection; /*!< Matrice de la cascade (espace monde)*/
+                float splitFar; /*!< Fin de la tranche (profondeur View)*/
+                bool dirty; /*!< A redessiner*/
+            };
+
+            // Attributes
+            GLuint m_texture; /*!< Texture de profondeur, une couche par cascade*/
+            GLuint m_framebuffer; /*!< Framebuffer de rendu des ombres*/
+            Cascade m_cascades[CASCADE_COUNT]; /*!< Cascades*/
+            glm::vec3 m_lightDirection; /*!< Direction de la lumière des cascades en cache*/
+            glm::mat4 m_lightView; /*!< Rotation vers l'espace lumière*/
+            glm::mat4 m_inverseView; /*!< Inverse de la matrice View de l'image*/
+            int m_renderedCount; /*!< Cascades redessinées par le dernier render*/
+    };
+
+}
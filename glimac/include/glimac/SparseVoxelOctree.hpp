@@ -0,0 +1,121 @@
+/**
+ * \file SparseVoxelOctree.hpp
+ * \brief Octree creux de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Octree creux dont les noeuds homogènes sont fusionnés (scènes très grandes et peu denses)
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "VoxelStorage.hpp"
+
+namespace glimac {
+
+    /*! \class SparseVoxelOctree
+    * \brief Classe representant un octree creux de voxels
+    *
+    *  Les huit enfants d'un noeud sont alloués ensemble. Un noeud dont les huit enfants sont des
+    *  feuilles de même valeur est fusionné : la mémoire suit la surface et non le volume englobant.
+    *  La racine s'agrandit automatiquement pour contenir les voxels ajoutés.
+    */
+    class SparseVoxelOctree : public VoxelStorage {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe SparseVoxelOctree : racine vide de 16 voxels d'arête
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            SparseVoxelOctree();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe SparseVoxelOctree
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~SparseVoxelOctree(){};
+
+            // VoxelStorage
+            GLuint get(const glm::ivec3& position) const;
+            void set(const glm::ivec3& position, GLuint value);
+            void clear();
+            void getCells(std::vector<VoxelCell>& out) const;
+            size_t getMemoryUsage() const;
+
+            // Queries
+            /*!
+            *  \brief Lancer de rayon
+            *
+            *  Parcourt les feuilles traversées par le rayon en sautant les noeuds vides entiers
+            *
+            *  \param origin : origine du rayon (espace monde)
+            *  \param direction : direction du rayon
+            *  \param maxDistance : distance maximale parcourue
+            *  \param hit : voxel et face touchés
+            */
+            bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, VoxelRayHit& hit) const;
+            /*!
+            *  \brief Niveau de détail
+            *
+            *  Ajoute au vecteur les cellules d'arête au moins 2^level : chaque noeud de cette taille
+            *  prend la valeur majoritaire (en volume) de ses voxels pleins
+            *
+            *  \param level : niveau de détail (0 = voxels d'origine)
+            *  \param out : vecteur destination
+            */
+            void extractLOD(int level, std::vector<VoxelCell>& out) const;
+            /*!
+            *  \brief Nombre de noeuds
+            *
+            *  Renvoit le nombre de noeuds utilisés
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getNodeCount() const{
+                return m_nodes.size() - 8*m_freeBlocks.size();
+            };
+            /*!
+            *  \brief Profondeur
+            *
+            *  Renvoit la profondeur de l'octree (arête de la racine = 2^depth)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            int getDepth() const{
+                return m_depth;
+            };
+
+        private:
+            static const uint32_t LEAF = 0xFFFFFFFFu;
+
+            struct Node {
+                uint32_t children; /*!< Indice du premier des 8 enfants, LEAF pour une feuille*/
+                GLuint value; /*!< Valeur de la feuille*/
+
+                Node():children(LEAF), value(0){}
+                Node(GLuint value):children(LEAF), value(value){}
+            };
+
+            bool contains(const glm::ivec3& position) const;
+            void growToContain(const glm::ivec3& position);
+            uint32_t allocateBlock(GLuint value);
+            void collectCells(uint32_t node, const glm::ivec3& origin, int size, int minSize, std::vector<VoxelCell>& out) const;
+            void accumulateVolume(uint32_t node, int size, std::unordered_map<GLuint, long long>& volumes) const;
+            uint32_t findLeaf(const glm::ivec3& local, glm::ivec3& leafOrigin, int& leafSize) const;
+
+            // Attributes
+            std::vector<Node> m_nodes; /*!< Noeuds (la racine est le noeud 0)*/
+            std::vector<uint32_t> m_freeBlocks; /*!< Blocs de 8 noeuds libérés*/
+            glm::ivec3 m_origin; /*!< Coin minimal de la racine*/
+            int m_depth; /*!< Profondeur : arête de la racine = 2^depth*/
+    };
+
+}
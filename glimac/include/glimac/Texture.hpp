@@ -14,6 +14,7 @@
 #include "common.hpp"
 #include "Image.hpp"
 #include "Program.hpp"
+#include "TextureCache.hpp"
 
 namespace glimac {
 
@@ -50,7 +51,7 @@ namespace glimac {
         *  \param program : programme
         *  \param name : nom de la UL
         */
-        void setUniformLocation(Program &program, const GLchar* name);
+        void setUniformLocation(const Program &program, const GLchar* name);
         /*!
         *  \brief Mise à jour des informations de l'image
         *
@@ -60,6 +61,14 @@ namespace glimac {
         */
         void setImage(const FilePath &filepath);
         /*!
+        *  \brief Envoi d'une texture préparée
+        *
+        *  Crée la texture OpenGL à partir d'une texture préparée (thread du contexte OpenGL)
+        *
+        *  \param baked : texture préparée (nulle si l'image n'a pas pu être lue)
+        */
+        void upload(std::unique_ptr<BakedTexture> baked);
+        /*!
         *  \brief Informations de la texture
         *
         *  Récuperer les informations de la texture
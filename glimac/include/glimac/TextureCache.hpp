@@ -0,0 +1,139 @@
+/**
+ * \file TextureCache.hpp
+ * \brief Textures préparées pour le GPU
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Cache des textures décodées, avec leurs mipmaps et éventuellement compressées (BC1/BC3), à
+ * envoyer telles quelles au GPU
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "FilePath.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+namespace glimac {
+
+    /*! \class BakedTexture
+    * \brief Classe de texture préparée
+    *
+    *  Au premier lancement l'image est décodée, réduite en une chaîne de mipmaps (moyenne 2x2) puis,
+    *  si le pilote sait les lire, compressée en BC1 (opaque) ou BC3 (avec transparence). Le résultat
+    *  est écrit à côté de l'image (même nom, extension .wtex) avec la taille et la date de la source.
+    *  Aux lancements suivants le fichier est projeté en mémoire et envoyé directement au GPU : plus
+    *  aucun décodage. Une source modifiée ou un autre choix de compression refait le fichier.
+    */
+    class BakedTexture {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe BakedTexture : aucune donnée
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            BakedTexture();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe BakedTexture
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~BakedTexture(){};
+
+            /*!
+            *  \brief Chargement
+            *
+            *  Ouvre le cache d'une image s'il est à jour, sinon le refait (nul si l'image est illisible).
+            *  N'utilise pas OpenGL : peut tourner sur un thread de travail.
+            *
+            *  \param source : image (png, jpg...)
+            *  \param compress : compresser en BC1/BC3 (EXT_texture_compression_s3tc disponible)
+            */
+            static std::unique_ptr<BakedTexture> load(const FilePath& source, bool compress);
+            /*!
+            *  \brief Envoi au GPU
+            *
+            *  Crée la texture OpenGL avec toute la chaîne de mipmaps (thread du contexte OpenGL)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint upload() const;
+
+            // Getters
+            /*!
+            *  \brief Renvoit la largeur
+            *
+            *  Renvoit la largeur du niveau 0
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLsizei getWidth() const{
+                return m_width;
+            };
+            /*!
+            *  \brief Renvoit la hauteur
+            *
+            *  Renvoit la hauteur du niveau 0
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLsizei getHeight() const{
+                return m_height;
+            };
+            /*!
+            *  \brief Renvoit le format
+            *
+            *  Renvoit le format OpenGL des données (GL_RGBA8 ou un format S3TC)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLenum getFormat() const{
+                return m_format;
+            };
+            /*!
+            *  \brief Provenance
+            *
+            *  Renvoit true si les données viennent du cache, false si elles viennent d'être préparées
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isFromCache() const{
+                return m_fromCache;
+            };
+
+        private:
+            BakedTexture(const BakedTexture&);
+            BakedTexture& operator=(const BakedTexture&);
+
+            bool open(const FilePath& cacheFile, const FilePath& source, bool compress);
+            bool bake(const FilePath& source, const FilePath& cacheFile, bool compress);
+
+            // Attributes
+            MappedFile m_file; /*!< Fichier du cache projeté*/
+            std::vector<unsigned char> m_baked; /*!< Données préparées, si le cache n'a pas pu être écrit*/
+            const unsigned char* m_levels; /*!< Niveaux à la suite, du plus grand au plus petit*/
+            GLenum m_format; /*!< Format des niveaux*/
+            GLsizei m_width; /*!< Largeur du niveau 0*/
+            GLsizei m_height; /*!< Hauteur du niveau 0*/
+            GLsizei m_levelCount; /*!< Nombre de niveaux*/
+            bool m_fromCache; /*!< Lu depuis le cache*/
+    };
+
+    // Prepare (or read from the cache) on a worker thread, the future gives the texture to the GL thread (null on failure)
+    std::future<std::unique_ptr<BakedTexture> > loadBakedTextureAsync(ThreadPool& pool, const FilePath& source, bool compress);
+
+    // Create a texture from consecutive levels (GL_RGBA8 or S3TC, each half the size of the previous one)
+    GLuint uploadMipChain(GLenum format, GLsizei width, GLsizei height, GLsizei levelCount, const unsigned char* levels);
+
+    // Size in bytes of one level
+    size_t getLevelSize(GLenum format, GLsizei width, GLsizei height);
+
+}
@@ -0,0 +1,98 @@
+/**
+ * \file ThreadPool.hpp
+ * \brief Groupe de threads de travail
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Threads de travail qui exécutent des tâches en parallèle du thread principal
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace glimac {
+
+    /*! \class ThreadPool
+    * \brief Classe de groupe de threads
+    *
+    *  Les tâches sont placées dans une file commune et prises par le premier thread libre. Chaque
+    *  tâche renvoit un future : le thread principal récupère le résultat (ou l'exception) quand il en
+    *  a besoin. Les tâches ne doivent pas appeler OpenGL (le contexte reste au thread principal).
+    */
+    class ThreadPool {
+
+        public:
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe ThreadPool : démarre les threads
+            *
+            *  \param threadCount : nombre de threads (0 = un par coeur, moins le thread principal)
+            */
+            ThreadPool(unsigned int threadCount = 0);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe ThreadPool : termine les tâches en file puis arrête les threads
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~ThreadPool();
+
+            /*!
+            *  \brief Ajout d'une tâche
+            *
+            *  Place une tâche dans la file et renvoit le future de son résultat
+            *
+            *  \param task : fonction sans paramètre
+            */
+            template<typename Task>
+            std::future<typename std::result_of<Task()>::type> submit(Task task){
+                typedef typename std::result_of<Task()>::type Result;
+                // std::function needs a copyable target : the packaged task is shared
+                std::shared_ptr<std::packaged_task<Result()> > packaged = std::make_shared<std::packaged_task<Result()> >(std::move(task));
+                std::future<Result> result = packaged->get_future();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_tasks.push_back([packaged](){ (*packaged)(); });
+                }
+                m_condition.notify_one();
+                return result;
+            };
+
+            // Getter
+            /*!
+            *  \brief Nombre de threads
+            *
+            *  Renvoit le nombre de threads de travail
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getThreadCount() const{
+                return m_threads.size();
+            };
+
+        private:
+            ThreadPool(const ThreadPool&);
+            ThreadPool& operator=(const ThreadPool&);
+
+            void work();
+
+            // Attributes
+            std::vector<std::thread> m_threads; /*!< Threads de travail*/
+            std::deque<std::function<void()> > m_tasks; /*!< Tâches en attente*/
+            std::mutex m_mutex; /*!< Protège la file et m_stopping*/
+            std::condition_variable m_condition; /*!< Réveille les threads à l'arrivée d'une tâche*/
+            bool m_stopping; /*!< Les threads s'arrêtent quand la file est vide*/
+    };
+
+}
@@ -0,0 +1,115 @@
+/**
+ * \file UniformBuffer.hpp
+ * \brief Blocs d'uniformes partagés par les shaders
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Données de l'image (caméra, lumières) et du matériau, envoyées une fois par image dans des UBO
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+
+namespace glimac {
+
+    /*! \struct FrameData
+    * \brief Données de l'image
+    *
+    *  Miroir du bloc std140 FrameData des shaders (uniquement des mat4 et vec4 : pas de remplissage)
+    */
+    struct FrameData {
+        glm::mat4 view; /*!< Matrice View*/
+        glm::mat4 projection; /*!< Matrice Projection*/
+        glm::mat4 viewProjection; /*!< Matrice Projection * View*/
+        glm::vec4 clusterGrid; /*!< Taille de la grille de clusters (x, y, z), w = nombre de lumières ponctuelles*/
+        glm::vec4 clusterDepth; /*!< Plans proche et lointain, échelle des tranches (voir LightClusters)*/
+        glm::vec4 lightDirection_vs; /*!< Direction de la lumière directionnelle (espace View)*/
+        glm::vec4 lightIntensityD; /*!< Intensité de la lumière directionnelle*/
+        glm::mat4 shadowMatrices[3]; /*!< Espace View vers chaque carte d'ombre (voir ShadowCascades)*/
+        glm::vec4 shadowSplits; /*!< Fin de chaque cascade (profondeur View), w = ombres actives*/
+    };
+
+    /*! \struct MaterialData
+    * \brief Données du matériau
+    *
+    *  Miroir du bloc std140 MaterialData des shaders
+    */
+    struct MaterialData {
+        glm::vec4 diffuse; /*!< Coefficient diffus (Kd)*/
+        glm::vec4 specular; /*!< Coefficient spéculaire (Ks), w = brillance*/
+    };
+
+    /*! \class UniformBuffer
+    * \brief Classe d'UBO attaché à un point de liaison
+    *
+    *  Le buffer reste attaché à son point de liaison : tout programme dont le bloc du même nom est
+    *  relié à ce point (voir Program::link) lit les mêmes données, sans glUniform par programme.
+    */
+    class UniformBuffer {
+
+        public:
+            static const GLuint FRAME_DATA_BINDING = 0; /*!< Point de liaison du bloc FrameData*/
+            static const GLuint MATERIAL_DATA_BINDING = 1; /*!< Point de liaison du bloc MaterialData*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe UniformBuffer : alloue le buffer et l'attache (contexte OpenGL requis)
+            *
+            *  \param binding : point de liaison
+            *  \param size : taille du bloc en octets
+            */
+            UniformBuffer(GLuint binding, GLsizeiptr size);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe UniformBuffer : libère le buffer
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~UniformBuffer();
+
+            /*!
+            *  \brief Mise à jour
+            *
+            *  Remplace tout le contenu du bloc
+            *
+            *  \param data : données (taille du bloc)
+            */
+            void update(const void* data);
+
+            /*!
+            *  \brief Liaison des blocs
+            *
+            *  Relie les blocs FrameData et MaterialData d'un programme à leurs points de liaison
+            *
+            *  \param program : identifiant du programme lié
+            */
+            static void bindBlocks(GLuint program);
+
+            // Getter
+            /*!
+            *  \brief Renvoit le point de liaison
+            *
+            *  Renvoit le point de liaison du buffer
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint getBinding() const{
+                return m_binding;
+            };
+
+        private:
+            UniformBuffer(const UniformBuffer&);
+            UniformBuffer& operator=(const UniformBuffer&);
+
+            // Attributes
+            GLuint m_buffer; /*!< Buffer OpenGL*/
+            GLuint m_binding; /*!< Point de liaison*/
+            GLsizeiptr m_size; /*!< Taille du bloc en octets*/
+    };
+
+}
@@ -0,0 +1,119 @@
+/**
+ * \file UploadRing.hpp
+ * \brief Tampon circulaire d'envoi au GPU
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Tampon circulaire projeté en mémoire et protégé par des fences, pour envoyer des données au GPU
+ * sans allocation du pilote
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+
+namespace glimac {
+
+    /*! \class UploadRing
+    * \brief Classe de tampon circulaire d'envoi
+    *
+    *  Le tampon est découpé en sections : une image écrit dans sa section (ou les suivantes si elle est
+    *  pleine), endFrame pose une fence sur les sections écrites puis passe à la suivante en attendant
+    *  que le GPU ait fini de la lire.
+    *  Avec OpenGL 4.4 (ou ARB_buffer_storage) le tampon est projeté une fois pour toutes (persistent
+    *  et cohérent), sinon chaque écriture projette sa plage sans synchronisation.
+    */
+    class UploadRing {
+
+        public:
+            static const GLintptr INVALID = -1; /*!< Résultat d'une écriture trop grande*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe UploadRing : crée et projette le tampon (contexte OpenGL requis)
+            *
+            *  \param size : taille totale en octets
+            */
+            UploadRing(GLsizeiptr size = 12 << 20);
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe UploadRing : libère le tampon et les fences
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~UploadRing();
+
+            /*!
+            *  \brief Ecriture
+            *
+            *  Copie des données dans le tampon et renvoit leur position (INVALID si elles dépassent une section).
+            *  Les données restent valides jusqu'à la fin de l'image, tant que le tampon n'a pas fait un tour complet.
+            *
+            *  \param data : données à copier
+            *  \param size : taille en octets
+            */
+            GLintptr write(const void* data, GLsizeiptr size);
+            /*!
+            *  \brief Envoi vers un buffer
+            *
+            *  Copie des données dans un buffer OpenGL en passant par le tampon (copie côté GPU)
+            *
+            *  \param buffer : buffer destination
+            *  \param offset : position dans le buffer destination, en octets
+            *  \param data : données à copier
+            *  \param size : taille en octets
+            */
+            void upload(GLuint buffer, GLintptr offset, const void* data, GLsizeiptr size);
+            /*!
+            *  \brief Fin d'image
+            *
+            *  Protège les sections écrites par une fence et passe à la section suivante
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            void endFrame();
+
+            // Getter
+            /*!
+            *  \brief Renvoit le buffer
+            *
+            *  Renvoit le buffer OpenGL du tampon (les positions de write s'y rapportent)
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            GLuint getBuffer() const{
+                return m_buffer;
+            };
+            /*!
+            *  \brief Projection persistante
+            *
+            *  Renvoit vrai si le tampon est projeté une fois pour toutes
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            bool isPersistent() const{
+                return m_mapped != nullptr;
+            };
+
+        private:
+            UploadRing(const UploadRing&);
+            UploadRing& operator=(const UploadRing&);
+
+            void nextSection();
+
+            // Attributes
+            static const int SECTIONS = 3; /*!< Images que le GPU peut avoir en retard*/
+            GLuint m_buffer; /*!< Buffer OpenGL*/
+            GLsizeiptr m_sectionSize; /*!< Taille d'une section en octets*/
+            int m_section; /*!< Section courante*/
+            GLsizeiptr m_head; /*!< Prochain octet libre de la section courante*/
+            GLsync m_fences[SECTIONS]; /*!< Fence de la dernière lecture de chaque section*/
+            bool m_touched[SECTIONS]; /*!< Sections écrites depuis la dernière fence*/
+            char* m_mapped; /*!< Projection persistante (nullptr sinon)*/
+    };
+
+}
@@ -0,0 +1,147 @@
+/**
+ * \file VoxelLight.hpp
+ * \brief Lumière des voxels (ciel et blocs lumineux)
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Propagation sur le CPU de la lumière du ciel et des blocs lumineux à travers les voxels vides,
+ * mise à jour à chaque ajout ou suppression de voxel
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "Chunk.hpp"
+#include "VoxelStorage.hpp"
+#include <deque>
+#include <unordered_set>
+
+namespace glimac {
+
+    /*! \class VoxelLight
+    * \brief Classe de propagation de la lumière dans les voxels
+    *
+    *  Chaque voxel a deux niveaux de 0 à MAX_LEVEL : le ciel et les blocs lumineux. Une cellule vide
+    *  au-dessus du plus haut voxel de sa colonne voit le ciel (niveau maximal). Les autres reçoivent le
+    *  niveau de leur voisine la plus claire moins un, par parcours en largeur. Une modification retire
+    *  d'abord la lumière qui venait de la cellule (file de dé-propagation), puis repropage depuis les
+    *  bords de la zone éteinte : seules les cellules concernées sont visitées. Les niveaux sont stockés
+    *  par bloc de Chunk::SIZE³, deux niveaux par octet. Hors des blocs stockés : ciel si la colonne est
+    *  dégagée, noir sinon.
+    */
+    class VoxelLight {
+
+        public:
+            static const int MAX_LEVEL = 15; /*!< Niveau du ciel et émission maximale*/
+
+            // Constructor & destructor
+            /*!
+            *  \brief Constructeur
+            *
+            *  Constructeur de la classe VoxelLight : aucun voxel, aucun matériau lumineux
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            VoxelLight();
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur de la classe VoxelLight
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            ~VoxelLight(){};
+
+            /*!
+            *  \brief Modification d'un voxel
+            *
+            *  Met à jour la lumière autour d'un voxel qui vient de changer (stockage déjà modifié)
+            *
+            *  \param storage : stockage des voxels
+            *  \param position : position du voxel
+            *  \param previous : ancienne valeur
+            *  \param value : nouvelle valeur
+            */
+            void update(const VoxelStorage& storage, const glm::ivec3& position, GLuint previous, GLuint value);
+            /*!
+            *  \brief Emission d'un matériau
+            *
+            *  Change le niveau de lumière émis par une valeur de voxel et repropage toute la lumière des blocs
+            *
+            *  \param storage : stockage des voxels
+            *  \param value : valeur de voxel (indice de texture + 1)
+            *  \param level : niveau émis (0 à MAX_LEVEL)
+            */
+            void setEmission(const VoxelStorage& storage, GLuint value, int level);
+            /*!
+            *  \brief Renvoit l'émission d'un matériau
+            *
+            *  Renvoit le niveau de lumière émis par une valeur de voxel
+            *
+            *  \param value : valeur de voxel
+            */
+            int getEmission(GLuint value) const{
+                return (value < m_emission.size()) ? m_emission[value] : 0;
+            };
+            /*!
+            *  \brief Renvoit la lumière d'un voxel
+            *
+            *  Renvoit les niveaux du voxel : ciel dans les 4 bits de poids fort, blocs dans les 4 bits de poids faible
+            *
+            *  \param position : position du voxel
+            */
+            uint8_t get(const glm::ivec3& position) const;
+            /*!
+            *  \brief Lecture d'un pavé
+            *
+            *  Copie les niveaux d'un pavé de voxels (ordre y, z, x comme VoxelStorage::getBlock)
+            *
+            *  \param minCorner : coin minimal du pavé
+            *  \param size : dimensions du pavé
+            *  \param out : destination (size.x * size.y * size.z octets)
+            */
+            void getBlock(const glm::ivec3& minCorner, const glm::ivec3& size, uint8_t* out) const;
+            /*!
+            *  \brief Blocs éclairés différemment
+            *
+            *  Renvoit et oublie les blocs dont le maillage lit une cellule dont la lumière a changé
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            std::vector<int64_t> takeChangedChunks();
+            /*!
+            *  \brief Mémoire utilisée
+            *
+            *  Renvoit la mémoire occupée par les niveaux stockés, en octets
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            size_t getMemoryUsage() const{
+                return m_chunks.size()*Chunk::VOLUME;
+            };
+
+        private:
+            // Sky or block level
+            enum Channel { SKY = 0, BLOCK = 1 };
+
+            bool seesSky(const glm::ivec3& position) const;
+            int getLevel(const glm::ivec3& position, Channel channel) const;
+            void setLevel(const glm::ivec3& position, Channel channel, int level);
+            bool isSource(const VoxelStorage& storage, const glm::ivec3& position, Channel channel) const;
+            void remove(const glm::ivec3& position, Channel channel, int level);
+            void propagate(const VoxelStorage& storage, Channel channel);
+            void depropagate(const VoxelStorage& storage, Channel channel);
+            void addNeighbours(const glm::ivec3& position, Channel channel);
+
+            // Attributes
+            std::unordered_map<int64_t, std::vector<uint8_t> > m_chunks; /*!< Niveaux par bloc (ciel << 4 | blocs)*/
+            std::unordered_map<int64_t, int> m_tops; /*!< Plus haut voxel de chaque colonne (clé : x, 0, z)*/
+            int m_minY; /*!< Plus bas voxel jamais placé : les colonnes s'arrêtent en dessous*/
+            std::vector<int> m_emission; /*!< Niveau émis par chaque valeur de voxel*/
+            std::deque<glm::ivec3> m_addQueue[2]; /*!< Cellules à propager, par canal*/
+            std::deque<std::pair<glm::ivec3, int> > m_removeQueue[2]; /*!< Cellules éteintes et leur ancien niveau, par canal*/
+            std::unordered_set<int64_t> m_changedChunks; /*!< Blocs à remailler*/
+    };
+
+}
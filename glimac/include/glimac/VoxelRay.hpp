@@ -0,0 +1,93 @@
+/**
+ * \file VoxelRay.hpp
+ * \brief Lancer de rayon dans une grille de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Parcours de grille 3D (DDA d'Amanatides & Woo) : une cellule visitée par pas
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include <limits>
+
+namespace glimac {
+
+    /*! \struct VoxelRayHit
+    * \brief Résultat d'un lancer de rayon
+    *
+    *  Voxel touché, normale de la face d'entrée et distance parcourue.
+    */
+    struct VoxelRayHit {
+        glm::ivec3 cell; /*!< Coordonnées du voxel touché*/
+        glm::ivec3 normal; /*!< Normale de la face touchée (nulle si le rayon part de l'intérieur)*/
+        GLuint value; /*!< Valeur du voxel touché*/
+        float distance; /*!< Distance entre l'origine et le point d'impact*/
+    };
+
+    /*!
+    *  \brief Parcours DDA
+    *
+    *  Visite les voxels traversés par le rayon dans l'ordre (voxel v centré en v, arête 1) jusqu'au
+    *  premier voxel non vide. Le coût est proportionnel à la longueur du rayon.
+    *
+    *  \param origin : origine du rayon (espace monde)
+    *  \param direction : direction du rayon
+    *  \param maxDistance : distance maximale parcourue
+    *  \param lookup : fonction renvoyant la valeur d'un voxel (GLuint lookup(const glm::ivec3&))
+    *  \param hit : résultat si un voxel est touché
+    */
+    template<typename Lookup>
+    bool voxelDDA(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Lookup lookup, VoxelRayHit& hit){
+        if(glm::length(direction) == 0.0f){
+            return false;
+        }
+        const glm::vec3 d = glm::normalize(direction);
+        // Grid space : voxel v covers [v, v+1]
+        const glm::vec3 o = origin + glm::vec3(0.5f);
+        glm::ivec3 cell = glm::ivec3(glm::floor(o));
+        glm::ivec3 step;
+        glm::vec3 tMax, tDelta;
+        for(int axis=0; axis<3; axis++){
+            if(d[axis] > 0.0f){
+                step[axis] = 1;
+                tDelta[axis] = 1.0f/d[axis];
+                tMax[axis] = (float(cell[axis]) + 1.0f - o[axis])*tDelta[axis];
+            }else if(d[axis] < 0.0f){
+                step[axis] = -1;
+                tDelta[axis] = -1.0f/d[axis];
+                tMax[axis] = (o[axis] - float(cell[axis]))*tDelta[axis];
+            }else{
+                step[axis] = 0;
+                tDelta[axis] = std::numeric_limits<float>::max();
+                tMax[axis] = std::numeric_limits<float>::max();
+            }
+        }
+
+        float t = 0.0f;
+        int lastAxis = -1;
+        while(t <= maxDistance){
+            GLuint value = lookup(cell);
+            if(value != 0){
+                hit.cell = cell;
+                hit.normal = glm::ivec3(0);
+                if(lastAxis != -1){
+                    hit.normal[lastAxis] = -step[lastAxis];
+                }
+                hit.value = value;
+                hit.distance = t;
+                return true;
+            }
+            // Step through the nearest cell boundary
+            int axis = (tMax.x < tMax.y) ? ((tMax.x < tMax.z) ? 0 : 2) : ((tMax.y < tMax.z) ? 1 : 2);
+            t = tMax[axis];
+            tMax[axis] += tDelta[axis];
+            cell[axis] += step[axis];
+            lastAxis = axis;
+        }
+        return false;
+    }
+
+}
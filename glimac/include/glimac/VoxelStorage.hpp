@@ -0,0 +1,125 @@
+/**
+ * \file VoxelStorage.hpp
+ * \brief Interface de stockage des voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Interface commune aux différentes représentations de la scène (grille de blocs, octree creux)
+ *
+ */
+
+#pragma once
+#include "common.hpp"
+#include "VoxelRay.hpp"
+
+namespace glimac {
+
+    /*! \struct VoxelCell
+    * \brief Cellule cubique homogène de la scène
+    *
+    *  Cube de voxels de même valeur, de coin minimal position et d'arête size.
+    */
+    struct VoxelCell {
+        glm::ivec3 position; /*!< Coin minimal de la cellule*/
+        int size; /*!< Longueur d'arête (en voxels)*/
+        GLuint value; /*!< Valeur des voxels de la cellule*/
+
+        VoxelCell(){}
+        VoxelCell(glm::ivec3 position, int size, GLuint value):position(position), size(size), value(value){}
+    };
+
+    /*! \struct VoxelBox
+    * \brief Pavé de voxels pleins
+    *
+    *  Pavé entièrement plein de coin minimal position et de dimensions size (en voxels).
+    */
+    struct VoxelBox {
+        glm::ivec3 position; /*!< Coin minimal du pavé*/
+        glm::ivec3 size; /*!< Dimensions du pavé (en voxels)*/
+
+        VoxelBox(){}
+        VoxelBox(glm::ivec3 position, glm::ivec3 size):position(position), size(size){}
+    };
+
+    /*! \class VoxelStorage
+    * \brief Interface de stockage des voxels
+    *
+    *  Un voxel est identifié par ses coordonnées entières, la valeur 0 signifie vide.
+    */
+    class VoxelStorage {
+
+        public:
+            /*!
+            *  \brief Destructeur
+            *
+            *  Destructeur virtuel de l'interface
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            virtual ~VoxelStorage(){};
+            /*!
+            *  \brief Lecture d'un voxel
+            *
+            *  Renvoit la valeur du voxel à la position donnée (0 si vide)
+            *
+            *  \param position : coordonnées entières du voxel
+            */
+            virtual GLuint get(const glm::ivec3& position) const = 0;
+            /*!
+            *  \brief Ecriture d'un voxel
+            *
+            *  Modifie la valeur du voxel à la position donnée
+            *
+            *  \param position : coordonnées entières du voxel
+            *  \param value : nouvelle valeur du voxel (0 pour vider)
+            */
+            virtual void set(const glm::ivec3& position, GLuint value) = 0;
+            /*!
+            *  \brief Vide le stockage
+            *
+            *  Supprime tous les voxels
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            virtual void clear() = 0;
+            /*!
+            *  \brief Liste des cellules pleines
+            *
+            *  Ajoute au vecteur toutes les cellules non vides (éventuellement regroupées)
+            *
+            *  \param out : vecteur destination
+            */
+            virtual void getCells(std::vector<VoxelCell>& out) const = 0;
+            /*!
+            *  \brief Mémoire occupée
+            *
+            *  Renvoit le nombre d'octets occupés par le stockage
+            *
+            *  \param null : aucuns parametres nécéssaires
+            */
+            virtual size_t getMemoryUsage() const = 0;
+            /*!
+            *  \brief Lancer de rayon
+            *
+            *  Renvoit vrai si le rayon touche un voxel plein avant maxDistance (parcours DDA par défaut)
+            *
+            *  \param origin : origine du rayon (espace monde)
+            *  \param direction : direction du rayon
+            *  \param maxDistance : distance maximale parcourue
+            *  \param hit : voxel et face touchés
+            */
+            virtual bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, VoxelRayHit& hit) const;
+            /*!
+            *  \brief Lecture d'un pavé
+            *
+            *  Copie les valeurs d'un pavé de voxels dans out, rangées en (y*size.z + z)*size.x + x
+            *
+            *  \param minCorner : coin minimal du pavé
+            *  \param size : dimensions du pavé
+            *  \param out : destination (size.x*size.y*size.z valeurs)
+            */
+            virtual void getBlock(const glm::ivec3& minCorner, const glm::ivec3& size, GLuint* out) const;
+    };
+
+}
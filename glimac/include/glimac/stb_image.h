@@ -289,8 +289,8 @@ static stbi_uc *stbi__gif_load(stbi__context *s, int *x, int *y, int *comp, int
 static int      stbi__gif_info(stbi__context *s, int *x, int *y, int *comp);
 
 
-// this is not threadsafe
-static const char *stbi__g_failure_reason;
+// one per thread : images are decoded in parallel (see glimac::loadImageAsync)
+static thread_local const char *stbi__g_failure_reason;
 
 STBIDEF const char *stbi_failure_reason(void)
 {
@@ -0,0 +1,64 @@
+/**
+ * \file BufferArena.cpp
+ * \brief Grand buffer OpenGL sous-alloué
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Buffer OpenGL alloué une fois, découpé en plages pour les maillages et rempli par le tampon d'envoi
+ *
+ */
+
+#include "glimac/BufferArena.hpp"
+
+namespace glimac {
+
+    BufferArena::BufferArena(size_t elementSize, GLuint capacity):
+        m_elementSize(elementSize),
+        m_ranges(capacity) {
+        glGenBuffers(1, &m_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity*m_elementSize, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    BufferArena::~BufferArena(){
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    GLuint BufferArena::allocate(GLuint count){
+        if(count == 0){
+            return 0;
+        }
+        GLuint offset = m_ranges.allocate(count);
+        while(offset == RangeAllocator::INVALID){
+            grow(std::max(m_ranges.getCapacity()*2, m_ranges.getCapacity() + count));
+            offset = m_ranges.allocate(count);
+        }
+        return offset;
+    }
+
+    void BufferArena::release(GLuint offset, GLuint count){
+        m_ranges.release(offset, count);
+    }
+
+    void BufferArena::upload(UploadRing& ring, GLuint offset, GLuint count, const void* data){
+        ring.upload(m_buffer, offset*m_elementSize, data, count*m_elementSize);
+    }
+
+    // The allocated ranges keep their offsets : only the storage moves, copied on the GPU
+    void BufferArena::grow(GLuint capacity){
+        GLuint grown;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity*m_elementSize, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_ranges.getCapacity()*m_elementSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = grown;
+        m_ranges.grow(capacity);
+    }
+
+}
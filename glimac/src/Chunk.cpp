@@ -0,0 +1,104 @@
+/**
+ * \file Chunk.cpp
+ * \brief Stockage compressé d'un bloc de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Palette par bloc et indices compactés (1/2/4/8 bits) qui grandissent à la demande
+ *
+ */
+
+#include "glimac/Chunk.hpp"
+
+namespace glimac {
+
+    const int Chunk::SIZE;
+    const int Chunk::VOLUME;
+    const GLuint Chunk::EMPTY;
+
+    Chunk::Chunk():
+        m_palette(1, EMPTY),
+        m_counts(1, VOLUME),
+        m_data(VOLUME/32, 0u),
+        m_bits(1) {
+    }
+
+    void Chunk::set(int x, int y, int z, GLuint value){
+        const int i = index(x, y, z);
+        const unsigned int oldIndex = readIndex(i);
+        if(m_palette[oldIndex] == value){
+            return;
+        }
+        const unsigned int newIndex = findOrAddPalette(value);
+        m_counts[oldIndex]--;
+        m_counts[newIndex]++;
+        writeIndex(i, newIndex);
+    }
+
+    unsigned int Chunk::getPaletteSize() const{
+        unsigned int used = 0;
+        for(size_t i=0; i<m_counts.size(); i++){
+            if(m_counts[i] > 0){
+                used++;
+            }
+        }
+        return used;
+    }
+
+    size_t Chunk::getMemoryUsage() const{
+        return sizeof(Chunk)
+            + m_palette.capacity()*sizeof(GLuint)
+            + m_counts.capacity()*sizeof(uint16_t)
+            + m_data.capacity()*sizeof(uint32_t);
+    }
+
+    void Chunk::writeIndex(int i, unsigned int paletteIndex){
+        const unsigned int perWord = 32/m_bits;
+        const unsigned int shift = (i%perWord)*m_bits;
+        const uint32_t mask = (1u << m_bits) - 1u;
+        uint32_t& word = m_data[i/perWord];
+        word = (word & ~(mask << shift)) | ((paletteIndex & mask) << shift);
+    }
+
+    // Reuse a freed palette slot before growing the palette (slot 0 is reserved for EMPTY)
+    unsigned int Chunk::findOrAddPalette(GLuint value){
+        int freeSlot = -1;
+        for(size_t i=0; i<m_palette.size(); i++){
+            if(m_palette[i] == value && (i == 0 || m_counts[i] > 0)){
+                return i;
+            }
+            if(i > 0 && m_counts[i] == 0 && freeSlot == -1){
+                freeSlot = i;
+            }
+        }
+        if(freeSlot != -1){
+            m_palette[freeSlot] = value;
+            return freeSlot;
+        }
+        if(m_palette.size() >= (1u << m_bits)){
+            grow();
+        }
+        m_palette.push_back(value);
+        m_counts.push_back(0);
+        return m_palette.size()-1;
+    }
+
+    // Double the index width (1 -> 2 -> 4 -> 8 -> 16 bits) and repack every voxel
+    void Chunk::grow(){
+        if(m_bits >= 16){
+            std::cerr << "[ERROR] Chunk palette cannot hold more than " << (1u << m_bits) << " values !" << std::endl;
+            return;
+        }
+        std::vector<unsigned int> indices(VOLUME);
+        for(int i=0; i<VOLUME; i++){
+            indices[i] = readIndex(i);
+        }
+        m_bits *= 2;
+        m_data.assign(VOLUME/(32/m_bits), 0u);
+        for(int i=0; i<VOLUME; i++){
+            writeIndex(i, indices[i]);
+        }
+    }
+
+}
@@ -0,0 +1,158 @@
+/**
+ * \file ChunkGrid.cpp
+ * \brief Grille de blocs de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Grille creuse de blocs (Chunk) indexée par coordonnées entières
+ *
+ */
+
+#include "glimac/ChunkGrid.hpp"
+
+namespace glimac {
+
+    namespace {
+        // Floor division, also correct for negative coordinates
+        int floorDiv(int a, int b){
+            return (a >= 0) ? a/b : -((-a + b - 1)/b);
+        }
+    }
+
+    GLuint ChunkGrid::get(const glm::ivec3& position) const{
+        auto it = m_chunks.find(packKey(toChunkCoord(position)));
+        if(it == m_chunks.end()){
+            return Chunk::EMPTY;
+        }
+        glm::ivec3 local = toLocalCoord(position);
+        return it->second.get(local.x, local.y, local.z);
+    }
+
+    void ChunkGrid::set(const glm::ivec3& position, GLuint value){
+        const int64_t key = packKey(toChunkCoord(position));
+        glm::ivec3 local = toLocalCoord(position);
+        auto it = m_chunks.find(key);
+        if(it == m_chunks.end()){
+            if(value == Chunk::EMPTY){
+                return;
+            }
+            it = m_chunks.insert(std::make_pair(key, Chunk())).first;
+        }
+        it->second.set(local.x, local.y, local.z, value);
+        if(it->second.isEmpty()){
+            m_chunks.erase(it);
+        }
+    }
+
+    const Chunk* ChunkGrid::getChunk(const glm::ivec3& chunkCoord) const{
+        auto it = m_chunks.find(packKey(chunkCoord));
+        return (it == m_chunks.end()) ? nullptr : &it->second;
+    }
+
+    std::vector<glm::ivec3> ChunkGrid::getChunkCoords() const{
+        std::vector<glm::ivec3> coords;
+        coords.reserve(m_chunks.size());
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            coords.push_back(unpackKey(it->first));
+        }
+        return coords;
+    }
+
+    void ChunkGrid::getCells(std::vector<VoxelCell>& out) const{
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            const glm::ivec3 origin = unpackKey(it->first)*Chunk::SIZE;
+            for(int y=0; y<Chunk::SIZE; y++){
+                for(int z=0; z<Chunk::SIZE; z++){
+                    for(int x=0; x<Chunk::SIZE; x++){
+                        GLuint value = it->second.get(x, y, z);
+                        if(value != Chunk::EMPTY){
+                            out.push_back(VoxelCell(origin + glm::ivec3(x, y, z), 1, value));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    bool ChunkGrid::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, VoxelRayHit& hit) const{
+        glm::ivec3 cachedCoord(0);
+        const Chunk* cachedChunk = nullptr;
+        bool cached = false;
+        return voxelDDA(origin, direction, maxDistance, [&](const glm::ivec3& cell) -> GLuint {
+            glm::ivec3 chunkCoord = toChunkCoord(cell);
+            if(!cached || chunkCoord != cachedCoord){
+                cachedCoord = chunkCoord;
+                cachedChunk = getChunk(chunkCoord);
+                cached = true;
+            }
+            if(!cachedChunk){
+                return Chunk::EMPTY;
+            }
+            glm::ivec3 local = cell - chunkCoord*Chunk::SIZE;
+            return cachedChunk->get(local.x, local.y, local.z);
+        }, hit);
+    }
+
+    void ChunkGrid::getBlock(const glm::ivec3& minCorner, const glm::ivec3& size, GLuint* out) const{
+        std::fill(out, out + size.x*size.y*size.z, Chunk::EMPTY);
+        const glm::ivec3 firstChunk = toChunkCoord(minCorner);
+        const glm::ivec3 lastChunk = toChunkCoord(minCorner + size - glm::ivec3(1));
+        for(int cy=firstChunk.y; cy<=lastChunk.y; cy++){
+            for(int cz=firstChunk.z; cz<=lastChunk.z; cz++){
+                for(int cx=firstChunk.x; cx<=lastChunk.x; cx++){
+                    const Chunk* chunk = getChunk(glm::ivec3(cx, cy, cz));
+                    if(!chunk){
+                        continue;
+                    }
+                    // Intersection of the block with this chunk
+                    const glm::ivec3 chunkOrigin = glm::ivec3(cx, cy, cz)*Chunk::SIZE;
+                    const glm::ivec3 from = glm::max(minCorner, chunkOrigin);
+                    const glm::ivec3 to = glm::min(minCorner + size, chunkOrigin + glm::ivec3(Chunk::SIZE));
+                    for(int y=from.y; y<to.y; y++){
+                        for(int z=from.z; z<to.z; z++){
+                            // Index of the first written voxel : the pointer never leaves the block
+                            const int first = ((y - minCorner.y)*size.z + (z - minCorner.z))*size.x + (from.x - minCorner.x);
+                            GLuint* row = out + first;
+                            for(int x=from.x; x<to.x; x++){
+                                row[x - from.x] = chunk->get(x - chunkOrigin.x, y - chunkOrigin.y, z - chunkOrigin.z);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    size_t ChunkGrid::getMemoryUsage() const{
+        size_t total = 0;
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            total += sizeof(int64_t) + it->second.getMemoryUsage();
+        }
+        return total;
+    }
+
+    glm::ivec3 ChunkGrid::toChunkCoord(const glm::ivec3& position){
+        return glm::ivec3(floorDiv(position.x, Chunk::SIZE), floorDiv(position.y, Chunk::SIZE), floorDiv(position.z, Chunk::SIZE));
+    }
+
+    glm::ivec3 ChunkGrid::toLocalCoord(const glm::ivec3& position){
+        return position - toChunkCoord(position)*Chunk::SIZE;
+    }
+
+    int64_t ChunkGrid::packKey(const glm::ivec3& coord){
+        const int64_t mask = (int64_t(1) << 21) - 1;
+        return ((int64_t(coord.x) & mask) << 42) | ((int64_t(coord.y) & mask) << 21) | (int64_t(coord.z) & mask);
+    }
+
+    glm::ivec3 ChunkGrid::unpackKey(int64_t key){
+        const int64_t mask = (int64_t(1) << 21) - 1;
+        // Sign-extend each 21 bits field
+        auto field = [mask](int64_t v) -> int {
+            v &= mask;
+            return (v & (int64_t(1) << 20)) ? int(v - (int64_t(1) << 21)) : int(v);
+        };
+        return glm::ivec3(field(key >> 42), field(key >> 21), field(key));
+    }
+
+}
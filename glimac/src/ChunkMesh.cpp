@@ -0,0 +1,283 @@
+/**
+ * \file ChunkMesh.cpp
+ * \brief Maillage d'un bloc de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Construction sur le CPU du maillage d'un bloc : faces visibles uniquement, occlusion ambiante et lumière par sommet, sommets compactés, niveaux de détail
+ *
+ */
+
+#include "glimac/ChunkMesh.hpp"
+#include <map>
+
+namespace glimac {
+
+    const int ChunkMesh::MAX_LOD;
+    const int ChunkMesh::MAX_OCCLUDERS;
+
+    namespace {
+
+        // Same face order as the normal table of vertex.vs.glsl
+        struct Face {
+            glm::ivec3 normal;
+            glm::ivec3 corners[4]; // Unit cube corners, same order and UVs as Cube::build()
+        };
+
+        const Face FACES[6] = {
+            { glm::ivec3(0, -1, 0), { glm::ivec3(0,0,0), glm::ivec3(1,0,0), glm::ivec3(1,0,1), glm::ivec3(0,0,1) } },
+            { glm::ivec3(0, 0, 1), { glm::ivec3(0,1,1), glm::ivec3(1,1,1), glm::ivec3(1,0,1), glm::ivec3(0,0,1) } },
+            { glm::ivec3(-1, 0, 0), { glm::ivec3(0,1,1), glm::ivec3(0,1,0), glm::ivec3(0,0,0), glm::ivec3(0,0,1) } },
+            { glm::ivec3(0, 0, -1), { glm::ivec3(0,1,0), glm::ivec3(1,1,0), glm::ivec3(1,0,0), glm::ivec3(0,0,0) } },
+            { glm::ivec3(1, 0, 0), { glm::ivec3(1,1,1), glm::ivec3(1,1,0), glm::ivec3(1,0,0), glm::ivec3(1,0,1) } },
+            { glm::ivec3(0, 1, 0), { glm::ivec3(0,1,0), glm::ivec3(1,1,0), glm::ivec3(1,1,1), glm::ivec3(0,1,1) } }
+        };
+
+        // Grid of cells in [-1, size] on each axis : the chunk plus one layer of neighbours
+        struct PaddedGrid {
+            int padded;
+            std::vector<GLuint> cells;
+
+            PaddedGrid(int size):padded(size + 2), cells(padded*padded*padded){}
+            int index(const glm::ivec3& p) const{
+                return ((p.y + 1)*padded + (p.z + 1))*padded + (p.x + 1);
+            }
+            GLuint operator[](const glm::ivec3& p) const{
+                return cells[index(p)];
+            }
+        };
+
+        // Smallest edge of the two largest box dimensions to be worth rasterizing as an occluder
+        const int MIN_OCCLUDER_EDGE = 4;
+
+        // Greedy decomposition of the chunk voxels into solid boxes (grown along x, then z, then y)
+        void extractOccluders(const std::vector<GLuint>& voxels, int padded, int pad, const glm::ivec3& origin, std::vector<VoxelBox>& out){
+            auto solid = [&](int x, int y, int z) -> bool {
+                return voxels[((y + pad)*padded + (z + pad))*padded + x + pad] != Chunk::EMPTY;
+            };
+            std::vector<bool> used(Chunk::VOLUME, false);
+            auto available = [&](int x, int y, int z) -> bool {
+                return solid(x, y, z) && !used[Chunk::index(x, y, z)];
+            };
+            std::vector<std::pair<int, VoxelBox> > boxes;
+            for(int y=0; y<Chunk::SIZE; y++){
+                for(int z=0; z<Chunk::SIZE; z++){
+                    for(int x=0; x<Chunk::SIZE; x++){
+                        if(!available(x, y, z)){
+                            continue;
+                        }
+                        int sx = 1, sz = 1, sy = 1;
+                        while(x+sx < Chunk::SIZE && available(x+sx, y, z)){
+                            sx++;
+                        }
+                        for(bool grow = true; grow && z+sz < Chunk::SIZE; ){
+                            for(int i=0; i<sx && grow; i++){
+                                grow = available(x+i, y, z+sz);
+                            }
+                            if(grow){
+                                sz++;
+                            }
+                        }
+                        for(bool grow = true; grow && y+sy < Chunk::SIZE; ){
+                            for(int k=0; k<sz && grow; k++){
+                                for(int i=0; i<sx && grow; i++){
+                                    grow = available(x+i, y+sy, z+k);
+                                }
+                            }
+                            if(grow){
+                                sy++;
+                            }
+                        }
+                        for(int j=0; j<sy; j++){
+                            for(int k=0; k<sz; k++){
+                                for(int i=0; i<sx; i++){
+                                    used[Chunk::index(x+i, y+j, z+k)] = true;
+                                }
+                            }
+                        }
+                        // Rank by the area of the largest face
+                        int dims[3] = { sx, sy, sz };
+                        std::sort(dims, dims+3);
+                        if(dims[1] >= MIN_OCCLUDER_EDGE){
+                            boxes.push_back(std::make_pair(dims[1]*dims[2], VoxelBox(origin + glm::ivec3(x, y, z), glm::ivec3(sx, sy, sz))));
+                        }
+                    }
+                }
+            }
+            std::sort(boxes.begin(), boxes.end(), [](const std::pair<int, VoxelBox>& l, const std::pair<int, VoxelBox>& r){
+                return l.first > r.first;
+            });
+            for(size_t i=0; i<boxes.size() && int(i)<ChunkMesh::MAX_OCCLUDERS; i++){
+                out.push_back(boxes[i].second);
+            }
+        }
+
+        // Downsampled cell : solid if any voxel of the block is, with the most frequent material
+        GLuint downsample(const std::vector<GLuint>& voxels, int padded, const glm::ivec3& corner, int scale){
+            std::vector<std::pair<GLuint, int> > counts;
+            for(int y=0; y<scale; y++){
+                for(int z=0; z<scale; z++){
+                    for(int x=0; x<scale; x++){
+                        const GLuint value = voxels[((corner.y + y)*padded + (corner.z + z))*padded + corner.x + x];
+                        if(value == Chunk::EMPTY){
+                            continue;
+                        }
+                        size_t k = 0;
+                        while(k < counts.size() && counts[k].first != value){
+                            k++;
+                        }
+                        if(k == counts.size()){
+                            counts.push_back(std::make_pair(value, 0));
+                        }
+                        counts[k].second++;
+                    }
+                }
+            }
+            GLuint best = Chunk::EMPTY;
+            int bestCount = 0;
+            for(size_t k=0; k<counts.size(); k++){
+                if(counts[k].second > bestCount){
+                    best = counts[k].first;
+                    bestCount = counts[k].second;
+                }
+            }
+            return best;
+        }
+    }
+
+    void ChunkMesh::build(const VoxelStorage& storage, const glm::ivec3& chunkCoord, int lod, const VoxelLight* light){
+        m_chunkCoord = chunkCoord;
+        m_lod = glm::clamp(lod, 0, MAX_LOD);
+        m_vertices.clear();
+        m_indices.clear();
+        m_subMeshes.clear();
+        m_occluders.clear();
+
+        // One cell per 2^lod voxels along each axis, plus one neighbour cell on each side
+        const int scale = 1 << m_lod;
+        const int size = Chunk::SIZE / scale;
+        const glm::ivec3 origin = chunkCoord*Chunk::SIZE;
+        PaddedGrid voxels(size);
+        // Light of each cell (sky << 4 | block), full sky without a light engine
+        std::vector<uint8_t> lights(voxels.cells.size(), uint8_t(VoxelLight::MAX_LEVEL << 4));
+        if(scale == 1){
+            storage.getBlock(origin - glm::ivec3(1), glm::ivec3(voxels.padded), voxels.cells.data());
+            if(light){
+                light->getBlock(origin - glm::ivec3(1), glm::ivec3(voxels.padded), lights.data());
+            }
+            extractOccluders(voxels.cells, voxels.padded, 1, origin, m_occluders);
+        }else{
+            const int fine = Chunk::SIZE + 2*scale;
+            std::vector<GLuint> fineVoxels(fine*fine*fine);
+            storage.getBlock(origin - glm::ivec3(scale), glm::ivec3(fine), fineVoxels.data());
+            std::vector<uint8_t> fineLights;
+            if(light){
+                fineLights.resize(fineVoxels.size());
+                light->getBlock(origin - glm::ivec3(scale), glm::ivec3(fine), fineLights.data());
+            }
+            // Coarse cells overestimate the solid volume : occluders always come from the full resolution voxels
+            extractOccluders(fineVoxels, fine, scale, origin, m_occluders);
+            for(int y=-1; y<=size; y++){
+                for(int z=-1; z<=size; z++){
+                    for(int x=-1; x<=size; x++){
+                        const glm::ivec3 cell(x, y, z);
+                        voxels.cells[voxels.index(cell)] = downsample(fineVoxels, fine, (cell + glm::ivec3(1))*scale, scale);
+                        // An empty coarse cell only holds empty voxels : its central voxel is lit like it
+                        if(light){
+                            const glm::ivec3 center = (cell + glm::ivec3(1))*scale + glm::ivec3(scale/2);
+                            lights[voxels.index(cell)] = fineLights[(center.y*fine + center.z)*fine + center.x];
+                        }
+                    }
+                }
+            }
+        }
+
+        // Triangles of each material, merged into one IBO at the end
+        std::map<GLuint, std::vector<uint32_t> > trianglesByValue;
+
+        for(int y=0; y<size; y++){
+            for(int z=0; z<size; z++){
+                for(int x=0; x<size; x++){
+                    const glm::ivec3 cell(x, y, z);
+                    const GLuint value = voxels[cell];
+                    if(value == Chunk::EMPTY){
+                        continue;
+                    }
+                    for(int f=0; f<6; f++){
+                        const Face& face = FACES[f];
+                        const glm::ivec3 front = cell + face.normal;
+                        // Coarse chunks keep their border faces : a neighbour at another level does not match
+                        // this one, and these faces close the seam
+                        const bool border = glm::any(glm::lessThan(front, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(front, glm::ivec3(size)));
+                        if(voxels[front] != Chunk::EMPTY && !(m_lod > 0 && border)){
+                            continue;
+                        }
+
+                        // 3-sample AO : both side neighbours and the corner neighbour, in the layer in front of the face.
+                        // The light of the corner is the mean of the same cells and the front one, solid ones left out
+                        int occlusion[4];
+                        GLuint cornerLight[4];
+                        for(int k=0; k<4; k++){
+                            glm::ivec3 side1(0), side2(0);
+                            bool first = true;
+                            for(int axis=0; axis<3; axis++){
+                                if(face.normal[axis] != 0){
+                                    continue;
+                                }
+                                const int step = face.corners[k][axis] ? 1 : -1;
+                                if(first){
+                                    side1[axis] = step;
+                                    first = false;
+                                }else{
+                                    side2[axis] = step;
+                                }
+                            }
+                            const int s1 = voxels[front + side1] != Chunk::EMPTY;
+                            const int s2 = voxels[front + side2] != Chunk::EMPTY;
+                            const int c = voxels[front + side1 + side2] != Chunk::EMPTY;
+                            occlusion[k] = (s1 && s2) ? 3 : s1 + s2 + c;
+
+                            const glm::ivec3 samples[4] = { front, front + side1, front + side2, front + side1 + side2 };
+                            const bool open[4] = { voxels[front] == Chunk::EMPTY, !s1, !s2, !c && !(s1 && s2) };
+                            int sky = 0, block = 0, count = 0;
+                            for(int j=0; j<4; j++){
+                                if(open[j]){
+                                    sky += lights[voxels.index(samples[j])] >> 4;
+                                    block += lights[voxels.index(samples[j])] & 15;
+                                    count++;
+                                }
+                            }
+                            if(count == 0){
+                                cornerLight[k] = lights[voxels.index(front)];
+                            }else{
+                                cornerLight[k] = (GLuint((sky + count/2)/count) << 4) | GLuint((block + count/2)/count);
+                            }
+                        }
+
+                        const uint32_t base = m_vertices.size();
+                        for(int k=0; k<4; k++){
+                            m_vertices.push_back(PackedVoxelVertex(cell + face.corners[k], f, k, occlusion[k], value, cornerLight[k]));
+                        }
+
+                        // Split the quad along the diagonal that keeps the occlusion gradient symmetric
+                        std::vector<uint32_t>& triangles = trianglesByValue[value];
+                        if(occlusion[0] + occlusion[2] > occlusion[1] + occlusion[3]){
+                            const uint32_t quad[6] = { base, base+1, base+2, base, base+2, base+3 };
+                            triangles.insert(triangles.end(), quad, quad+6);
+                        }else{
+                            const uint32_t quad[6] = { base+1, base+2, base+3, base+1, base+3, base };
+                            triangles.insert(triangles.end(), quad, quad+6);
+                        }
+                    }
+                }
+            }
+        }
+
+        for(auto it = trianglesByValue.begin(); it != trianglesByValue.end(); ++it){
+            m_subMeshes.push_back(ChunkSubMesh(it->first, m_indices.size(), it->second.size()));
+            m_indices.insert(m_indices.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+}
@@ -0,0 +1,273 @@
+/**
+ * \file ChunkRenderer.cpp
+ * \brief Rendu des maillages de blocs
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Envoi au GPU des maillages de blocs reconstruits et affichage par matériau
+ *
+ */
+
+#include "glimac/ChunkRenderer.hpp"
+#include <map>
+#include <limits>
+
+namespace glimac {
+
+    namespace {
+        // Only the nearest occluders are rasterized : they hide the most and keep the CPU cost bounded
+        const size_t MAX_FRAME_OCCLUDERS = 64;
+        // Initial capacity of the shared buffers, doubled whenever a chunk does not fit
+        const GLuint INITIAL_VERTEX_CAPACITY = 1 << 18;
+        const GLuint INITIAL_INDEX_CAPACITY = 1 << 19;
+
+        // True when the 8 clip space corners are all beyond the same plane
+        bool outsideClipVolume(const glm::mat4& viewProjection, const glm::vec3& boxMin, const glm::vec3& boxMax){
+            glm::vec4 clip[8];
+            for(int i=0; i<8; i++){
+                const glm::vec3 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+                clip[i] = viewProjection * glm::vec4(corner, 1.0f);
+            }
+            for(int plane=0; plane<6; plane++){
+                const int axis = plane/2;
+                const float sign = (plane & 1) ? -1.0f : 1.0f;
+                bool allOut = true;
+                for(int i=0; i<8 && allOut; i++){
+                    allOut = clip[i].w + sign*clip[i][axis] < 0.0f;
+                }
+                if(allOut){
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    ChunkRenderer::ChunkRenderer():
+        m_visibleCount(0),
+        m_drawCallCount(0),
+        m_vaoVertexBuffer(0),
+        m_vaoIndexBuffer(0),
+        m_vertices(sizeof(PackedVoxelVertex), INITIAL_VERTEX_CAPACITY),
+        m_indices(sizeof(uint32_t), INITIAL_INDEX_CAPACITY),
+        m_multiDraw(false) {
+        glGenVertexArrays(1, &m_vao);
+        setupVertexArray();
+
+        // baseInstance is what selects the chunk origin of each command in the instance buffer
+        m_multiDrawSupported = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+        m_multiDraw = m_multiDrawSupported;
+    }
+
+    ChunkRenderer::~ChunkRenderer(){
+        glDeleteVertexArrays(1, &m_vao);
+    }
+
+    void ChunkRenderer::setupVertexArray(){
+        m_vaoVertexBuffer = m_vertices.getBuffer();
+        m_vaoIndexBuffer = m_indices.getBuffer();
+        glBindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vaoVertexBuffer);
+        glEnableVertexAttribArray(VERTEX_ATTR_PACKED);
+        glVertexAttribIPointer(VERTEX_ATTR_PACKED, 2, GL_UNSIGNED_INT, sizeof(PackedVoxelVertex), (const GLvoid*)offsetof(PackedVoxelVertex, data));
+        // One origin per draw command, the array is only enabled in multi-draw mode
+        glVertexAttribDivisor(VERTEX_ATTR_CHUNK_ORIGIN, 1);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vaoIndexBuffer);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void ChunkRenderer::update(const ChunkMeshUpdates& meshes){
+        m_updatedOrigins.clear();
+        for(auto updated = meshes.begin(); updated != meshes.end(); ++updated){
+            const ChunkMesh* mesh = updated->second.get();
+            auto it = m_chunks.find(updated->first);
+            if(it != m_chunks.end()){
+                m_updatedOrigins.push_back(it->second.origin);
+                release(it->second);
+                if(!mesh){
+                    m_chunks.erase(it);
+                    continue;
+                }
+            }
+            else if(!mesh){
+                continue;
+            }
+            else{
+                GPUChunk chunk;
+                chunk.visible = true;
+                it = m_chunks.insert(std::make_pair(updated->first, chunk)).first;
+                m_updatedOrigins.push_back(mesh->getChunkCoord()*Chunk::SIZE);
+            }
+            upload(it->second, *mesh);
+        }
+    }
+
+    void ChunkRenderer::upload(GPUChunk& chunk, const ChunkMesh& mesh){
+        chunk.origin = mesh.getChunkCoord()*Chunk::SIZE;
+        chunk.lod = mesh.getLOD();
+        chunk.subMeshes = mesh.getSubMeshes();
+        chunk.occluders = mesh.getOccluders();
+        chunk.vertexCount = mesh.getVertices().size();
+        chunk.indexCount = mesh.getIndices().size();
+
+        // Indices stay chunk-relative, the draw adds vertexOffset as base vertex
+        chunk.vertexOffset = m_vertices.allocate(chunk.vertexCount);
+        chunk.indexOffset = m_indices.allocate(chunk.indexCount);
+        if(m_vertices.getBuffer() != m_vaoVertexBuffer || m_indices.getBuffer() != m_vaoIndexBuffer){
+            setupVertexArray();
+        }
+        m_vertices.upload(m_uploads, chunk.vertexOffset, chunk.vertexCount, mesh.getVertices().data());
+        m_indices.upload(m_uploads, chunk.indexOffset, chunk.indexCount, mesh.getIndices().data());
+    }
+
+    void ChunkRenderer::release(GPUChunk& chunk){
+        m_vertices.release(chunk.vertexOffset, chunk.vertexCount);
+        m_indices.release(chunk.indexOffset, chunk.indexCount);
+        chunk.vertexCount = 0;
+        chunk.indexCount = 0;
+    }
+
+    bool ChunkRenderer::getBounds(glm::vec3& boxMin, glm::vec3& boxMax) const{
+        if(m_chunks.empty()){
+            return false;
+        }
+        glm::ivec3 lo(std::numeric_limits<int>::max()), hi(std::numeric_limits<int>::min());
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            lo = glm::min(lo, it->second.origin);
+            hi = glm::max(hi, it->second.origin);
+        }
+        boxMin = glm::vec3(lo) - glm::vec3(0.5f);
+        boxMax = glm::vec3(hi) - glm::vec3(0.5f) + glm::vec3(Chunk::SIZE);
+        return true;
+    }
+
+    void ChunkRenderer::cull(OcclusionCuller& culler, const glm::mat4& viewProjection, const glm::vec3& viewerPosition){
+        culler.beginFrame(viewProjection);
+
+        std::vector<std::pair<float, const VoxelBox*> > occluders;
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            const std::vector<VoxelBox>& boxes = it->second.occluders;
+            for(size_t i=0; i<boxes.size(); i++){
+                const glm::vec3 center = glm::vec3(boxes[i].position) + glm::vec3(boxes[i].size)*0.5f - glm::vec3(0.5f);
+                occluders.push_back(std::make_pair(glm::distance(center, viewerPosition), &boxes[i]));
+            }
+        }
+        const size_t count = std::min(occluders.size(), MAX_FRAME_OCCLUDERS);
+        std::partial_sort(occluders.begin(), occluders.begin() + count, occluders.end(),
+            [](const std::pair<float, const VoxelBox*>& l, const std::pair<float, const VoxelBox*>& r){
+                return l.first < r.first;
+            });
+        for(size_t i=0; i<count; i++){
+            const glm::vec3 boxMin = glm::vec3(occluders[i].second->position) - glm::vec3(0.5f);
+            culler.addOccluder(boxMin, boxMin + glm::vec3(occluders[i].second->size));
+        }
+        culler.buildPyramid();
+
+        m_visibleCount = 0;
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            const glm::vec3 boxMin = glm::vec3(it->second.origin) - glm::vec3(0.5f);
+            it->second.visible = culler.isVisible(boxMin, boxMin + glm::vec3(Chunk::SIZE));
+            if(it->second.visible){
+                m_visibleCount++;
+            }
+        }
+    }
+
+    void ChunkRenderer::draw(const std::vector<Texture>& textures){
+        // One command per visible submesh, grouped by material so that each texture is bound once
+        std::map<GLuint, std::vector<std::pair<DrawElementsIndirectCommand, glm::ivec4> > > materials;
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            const GPUChunk& chunk = it->second;
+            if(!chunk.visible){
+                continue;
+            }
+            for(size_t i=0; i<chunk.subMeshes.size(); i++){
+                const ChunkSubMesh& subMesh = chunk.subMeshes[i];
+                if(subMesh.value - 1 >= textures.size()){
+                    continue;
+                }
+                DrawElementsIndirectCommand command;
+                command.count = subMesh.indexCount;
+                command.instanceCount = 1;
+                command.firstIndex = chunk.indexOffset + subMesh.indexOffset;
+                command.baseVertex = chunk.vertexOffset;
+                command.baseInstance = 0;
+                materials[subMesh.value].push_back(std::make_pair(command, glm::ivec4(chunk.origin, chunk.lod)));
+            }
+        }
+        m_commands.clear();
+        m_instances.clear();
+        m_batches.clear();
+        for(auto it = materials.begin(); it != materials.end(); ++it){
+            for(size_t i=0; i<it->second.size(); i++){
+                // The instance attribute is fetched at baseInstance : the command's own origin
+                it->second[i].first.baseInstance = m_commands.size();
+                m_commands.push_back(it->second[i].first);
+                m_instances.push_back(it->second[i].second);
+            }
+            m_batches.push_back(std::make_pair(it->first, it->second.size()));
+        }
+
+        m_drawCallCount = 0;
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(m_vao);
+        // Origins and commands go through the upload ring, which is bound in place
+        GLintptr instances = UploadRing::INVALID, commands = UploadRing::INVALID;
+        if(m_multiDraw && !m_commands.empty()){
+            instances = m_uploads.write(m_instances.data(), m_instances.size()*sizeof(glm::ivec4));
+            commands = m_uploads.write(m_commands.data(), m_commands.size()*sizeof(DrawElementsIndirectCommand));
+        }
+        if(instances != UploadRing::INVALID && commands != UploadRing::INVALID){
+            glBindBuffer(GL_ARRAY_BUFFER, m_uploads.getBuffer());
+            glVertexAttribIPointer(VERTEX_ATTR_CHUNK_ORIGIN, 4, GL_INT, sizeof(glm::ivec4), (const GLvoid*)instances);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glEnableVertexAttribArray(VERTEX_ATTR_CHUNK_ORIGIN);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_uploads.getBuffer());
+
+            size_t first = 0;
+            for(size_t b=0; b<m_batches.size(); b++){
+                glBindTexture(GL_TEXTURE_2D, textures[m_batches[b].first - 1].getTexture());
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const GLvoid*)(commands + first*sizeof(DrawElementsIndirectCommand)), m_batches[b].second, 0);
+                first += m_batches[b].second;
+                m_drawCallCount++;
+            }
+            glDisableVertexAttribArray(VERTEX_ATTR_CHUNK_ORIGIN);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        else{
+            // Same commands, one call each, the origin being a constant attribute
+            size_t first = 0;
+            for(size_t b=0; b<m_batches.size(); b++){
+                glBindTexture(GL_TEXTURE_2D, textures[m_batches[b].first - 1].getTexture());
+                for(size_t i=first; i<first + m_batches[b].second; i++){
+                    const DrawElementsIndirectCommand& command = m_commands[i];
+                    const glm::ivec4& origin = m_instances[i];
+                    glVertexAttribI4i(VERTEX_ATTR_CHUNK_ORIGIN, origin.x, origin.y, origin.z, origin.w);
+                    glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, (const GLvoid*)(command.firstIndex*sizeof(uint32_t)), command.baseVertex);
+                    m_drawCallCount++;
+                }
+                first += m_batches[b].second;
+            }
+        }
+        glBindVertexArray(0);
+        m_uploads.endFrame();
+    }
+
+    void ChunkRenderer::drawDepth(const glm::mat4& viewProjection){
+        glBindVertexArray(m_vao);
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            const GPUChunk& chunk = it->second;
+            const glm::vec3 boxMin = glm::vec3(chunk.origin) - glm::vec3(0.5f);
+            if(chunk.indexCount == 0 || outsideClipVolume(viewProjection, boxMin, boxMin + glm::vec3(Chunk::SIZE))){
+                continue;
+            }
+            // Submeshes are contiguous : the whole chunk in one call
+            glVertexAttribI4i(VERTEX_ATTR_CHUNK_ORIGIN, chunk.origin.x, chunk.origin.y, chunk.origin.z, chunk.lod);
+            glDrawElementsBaseVertex(GL_TRIANGLES, chunk.indexCount, GL_UNSIGNED_INT, (const GLvoid*)(chunk.indexOffset*sizeof(uint32_t)), chunk.vertexOffset);
+        }
+        glBindVertexArray(0);
+    }
+
+}
@@ -24,6 +24,9 @@ Controls::Controls(){
     m_initialFoV = 45.0f;
 
     m_speed = 0.05f; 
+    m_moveSpeed = 3.0f;
+    m_turnSpeed = 1.5f;
+    m_aspectRatio = 4.0f / 3.0f;
 
     // Direction : Spherical coordinates to Cartesian coordinates conversion
 	m_direction = glm::vec3 (
@@ -41,32 +44,87 @@ Controls::Controls(){
 
 	// Up vector
     m_up = glm::cross( m_right, m_direction );
+
+    // Matrices computed on first use
+    m_vectorsDirty = false;
+    m_viewDirty = true;
+    m_projectionDirty = true;
 }
 
 void Controls::calculateVectors(){
-    
-    // Direction : Spherical coordinates to Cartesian coordinates conversion
-	m_direction = glm::vec3 (
-		cos(m_verticalAngle) * sin(m_horizontalAngle),
-		sin(m_verticalAngle),
-		cos(m_verticalAngle) * cos(m_horizontalAngle)
-	);
-
-	// Right vector
-	m_right = glm::vec3(
-		sin(m_horizontalAngle - 3.14f/2.0f),
-		0,
-		cos(m_horizontalAngle - 3.14f/2.0f)
-	);
+    update();
+}
 
-	// Up vector
-    m_up = glm::cross( m_right, m_direction );
+void Controls::computeFinalMatrices(){
+    update();
+}
+
+// Recompute only what the last changes invalidated
+void Controls::update() const{
+    if(m_vectorsDirty){
+        // Direction : Spherical coordinates to Cartesian coordinates conversion
+        m_direction = glm::vec3 (
+            cos(m_verticalAngle) * sin(m_horizontalAngle),
+            sin(m_verticalAngle),
+            cos(m_verticalAngle) * cos(m_horizontalAngle)
+        );
+
+        // Right vector
+        m_right = glm::vec3(
+            sin(m_horizontalAngle - 3.14f/2.0f),
+            0,
+            cos(m_horizontalAngle - 3.14f/2.0f)
+        );
+
+        // Up vector
+        m_up = glm::cross( m_right, m_direction );
+        m_vectorsDirty = false;
+        m_viewDirty = true;
+    }
+
+    if(m_projectionDirty){
+        float FoV = m_initialFoV;//  * MouseWheel();
+
+        // Projection matrix : 45° Field of View, window ratio, display range : 0.1 unit <-> 100 units
+        m_ProjectionMatrix = glm::perspective(glm::radians(FoV), m_aspectRatio, 0.1f, 100.0f);
+        m_projectionDirty = false;
+    }
+
+    if(m_viewDirty){
+        m_ViewMatrix = glm::lookAt(
+            m_position,           // Camera is here
+            m_position+m_direction, // and looks here : at the same position, plus "direction"
+            m_up                  // Head is up (set to 0,-1,0 to look upside-down)
+        );
+        m_viewDirty = false;
+    }
+}
+
+void Controls::move(glm::vec3 axes, float deltaTime){
+    if(axes == glm::vec3(0.0f)){
+        return;
+    }
+    update();
+    const float distance = m_moveSpeed * deltaTime;
+    m_position += (m_right * axes.x + m_up * axes.y + m_direction * axes.z) * distance;
+    m_viewDirty = true;
+}
+
+void Controls::turn(float horizontal, float vertical, float deltaTime){
+    if(horizontal == 0.0f && vertical == 0.0f){
+        return;
+    }
+    m_horizontalAngle += horizontal * m_turnSpeed * deltaTime;
+    m_verticalAngle += vertical * m_turnSpeed * deltaTime;
+    m_vectorsDirty = true;
 }
 
 glm::mat4 Controls::getViewMatrix() const{
+    update();
 	return this->m_ViewMatrix;
 }
 glm::mat4 Controls::getProjectionMatrix() const{
+    update();
 	return this->m_ProjectionMatrix;
 }
 
@@ -75,24 +133,30 @@ glm::vec3 Controls::getPosition() const{
 }
 void Controls::setPosition(glm::vec3 newPos){
     m_position = newPos;
+    m_viewDirty = true;
 }
 float Controls::getHorizontalAngle() const{
     return m_horizontalAngle;
 }
 void Controls::setHorizontalAngle(float newAngle){
     m_horizontalAngle = newAngle;
+    m_vectorsDirty = true;
 }
 float Controls::getVerticalAngle() const{
     return m_verticalAngle;
 }
 void Controls::setVerticalAngle(float newAngle){
     m_verticalAngle = newAngle;
+    m_vectorsDirty = true;
 }
 glm::vec3 Controls::getUp() const{
+    update();
     return m_up;
 }
 void Controls::setUp(glm::vec3 newVec){
+    update();
     m_up = newVec;
+    m_viewDirty = true;
 }
 float Controls::getSpeed() const{
     return m_speed;
@@ -101,33 +165,38 @@ void Controls::setSpeed(float newSpeed){
     m_speed = newSpeed;
 }
 glm::vec3 Controls::getRight() const{
+    update();
     return m_right;
 }
 void Controls::setRight(glm::vec3 newRight){
+    update();
     m_right = newRight;
 }
 glm::vec3 Controls::getDirection() const{
+    update();
     return m_direction;
 }
 void Controls::setDirection(glm::vec3 newDirection){
+    update();
     m_direction = newDirection;
-}
-
-void Controls::computeFinalMatrices(){
-
-	
-    float FoV = m_initialFoV;//  * MouseWheel();
-
-	// Projection matrix : 45° Field of View, 4:3 ratio, display range : 0.1 unit <-> 100 units
-    this->m_ProjectionMatrix = glm::perspective(glm::radians(FoV), 4.0f / 3.0f, 0.1f, 100.0f);
-
-    this->m_ViewMatrix = glm::lookAt(
-        m_position,           // Camera is here
-        m_position+m_direction, // and looks here : at the same position, plus "direction"
-        m_up                  // Head is up (set to 0,-1,0 to look upside-down)
-    );
-
-    return;
+    m_viewDirty = true;
+}
+void Controls::setAspectRatio(float aspectRatio){
+    if(aspectRatio != m_aspectRatio){
+        m_aspectRatio = aspectRatio;
+        m_projectionDirty = true;
+    }
+}
+
+void Controls::getRay(glm::ivec2 mousePosition, glm::vec4 viewport, glm::vec3& origin, glm::vec3& direction) const{
+    update();
+    // SDL puts the origin at the top left corner, OpenGL at the bottom left one
+    glm::vec3 screenNear((float)mousePosition.x, viewport.w - (float)mousePosition.y, 0.0f);
+    glm::vec3 screenFar((float)mousePosition.x, viewport.w - (float)mousePosition.y, 1.0f);
+    glm::vec3 nearPoint = glm::unProject(screenNear, m_ViewMatrix, m_ProjectionMatrix, viewport);
+    glm::vec3 farPoint = glm::unProject(screenFar, m_ViewMatrix, m_ProjectionMatrix, viewport);
+    origin = nearPoint;
+    direction = glm::normalize(farPoint - nearPoint);
 }
 
 }
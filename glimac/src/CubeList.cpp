@@ -10,56 +10,128 @@
  */
 
 #include "glimac/CubeList.hpp"
+#include "glimac/SceneSnapshot.hpp"
 
 
 namespace glimac {
 
+    namespace {
+        // Distance at which chunks switch to LOD 1, doubled for each next level
+        const float LOD_DISTANCE = 64.0f;
+        // Margin around each threshold, so that a viewer standing on it does not remesh every frame
+        const float LOD_HYSTERESIS = 8.0f;
+
+        int lodForDistance(float distance){
+            int lod = 0;
+            while(lod < ChunkMesh::MAX_LOD && distance >= LOD_DISTANCE*(1 << lod)){
+                lod++;
+            }
+            return lod;
+        }
+
+        int selectLOD(float distance, int current){
+            const int coarser = lodForDistance(distance - LOD_HYSTERESIS);
+            const int finer = lodForDistance(distance + LOD_HYSTERESIS);
+            if(coarser > current){
+                return coarser;
+            }
+            if(finer < current){
+                return finer;
+            }
+            return current;
+        }
+
+        float chunkDistance(int64_t key, const glm::vec3& viewerPosition){
+            const glm::vec3 center = glm::vec3(ChunkGrid::unpackKey(key)*Chunk::SIZE) + glm::vec3(Chunk::SIZE*0.5f - 0.5f);
+            return glm::distance(center, viewerPosition);
+        }
+    }
+
     // Créer liste (vecteur), ajouter/supprimer cube, trier cubes selon texture ?
-    CubeList::CubeList(){
+    CubeList::CubeList():
+        m_cubeVBO(0),
+        m_cubeVAO(0),
+        m_cubeIBO(0),
+        m_storage(new ChunkGrid()),
+        m_sparseStorage(false) {
         vboList.resize(1);
         vaoList.resize(1);
         iboList.resize(1);
     };
-    CubeList::~CubeList(){};
+    CubeList::~CubeList(){
+        if(m_cubeVAO){
+            glDeleteBuffers(1, &m_cubeIBO);
+            glDeleteVertexArrays(1, &m_cubeVAO);
+            glDeleteBuffers(1, &m_cubeVBO);
+        }
+    };
+
+    // Every cube has the same geometry (placed by its model matrix) : a single VBO/VAO/IBO is shared by all of them
+    void CubeList::createCubeBuffers(){
+        if(m_cubeVAO){
+            return;
+        }
+        Cube cube;
+        glGenBuffers(1, &m_cubeVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_cubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, cube.getVertexCount()*sizeof(Vertex3DTexture), cube.getDataPointer(), GL_STATIC_DRAW);
+
+        glGenVertexArrays(1, &m_cubeVAO);
+        glBindVertexArray(m_cubeVAO);
+        glEnableVertexAttribArray(VERTEX_ATTR_POSITION);
+        glVertexAttribPointer(VERTEX_ATTR_POSITION,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, position));
+        glEnableVertexAttribArray(VERTEX_ATTR_NORMAL);
+        glVertexAttribPointer(VERTEX_ATTR_NORMAL,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, normal));
+        glEnableVertexAttribArray(VERTEX_ATTR_TEXTURE);
+        glVertexAttribPointer(VERTEX_ATTR_TEXTURE,2,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, texture));
+
+        glGenBuffers(1, &m_cubeIBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, cube.getIBOCount()*sizeof(uint32_t), cube.getIBOPointer(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
     
     // Generate VBO
     void CubeList::generateVBO(){
+        createCubeBuffers();
         for(int i=0; i<m_cubeList.size(); i++){
-            glGenBuffers(1, &vboList[i+1]);
-            glBindBuffer(GL_ARRAY_BUFFER, vboList[i+1]);
-            glBufferData(GL_ARRAY_BUFFER, this->getVertexCount(i)*sizeof(Vertex3DTexture), this->getDataPointer(i), GL_STATIC_DRAW);
-            glBindBuffer(GL_ARRAY_BUFFER, vboList.back());
+            vboList[i+1] = m_cubeVBO;
         }
     };
 
     // Generate VAO
     void CubeList::generateVAO(){
+        createCubeBuffers();
         for(int i=0; i<m_cubeList.size(); i++){
-            glGenVertexArrays(1, &vaoList[i+1]);
-            glBindVertexArray(vaoList[i+1]);
-            glBindBuffer(GL_ARRAY_BUFFER, vboList[i+1]);
-            glEnableVertexAttribArray(VERTEX_ATTR_POSITION);
-            glVertexAttribPointer(VERTEX_ATTR_POSITION,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, position));
-            glEnableVertexAttribArray(VERTEX_ATTR_NORMAL);
-            glVertexAttribPointer(VERTEX_ATTR_NORMAL,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, normal));
-            glEnableVertexAttribArray(VERTEX_ATTR_TEXTURE);
-            glVertexAttribPointer(VERTEX_ATTR_TEXTURE,2,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, texture));
-
+            vaoList[i+1] = m_cubeVAO;
         }
     };
     
     // Generate IBO
     void CubeList::generateIBO(){
+        createCubeBuffers();
         for(int i=0; i<m_cubeList.size(); i++){
-            glGenBuffers(1, &iboList[i+1]);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboList[i+1]);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->getIBOCount(i)*sizeof(uint32_t), this->getIBOPointer(i), GL_STATIC_DRAW);
+            iboList[i+1] = m_cubeIBO;
         }
     };
 
     // Set texture
     void CubeList::setTextureIndex(int index, GLuint textureIndex){
+        if(index<0 || index>=(int)m_cubeList.size()){
+            return;
+        }
+        const GLuint previous = voxelValue(m_cubeList[index]);
         m_cubeList[index].setTextureIndex(textureIndex);
+        const glm::ivec3 position = voxelPosition(m_cubeList[index]);
+        auto it = m_stacked.find(ChunkGrid::packKey(position));
+        if(it != m_stacked.end()){
+            // Only this cube's entry changes, the cell still shows the last cube placed there
+            *std::find(it->second.rbegin(), it->second.rend(), previous) = voxelValue(m_cubeList[index]);
+            writeVoxel(position, it->second.back());
+            return;
+        }
+        writeVoxel(position, voxelValue(m_cubeList[index]));
     };
 
     // Set cube index
@@ -77,43 +149,167 @@ namespace glimac {
     }
     // Translate
     void CubeList::setTrans(GLuint cubeIndex, GLfloat x, GLfloat y, GLfloat z){
+        removeVoxel(m_cubeList[cubeIndex]);
         m_cubeList[cubeIndex].setTrans(x, y, z);
+        placeVoxel(m_cubeList[cubeIndex]);
+    }
+
+    // Mark a cube cell as occupied in the voxel grid
+    void CubeList::placeVoxel(const Cube& cube){
+        glm::ivec3 position = voxelPosition(cube);
+        const GLuint current = m_storage->get(position);
+        if(current != Chunk::EMPTY){
+            std::vector<GLuint>& stack = m_stacked[ChunkGrid::packKey(position)];
+            if(stack.empty()){
+                stack.push_back(current);
+            }
+            stack.push_back(voxelValue(cube));
+        }
+        writeVoxel(position, voxelValue(cube));
+    }
+
+    // Switch voxel backend, copying every voxel
+    void CubeList::setSparseStorage(bool sparse){
+        if(sparse == m_sparseStorage){
+            return;
+        }
+        std::vector<VoxelCell> cells;
+        m_storage->getCells(cells);
+        if(sparse){
+            m_storage.reset(new SparseVoxelOctree());
+        }else{
+            m_storage.reset(new ChunkGrid());
+        }
+        m_sparseStorage = sparse;
+        for(size_t i=0; i<cells.size(); i++){
+            for(int x=0; x<cells[i].size; x++){
+                for(int y=0; y<cells[i].size; y++){
+                    for(int z=0; z<cells[i].size; z++){
+                        m_storage->set(cells[i].position + glm::ivec3(x, y, z), cells[i].value);
+                    }
+                }
+            }
+        }
+    }
+
+    // Free a cube cell in the voxel grid, unless another cube still stands there
+    void CubeList::removeVoxel(const Cube& cube){
+        glm::ivec3 position = voxelPosition(cube);
+        auto it = m_stacked.find(ChunkGrid::packKey(position));
+        if(it != m_stacked.end()){
+            // The cell shows the last cube still placed there
+            std::vector<GLuint>& stack = it->second;
+            stack.erase(std::find(stack.rbegin(), stack.rend(), voxelValue(cube)).base() - 1);
+            const GLuint value = stack.back();
+            if(stack.size() == 1){
+                m_stacked.erase(it);
+            }
+            writeVoxel(position, value);
+            return;
+        }
+        writeVoxel(position, Chunk::EMPTY);
+    }
+
+    // Write a voxel, relight around it and schedule the meshes it appears in
+    void CubeList::writeVoxel(const glm::ivec3& position, GLuint value){
+        const GLuint previous = m_storage->get(position);
+        if(previous == value){
+            return;
+        }
+        m_storage->set(position, value);
+        markDirty(position);
+        m_light.update(*m_storage, position, previous, value);
+    }
+
+    // A voxel on a chunk border is also read (face culling, AO) by the neighbouring chunks
+    void CubeList::markDirty(const glm::ivec3& position){
+        const glm::ivec3 chunkCoord = ChunkGrid::toChunkCoord(position);
+        const glm::ivec3 local = ChunkGrid::toLocalCoord(position);
+        glm::ivec3 from, to;
+        for(int axis=0; axis<3; axis++){
+            from[axis] = (local[axis] == 0) ? -1 : 0;
+            to[axis] = (local[axis] == Chunk::SIZE-1) ? 1 : 0;
+        }
+        for(int x=from.x; x<=to.x; x++){
+            for(int y=from.y; y<=to.y; y++){
+                for(int z=from.z; z<=to.z; z++){
+                    m_dirtyChunks.insert(ChunkGrid::packKey(chunkCoord + glm::ivec3(x, y, z)));
+                }
+            }
+        }
+    }
+
+    // Rebuild the dirty chunks and the chunks crossing a LOD threshold only
+    void CubeList::updateMeshes(const glm::vec3& viewerPosition, JobSystem* jobs){
+        // Meshes reading a relit cell (chunks without a mesh have no face to relight)
+        const std::vector<int64_t> relit = m_light.takeChangedChunks();
+        for(size_t i=0; i<relit.size(); i++){
+            if(m_meshes.count(relit[i])){
+                m_dirtyChunks.insert(relit[i]);
+            }
+        }
+        for(auto it = m_meshes.begin(); it != m_meshes.end(); ++it){
+            if(selectLOD(chunkDistance(it->first, viewerPosition), it->second.getLOD()) != it->second.getLOD()){
+                m_dirtyChunks.insert(it->first);
+            }
+        }
+        // The meshes are created here : the builds below only write their own mesh (map nodes do not move)
+        std::vector<int64_t> keys(m_dirtyChunks.begin(), m_dirtyChunks.end());
+        std::vector<ChunkMesh*> meshes(keys.size());
+        std::vector<int> lods(keys.size());
+        for(size_t i=0; i<keys.size(); i++){
+            const float distance = chunkDistance(keys[i], viewerPosition);
+            auto existing = m_meshes.find(keys[i]);
+            lods[i] = (existing != m_meshes.end()) ? selectLOD(distance, existing->second.getLOD()) : lodForDistance(distance);
+            meshes[i] = &m_meshes[keys[i]];
+        }
+        // Storage and light are only read while meshing
+        auto build = [&](size_t i){
+            meshes[i]->build(*m_storage, ChunkGrid::unpackKey(keys[i]), lods[i], &m_light);
+        };
+        if(jobs){
+            jobs->parallelFor(0, keys.size(), 1, build);
+        }else{
+            for(size_t i=0; i<keys.size(); i++){
+                build(i);
+            }
+        }
+        for(size_t i=0; i<keys.size(); i++){
+            if(meshes[i]->isEmpty()){
+                m_meshes.erase(keys[i]);
+            }
+            m_updatedChunks.push_back(keys[i]);
+        }
+        m_dirtyChunks.clear();
+    }
+
+    std::vector<int64_t> CubeList::takeUpdatedChunks(){
+        std::vector<int64_t> updated;
+        updated.swap(m_updatedChunks);
+        return updated;
+    }
+
+    const ChunkMesh* CubeList::getChunkMesh(int64_t key) const{
+        auto it = m_meshes.find(key);
+        return (it == m_meshes.end()) ? nullptr : &it->second;
     }
 
     // Push back a new cube at the end of the list
     void CubeList::addCube(Cube cube){
         m_cubeList.push_back(cube);
         m_cubeList[m_cubeList.size()-1].setCubeIndex(m_cubeList.size()-1);
+        placeVoxel(m_cubeList.back());
 
-        // VBO
-        vboList.resize(vboList.size()+1);
-        glGenBuffers(1, &vboList[vboList.size()-1]);
-        glBindBuffer(GL_ARRAY_BUFFER, vboList[vboList.size()-1]);
-        glBufferData(GL_ARRAY_BUFFER, this->getVertexCount(this->getSize()-1)*sizeof(Vertex3DTexture), this->getDataPointer(this->getSize()-1), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, vboList.back());
-
-        //VAO
-        vaoList.resize(vaoList.size()+1);
-        glGenVertexArrays(1, &vaoList[vaoList.size()-1]);
-        glBindVertexArray(vaoList[vaoList.size()-1]);
-        glBindBuffer(GL_ARRAY_BUFFER, vboList[vaoList.size()-1]);
-        glEnableVertexAttribArray(VERTEX_ATTR_POSITION);
-        glVertexAttribPointer(VERTEX_ATTR_POSITION,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, position));
-        glEnableVertexAttribArray(VERTEX_ATTR_NORMAL);
-        glVertexAttribPointer(VERTEX_ATTR_NORMAL,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, normal));
-        glEnableVertexAttribArray(VERTEX_ATTR_TEXTURE);
-        glVertexAttribPointer(VERTEX_ATTR_TEXTURE,2,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, texture));
-
-        //IBO
-        iboList.resize(iboList.size()+1);
-        glGenBuffers(1, &iboList[iboList.size()-1]);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboList[iboList.size()-1]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->getIBOCount(this->getSize()-1)*sizeof(uint32_t), this->getIBOPointer(this->getSize()-1), GL_STATIC_DRAW);
+        // VBO/VAO/IBO : shared buffers, created by generateVBO/VAO/IBO on the thread owning the OpenGL context
+        vboList.push_back(m_cubeVBO);
+        vaoList.push_back(m_cubeVAO);
+        iboList.push_back(m_cubeIBO);
     }
 
     // Erase a cube at index "index" if exists
     void CubeList::deleteCube(int index){
-        if(index<=m_cubeList.size()){
+        if(index>=0 && index<(int)m_cubeList.size()){
+            removeVoxel(m_cubeList[index]);
             m_cubeList.erase(m_cubeList.begin()+index);
             std::cout<< "Erase cube " << index <<std::endl;
         }
@@ -121,19 +317,28 @@ namespace glimac {
             m_cubeList[i].setCubeIndex(i);
         }
 
-        // Reset VBO/VAO/IBO
-        if(index<=vboList.size()+1){
-            glDeleteBuffers(1, &iboList[index+1]);
+        // Reset VBO/VAO/IBO (shared buffers, nothing to free)
+        if(index+1<(int)vboList.size()){
             iboList.erase(iboList.begin()+index+1);
-            glDeleteVertexArrays(1, &vaoList[index+1]);
             vaoList.erase(vaoList.begin()+index+1);
-            glDeleteBuffers(1, &vboList[index+1]);
             vboList.erase(vboList.begin()+index+1);
         }
 
         
     }
 
+    // Erase the last cube, no other index moves
+    void CubeList::popCube(){
+        if(m_cubeList.empty()){
+            return;
+        }
+        removeVoxel(m_cubeList.back());
+        m_cubeList.pop_back();
+        iboList.pop_back();
+        vaoList.pop_back();
+        vboList.pop_back();
+    }
+
     // Sort cubes according to texture
     void CubeList::sortCubes(){
         std::sort(m_cubeList.begin(), m_cubeList.end(), std::greater<Cube>());
@@ -191,8 +396,11 @@ namespace glimac {
 
     //Entrée: x et y random dans l'enceinte de la grille -- Sortie : z calculé grâce aux poids trouvés au-dessus
     double CubeList::interpolatePoints(double x, double z, Eigen::MatrixXd points, std::string rbf, float epsilon){
+        return interpolatePoints(x, z, points, radialBasisFunction(points, rbf, epsilon));
+    }
+
+    double CubeList::interpolatePoints(double x, double z, const Eigen::MatrixXd& points, const Eigen::VectorXd& w){
         double y=0;
-        Eigen::VectorXd w = this->radialBasisFunction(points, rbf, epsilon);
         for(int i=0; i<points.rows(); i++){
             double distance = sqrt(pow(points(i,0) - x, 2) +  
                 pow(points(i,2) - z, 2) +  
@@ -203,33 +411,15 @@ namespace glimac {
     }
 
     void CubeList::save(std::string filepath, int item_LightD, std::vector<int> positionLightD, int item_LightP, std::vector<int> positionLightP, std::vector<int> lightIntensity){
-        std::ofstream file;
-        file.open(filepath);
-        if (!file) {
-                std::cout << "Unable to open file";
-                exit(1); // terminate with error
-            }
-        for(int i=0; i<m_cubeList.size(); i++){
-            file << std::to_string(m_cubeList[i].getCubeIndex())+" "
-            +std::to_string((int)m_cubeList[i].getTrans().x)+" "
-            +std::to_string((int)m_cubeList[i].getTrans().y)+" "
-            +std::to_string((int)m_cubeList[i].getTrans().z)+" "
-            +std::to_string(m_cubeList[i].getTextureIndex())+" "+"\n";
-        }
-        // Write lights
-        file << std::to_string(item_LightD)+" "
-        +std::to_string(positionLightD[0])+" "
-        +std::to_string(positionLightD[1])+" "
-        +std::to_string(positionLightD[2])+" "
-        +std::to_string(lightIntensity[0])+"\n";
-
-        file << std::to_string(item_LightP)+" "
-        +std::to_string(positionLightP[0])+" "
-        +std::to_string(positionLightP[1])+" "
-        +std::to_string(positionLightP[2])+" "
-        +std::to_string(lightIntensity[1])+"\n";
-        
-        file.close();
+        SceneLights lights;
+        lights.item_LightD = item_LightD;
+        lights.positionLightD = positionLightD;
+        lights.item_LightP = item_LightP;
+        lights.positionLightP = positionLightP;
+        lights.lightIntensity = lightIntensity;
+        if(!writeSceneFile(filepath, *SceneSnapshot::capture(*this, lights))){
+            exit(1); // terminate with error
+        }
     };
 
     void CubeList::read(std::string filePath, std::vector<int> &destination){
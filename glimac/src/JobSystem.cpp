@@ -0,0 +1,129 @@
+/**
+ * \file JobSystem.cpp
+ * \brief Système de tâches à vol de travail
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Petites tâches de l'image (remaillage des blocs) réparties sur tous les coeurs, chaque thread
+ * ayant sa propre file et volant celles des autres quand elle est vide
+ *
+ */
+
+#include "glimac/JobSystem.hpp"
+
+namespace glimac {
+
+    namespace {
+        // Queue of the calling thread, set on the workers of each system
+        thread_local const JobSystem* t_system = nullptr;
+        thread_local size_t t_queue = 0;
+    }
+
+    JobSystem::JobSystem(unsigned int workerCount):
+        m_queuedJobs(0),
+        m_stealCount(0),
+        m_stopping(false) {
+        if(workerCount == 0){
+            // hardware_concurrency may answer 0 when unknown
+            const unsigned int cores = std::thread::hardware_concurrency();
+            workerCount = (cores > 1) ? cores - 1 : 1;
+        }
+        for(unsigned int i=0; i<=workerCount; i++){
+            m_queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+        }
+        for(unsigned int i=1; i<=workerCount; i++){
+            m_workers.push_back(std::thread(&JobSystem::work, this, i));
+        }
+    }
+
+    JobSystem::~JobSystem(){
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for(size_t i=0; i<m_workers.size(); i++){
+            m_workers[i].join();
+        }
+    }
+
+    size_t JobSystem::currentQueue() const{
+        return (t_system == this) ? t_queue : 0;
+    }
+
+    void JobSystem::run(JobGroup& group, std::function<void()> job){
+        group.m_pending++;
+        WorkQueue& queue = *m_queues[currentQueue()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            Job entry = {std::move(job), &group};
+            queue.jobs.push_back(std::move(entry));
+        }
+        m_queuedJobs++;
+        // Taking the lock orders this push before a worker going to sleep checks m_queuedJobs
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wake.notify_one();
+    }
+
+    bool JobSystem::runOne(size_t queue){
+        Job job;
+        bool found = false;
+        {
+            // Own queue first, newest job
+            WorkQueue& own = *m_queues[queue];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.jobs.empty()){
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                found = true;
+            }
+        }
+        // Then the oldest job of another queue, the next ones first to spread the thieves
+        for(size_t i=1; !found && i<m_queues.size(); i++){
+            WorkQueue& victim = *m_queues[(queue + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if(!victim.jobs.empty()){
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                found = true;
+                m_stealCount++;
+            }
+        }
+        if(!found){
+            return false;
+        }
+        m_queuedJobs--;
+        job.function();
+        job.group->m_pending--;
+        return true;
+    }
+
+    void JobSystem::wait(JobGroup& group){
+        const size_t queue = currentQueue();
+        while(!group.isDone()){
+            // Nothing left to take : the last jobs of the group are running on other threads
+            if(!runOne(queue)){
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::work(size_t queue){
+        t_system = this;
+        t_queue = queue;
+        while(true){
+            if(runOne(queue)){
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this](){ return m_stopping || m_queuedJobs.load() > 0; });
+            if(m_stopping && m_queuedJobs.load() == 0){
+                return;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,189 @@
+/**
+ * \file LightClusters.cpp
+ * \brief Répartition des lumières ponctuelles en clusters
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Eclairage forward par clusters : les lumières ponctuelles sont réparties chaque image dans une grille
+ * de l'espace View, le fragment shader ne parcourt que les lumières de son cluster
+ *
+ */
+
+#include "glimac/LightClusters.hpp"
+#include <limits>
+
+namespace glimac {
+
+    namespace {
+        const int CLUSTER_COUNT = LightClusters::GRID_X*LightClusters::GRID_Y*LightClusters::GRID_Z;
+        const GLenum TEXTURE_FORMATS[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+        const char* SAMPLER_NAMES[3] = { "uLightData", "uClusterRanges", "uLightIndices" };
+    }
+
+    const int LightClusters::GRID_X;
+    const int LightClusters::GRID_Y;
+    const int LightClusters::GRID_Z;
+    const int LightClusters::MAX_LIGHTS;
+    const int LightClusters::MAX_LIGHT_INDICES;
+    const GLuint LightClusters::FIRST_TEXTURE_UNIT;
+
+    LightClusters::LightClusters():
+        m_near(0.1f),
+        m_far(100.0f),
+        m_sliceScale(0.0f),
+        m_lightCount(0),
+        m_grid(2*CLUSTER_COUNT, 0) {
+        const GLsizeiptr sizes[3] = {
+            GLsizeiptr(2*MAX_LIGHTS*sizeof(glm::vec4)),
+            GLsizeiptr(2*CLUSTER_COUNT*sizeof(GLuint)),
+            GLsizeiptr(MAX_LIGHT_INDICES*sizeof(GLushort))
+        };
+        glGenBuffers(3, m_buffers);
+        glGenTextures(3, m_textures);
+        for(int i=0; i<3; i++){
+            // Fixed size : the frame only updates the buffers
+            glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, sizes[i], nullptr, GL_DYNAMIC_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, TEXTURE_FORMATS[i], m_buffers[i]);
+        }
+        // An empty grid until the first update
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[1]);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_grid.size()*sizeof(GLuint), m_grid.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    LightClusters::~LightClusters(){
+        glDeleteTextures(3, m_textures);
+        glDeleteBuffers(3, m_buffers);
+    }
+
+    // Exponential slices : a cluster is about as deep as it is wide at every distance
+    int LightClusters::sliceOf(float depth) const{
+        if(depth <= m_near){
+            return 0;
+        }
+        return glm::clamp(int(std::log(depth/m_near)*m_sliceScale), 0, GRID_Z-1);
+    }
+
+    void LightClusters::update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection){
+        // Planes of a perspective matrix
+        m_near = projection[3][2]/(projection[2][2] - 1.0f);
+        m_far = projection[3][2]/(projection[2][2] + 1.0f);
+        m_sliceScale = GRID_Z/std::log(m_far/m_near);
+
+        m_lightData.clear();
+        m_ranges.clear();
+        std::fill(m_grid.begin(), m_grid.end(), 0);
+        m_lightCount = std::min(lights.size(), size_t(MAX_LIGHTS));
+
+        // Clusters touched by each light : depth range of the sphere, screen rectangle of its bounding box
+        for(size_t i=0; i<m_lightCount; i++){
+            const PointLight& light = lights[i];
+            const glm::vec3 center = glm::vec3(view*glm::vec4(light.position, 1.0f));
+            const float radius = light.radius;
+            m_lightData.push_back(glm::vec4(center, radius));
+            m_lightData.push_back(glm::vec4(light.color*light.intensity, 0.0f));
+
+            const float closest = -center.z - radius;
+            const float farthest = -center.z + radius;
+            if(light.intensity <= 0.0f || farthest <= m_near || closest >= m_far){
+                m_ranges.push_back(glm::ivec3(1));
+                m_ranges.push_back(glm::ivec3(0));
+                continue;
+            }
+            glm::ivec3 first(0, 0, sliceOf(closest));
+            glm::ivec3 last(GRID_X-1, GRID_Y-1, sliceOf(farthest));
+            if(closest > m_near){
+                glm::vec2 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+                for(int c=0; c<8; c++){
+                    const glm::vec3 corner = center + radius*glm::vec3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+                    const glm::vec4 clip = projection*glm::vec4(corner, 1.0f);
+                    const glm::vec2 ndc = glm::vec2(clip)/clip.w;
+                    lo = glm::min(lo, ndc);
+                    hi = glm::max(hi, ndc);
+                }
+                if(hi.x < -1.0f || hi.y < -1.0f || lo.x > 1.0f || lo.y > 1.0f){
+                    m_ranges.push_back(glm::ivec3(1));
+                    m_ranges.push_back(glm::ivec3(0));
+                    continue;
+                }
+                const glm::vec2 grid(GRID_X, GRID_Y);
+                first = glm::ivec3(glm::clamp(glm::ivec2(glm::floor((lo*0.5f + 0.5f)*grid)), glm::ivec2(0), glm::ivec2(GRID_X-1, GRID_Y-1)), first.z);
+                last = glm::ivec3(glm::clamp(glm::ivec2(glm::floor((hi*0.5f + 0.5f)*grid)), glm::ivec2(0), glm::ivec2(GRID_X-1, GRID_Y-1)), last.z);
+            }
+            m_ranges.push_back(first);
+            m_ranges.push_back(last);
+            for(int z=first.z; z<=last.z; z++){
+                for(int y=first.y; y<=last.y; y++){
+                    for(int x=first.x; x<=last.x; x++){
+                        m_grid[2*((z*GRID_Y + y)*GRID_X + x) + 1]++;
+                    }
+                }
+            }
+        }
+
+        // Prefix sum : each cluster gets a contiguous run of light indices (the last ones are cut on overflow)
+        GLuint offset = 0;
+        for(int c=0; c<CLUSTER_COUNT; c++){
+            const GLuint count = std::min(m_grid[2*c + 1], GLuint(MAX_LIGHT_INDICES) - offset);
+            m_grid[2*c] = offset;
+            m_grid[2*c + 1] = count;
+            offset += count;
+        }
+        // The count is used as a cursor from the end of the run, then restored
+        m_indices.assign(offset, 0);
+        for(size_t i=0; i<m_lightCount; i++){
+            const glm::ivec3& first = m_ranges[2*i];
+            const glm::ivec3& last = m_ranges[2*i + 1];
+            for(int z=first.z; z<=last.z; z++){
+                for(int y=first.y; y<=last.y; y++){
+                    for(int x=first.x; x<=last.x; x++){
+                        GLuint* cluster = &m_grid[2*((z*GRID_Y + y)*GRID_X + x)];
+                        if(cluster[1] > 0){
+                            m_indices[cluster[0] + --cluster[1]] = GLushort(i);
+                        }
+                    }
+                }
+            }
+        }
+        for(int c=0; c<CLUSTER_COUNT; c++){
+            const GLuint end = (c + 1 < CLUSTER_COUNT) ? m_grid[2*(c + 1)] : offset;
+            m_grid[2*c + 1] = end - m_grid[2*c];
+        }
+
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[0]);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_lightData.size()*sizeof(glm::vec4), m_lightData.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[1]);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_grid.size()*sizeof(GLuint), m_grid.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[2]);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_indices.size()*sizeof(GLushort), m_indices.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void LightClusters::bind() const{
+        for(int i=0; i<3; i++){
+            glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + i);
+            glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void LightClusters::fillFrameData(FrameData& frame) const{
+        frame.clusterGrid = glm::vec4(GRID_X, GRID_Y, GRID_Z, m_lightCount);
+        frame.clusterDepth = glm::vec4(m_near, m_far, m_sliceScale, 0.0f);
+    }
+
+    // Buffer samplers must not share texture unit 0 with the 2D sampler
+    void LightClusters::bindSamplers(GLuint program){
+        for(int i=0; i<3; i++){
+            const GLint location = glGetUniformLocation(program, SAMPLER_NAMES[i]);
+            if(location != -1){
+                glUniform1i(location, FIRST_TEXTURE_UNIT + i);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,97 @@
+/**
+ * \file MappedFile.cpp
+ * \brief Fichier projeté en mémoire
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Lecture d'un fichier entier sans copie, par projection en mémoire
+ *
+ */
+
+#include "glimac/MappedFile.hpp"
+
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace glimac {
+
+    MappedFile::MappedFile():
+        m_data(nullptr),
+        m_size(0) {
+    }
+
+    MappedFile::~MappedFile(){
+        close();
+    }
+
+    bool getFileStamp(const FilePath& filepath, uint64_t& size, int64_t& time){
+        struct stat status;
+        if(stat(filepath.c_str(), &status) != 0){
+            return false;
+        }
+        size = status.st_size;
+        time = status.st_mtime;
+        return true;
+    }
+
+#ifndef _WIN32
+    bool MappedFile::open(const FilePath& filepath){
+        close();
+        const int descriptor = ::open(filepath.c_str(), O_RDONLY);
+        if(descriptor < 0){
+            return false;
+        }
+        struct stat status;
+        if(fstat(descriptor, &status) != 0 || status.st_size <= 0){
+            ::close(descriptor);
+            return false;
+        }
+        void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        // The mapping keeps the file alive on its own
+        ::close(descriptor);
+        if(mapping == MAP_FAILED){
+            return false;
+        }
+        m_data = (const unsigned char*)mapping;
+        m_size = status.st_size;
+        return true;
+    }
+
+    void MappedFile::close(){
+        if(m_data){
+            munmap((void*)m_data, m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+#else
+    bool MappedFile::open(const FilePath& filepath){
+        close();
+        std::ifstream input(filepath.c_str(), std::ios::binary | std::ios::ate);
+        if(!input || input.tellg() <= 0){
+            return false;
+        }
+        m_buffer.resize((size_t)input.tellg());
+        input.seekg(0);
+        if(!input.read((char*)m_buffer.data(), m_buffer.size())){
+            m_buffer.clear();
+            return false;
+        }
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+        return true;
+    }
+
+    void MappedFile::close(){
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+
+}
@@ -0,0 +1,432 @@
+/**
+ * \file MeshBVH.cpp
+ * \brief Hiérarchie de volumes englobants des maillages
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * BVH des triangles d'un maillage importé (heuristique des surfaces, SAH), pour la sélection à la
+ * souris et les tests de collision ; uniquement sur le CPU
+ *
+ */
+
+#include "glimac/MeshBVH.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace glimac {
+
+    namespace {
+        // Deeper nodes become leaves : the traversal stacks are fixed arrays
+        const int MAX_DEPTH = 60;
+        // Ranges smaller than this are not worth a task
+        const uint32_t MIN_PARALLEL_SIZE = 4096;
+        // SAH costs, relative to one ray/triangle test
+        const float TRAVERSAL_COST = 1.0f;
+
+        struct Box {
+            glm::vec3 min, max;
+
+            Box():
+                min(std::numeric_limits<float>::max()),
+                max(-std::numeric_limits<float>::max()) {}
+
+            void grow(const glm::vec3& point){
+                min = glm::min(min, point);
+                max = glm::max(max, point);
+            }
+            void grow(const Box& box){
+                min = glm::min(min, box.min);
+                max = glm::max(max, box.max);
+            }
+            float area() const{
+                const glm::vec3 size = max - min;
+                if(size.x < 0.0f || size.y < 0.0f || size.z < 0.0f){
+                    return 0.0f;
+                }
+                return 2.0f*(size.x*size.y + size.y*size.z + size.z*size.x);
+            }
+        };
+
+        struct TriangleBounds {
+            Box box;
+            glm::vec3 centroid;
+        };
+
+        struct Subtree {
+            uint32_t node, begin, end;
+            int depth;
+        };
+
+        struct Bin {
+            Box box;
+            uint32_t count;
+        };
+
+        // Builds the node 'root' over triangles[begin, end) ; with 'deferred', the nodes reaching
+        // deferDepth only get their bounds and are listed to be built by another call
+        void buildNodes(std::vector<BVHNode>& nodes, uint32_t root, uint32_t begin, uint32_t end, int rootDepth,
+                        uint32_t* triangles, const std::vector<TriangleBounds>& bounds, int deferDepth, std::vector<Subtree>* deferred){
+            std::vector<Subtree> stack(1);
+            stack[0].node = root;
+            stack[0].begin = begin;
+            stack[0].end = end;
+            stack[0].depth = rootDepth;
+            while(!stack.empty()){
+                const Subtree item = stack.back();
+                stack.pop_back();
+                const uint32_t count = item.end - item.begin;
+
+                Box box, centroids;
+                for(uint32_t i=item.begin; i<item.end; i++){
+                    box.grow(bounds[triangles[i]].box);
+                    centroids.grow(bounds[triangles[i]].centroid);
+                }
+                nodes[item.node].boundsMin = box.min;
+                nodes[item.node].boundsMax = box.max;
+                nodes[item.node].first = item.begin;
+                nodes[item.node].count = count;
+
+                if(deferred && item.depth == deferDepth && count > MIN_PARALLEL_SIZE){
+                    deferred->push_back(item);
+                    continue;
+                }
+                if(count <= 1 || item.depth >= MAX_DEPTH){
+                    continue;
+                }
+
+                // Binned SAH : cost of each plane between two bins of the centroids, on the three axes
+                int bestAxis = -1, bestPlane = 0;
+                float bestCost = std::numeric_limits<float>::max();
+                const glm::vec3 extent = centroids.max - centroids.min;
+                for(int axis=0; axis<3; axis++){
+                    if(extent[axis] <= 0.0f){
+                        continue;
+                    }
+                    Bin bins[MeshBVH::BIN_COUNT];
+                    for(int b=0; b<MeshBVH::BIN_COUNT; b++){
+                        bins[b].count = 0;
+                    }
+                    const float scale = MeshBVH::BIN_COUNT/extent[axis];
+                    for(uint32_t i=item.begin; i<item.end; i++){
+                        const TriangleBounds& triangle = bounds[triangles[i]];
+                        const int b = std::min(MeshBVH::BIN_COUNT - 1, int((triangle.centroid[axis] - centroids.min[axis])*scale));
+                        bins[b].box.grow(triangle.box);
+                        bins[b].count++;
+                    }
+                    // Left sides sweeping forward, then right sides sweeping back
+                    float leftCost[MeshBVH::BIN_COUNT - 1];
+                    Box left;
+                    uint32_t leftCount = 0;
+                    for(int plane=0; plane<MeshBVH::BIN_COUNT - 1; plane++){
+                        left.grow(bins[plane].box);
+                        leftCount += bins[plane].count;
+                        leftCost[plane] = left.area()*leftCount;
+                    }
+                    Box right;
+                    uint32_t rightCount = 0;
+                    for(int plane=MeshBVH::BIN_COUNT - 2; plane>=0; plane--){
+                        right.grow(bins[plane + 1].box);
+                        rightCount += bins[plane + 1].count;
+                        const float cost = leftCost[plane] + right.area()*rightCount;
+                        if(rightCount > 0 && rightCount < count && cost < bestCost){
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestPlane = plane;
+                        }
+                    }
+                }
+                // All centroids at the same place : no plane separates them
+                if(bestAxis < 0){
+                    continue;
+                }
+                const float area = box.area();
+                const float splitCost = TRAVERSAL_COST + (area > 0.0f ? bestCost/area : 0.0f);
+                if(splitCost >= float(count) && count <= MeshBVH::MAX_LEAF_SIZE){
+                    continue;
+                }
+
+                const float scale = MeshBVH::BIN_COUNT/extent[bestAxis];
+                const float minimum = centroids.min[bestAxis];
+                uint32_t* middle = std::partition(triangles + item.begin, triangles + item.end, [&](uint32_t triangle){
+                    return std::min(MeshBVH::BIN_COUNT - 1, int((bounds[triangle].centroid[bestAxis] - minimum)*scale)) <= bestPlane;
+                });
+                const uint32_t split = middle - triangles;
+
+                // Both children side by side
+                const uint32_t child = nodes.size();
+                nodes.resize(child + 2);
+                nodes[item.node].first = child;
+                nodes[item.node].count = 0;
+                Subtree leftChild = {child, item.begin, split, item.depth + 1};
+                Subtree rightChild = {child + 1, split, item.end, item.depth + 1};
+                stack.push_back(rightChild);
+                stack.push_back(leftChild);
+            }
+        }
+
+        // Slab test, entry distance in 'entry'
+        bool hitBox(const BVHNode& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& entry){
+            const glm::vec3 t0 = (node.boundsMin - origin)*inverseDirection;
+            const glm::vec3 t1 = (node.boundsMax - origin)*inverseDirection;
+            const glm::vec3 near = glm::min(t0, t1);
+            const glm::vec3 far = glm::max(t0, t1);
+            entry = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+            const float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+            return entry <= exit;
+        }
+
+        bool overlapsBox(const BVHNode& node, const glm::vec3& boxMin, const glm::vec3& boxMax){
+            return node.boundsMin.x <= boxMax.x && node.boundsMax.x >= boxMin.x
+                && node.boundsMin.y <= boxMax.y && node.boundsMax.y >= boxMin.y
+                && node.boundsMin.z <= boxMax.z && node.boundsMax.z >= boxMin.z;
+        }
+
+        // Projection of the triangle on an axis against the projection of the box (centered)
+        bool separates(const glm::vec3& axis, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& halfSize){
+            const float pa = glm::dot(axis, a), pb = glm::dot(axis, b), pc = glm::dot(axis, c);
+            const float radius = glm::dot(halfSize, glm::abs(axis));
+            return std::min(pa, std::min(pb, pc)) > radius || std::max(pa, std::max(pb, pc)) < -radius;
+        }
+    }
+
+    MeshBVH::MeshBVH():
+        m_vertices(nullptr),
+        m_indices(nullptr),
+        m_nodes(nullptr),
+        m_triangles(nullptr),
+        m_nodeCount(0),
+        m_triangleCount(0),
+        m_subtreeCount(0) {
+    }
+
+    void MeshBVH::build(const ShapeVertex* vertices, const uint32_t* indices, uint32_t triangleCount, ThreadPool* pool){
+        m_builtNodes.clear();
+        m_builtTriangles.resize(triangleCount);
+        m_subtreeCount = 0;
+        std::vector<TriangleBounds> bounds(triangleCount);
+        for(uint32_t t=0; t<triangleCount; t++){
+            const glm::vec3& a = vertices[indices[3*t]].position;
+            const glm::vec3& b = vertices[indices[3*t + 1]].position;
+            const glm::vec3& c = vertices[indices[3*t + 2]].position;
+            bounds[t].box.grow(a);
+            bounds[t].box.grow(b);
+            bounds[t].box.grow(c);
+            bounds[t].centroid = (a + b + c)/3.0f;
+            m_builtTriangles[t] = t;
+        }
+
+        if(triangleCount){
+            // The top levels are split here, deep enough to give every thread a few subtrees
+            int deferDepth = -1;
+            if(pool){
+                deferDepth = 1;
+                for(unsigned threads = pool->getThreadCount() + 1; threads > 1; threads /= 2){
+                    deferDepth++;
+                }
+            }
+            std::vector<Subtree> subtrees;
+            m_builtNodes.resize(1);
+            buildNodes(m_builtNodes, 0, 0, triangleCount, 0, m_builtTriangles.data(), bounds, deferDepth, pool ? &subtrees : nullptr);
+            m_subtreeCount = subtrees.size();
+
+            // Each subtree is built apart (root at 0), this thread takes the first one
+            std::vector<std::vector<BVHNode> > built(subtrees.size(), std::vector<BVHNode>(1));
+            std::vector<std::future<void> > pending;
+            for(size_t s=1; s<subtrees.size(); s++){
+                const Subtree subtree = subtrees[s];
+                std::vector<BVHNode>* nodes = &built[s];
+                uint32_t* triangles = m_builtTriangles.data();
+                const std::vector<TriangleBounds>* triangleBounds = &bounds;
+                pending.push_back(pool->submit([subtree, nodes, triangles, triangleBounds](){
+                    buildNodes(*nodes, 0, subtree.begin, subtree.end, subtree.depth, triangles, *triangleBounds, -1, nullptr);
+                }));
+            }
+            if(!subtrees.empty()){
+                buildNodes(built[0], 0, subtrees[0].begin, subtrees[0].end, subtrees[0].depth, m_builtTriangles.data(), bounds, -1, nullptr);
+            }
+            for(size_t i=0; i<pending.size(); i++){
+                pending[i].get();
+            }
+
+            // Splice : the subtree root replaces its placeholder, the other nodes are appended
+            for(size_t s=0; s<subtrees.size(); s++){
+                std::vector<BVHNode>& nodes = built[s];
+                const uint32_t offset = m_builtNodes.size() - 1;
+                for(size_t n=0; n<nodes.size(); n++){
+                    if(nodes[n].count == 0){
+                        nodes[n].first += offset;
+                    }
+                }
+                m_builtNodes[subtrees[s].node] = nodes[0];
+                m_builtNodes.insert(m_builtNodes.end(), nodes.begin() + 1, nodes.end());
+            }
+        }
+
+        attach(vertices, indices, m_builtNodes.data(), m_builtNodes.size(), m_builtTriangles.data(), triangleCount);
+    }
+
+    void MeshBVH::attach(const ShapeVertex* vertices, const uint32_t* indices, const BVHNode* nodes, uint32_t nodeCount, const uint32_t* triangles, uint32_t triangleCount){
+        m_vertices = vertices;
+        m_indices = indices;
+        m_nodes = nodes;
+        m_nodeCount = nodeCount;
+        m_triangles = triangles;
+        m_triangleCount = triangleCount;
+    }
+
+    bool MeshBVH::isValid(uint32_t vertexCount) const{
+        if((m_nodeCount == 0) != (m_triangleCount == 0)){
+            return false;
+        }
+        for(uint32_t i=0; i<3*m_triangleCount; i++){
+            if(m_indices[i] >= vertexCount){
+                return false;
+            }
+        }
+        for(uint32_t i=0; i<m_triangleCount; i++){
+            if(m_triangles[i] >= m_triangleCount){
+                return false;
+            }
+        }
+        // Children always follow their parent : the traversals terminate, depth bounded by the stacks
+        std::vector<int> depth(m_nodeCount, 0);
+        for(uint32_t n=0; n<m_nodeCount; n++){
+            const BVHNode& node = m_nodes[n];
+            if(node.count == 0){
+                if(node.first <= n || node.first + 1 >= m_nodeCount || depth[n] >= MAX_DEPTH){
+                    return false;
+                }
+                depth[node.first] = depth[node.first + 1] = depth[n] + 1;
+            }else if(node.first > m_triangleCount || node.count > m_triangleCount - node.first){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool MeshBVH::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, MeshRayHit& hit) const{
+        if(m_nodeCount == 0){
+            return false;
+        }
+        const glm::vec3 inverseDirection = 1.0f/direction;
+        float closest = maxDistance;
+        bool found = false;
+        float entry;
+        uint32_t stack[MAX_DEPTH + 2];
+        int stackSize = 0;
+        if(hitBox(m_nodes[0], origin, inverseDirection, closest, entry)){
+            stack[stackSize++] = 0;
+        }
+        while(stackSize){
+            const BVHNode& node = m_nodes[stack[--stackSize]];
+            if(node.count){
+                // Möller-Trumbore, both faces
+                for(uint32_t i=node.first; i<node.first + node.count; i++){
+                    const uint32_t triangle = m_triangles[i];
+                    const glm::vec3& a = m_vertices[m_indices[3*triangle]].position;
+                    const glm::vec3 edge1 = m_vertices[m_indices[3*triangle + 1]].position - a;
+                    const glm::vec3 edge2 = m_vertices[m_indices[3*triangle + 2]].position - a;
+                    const glm::vec3 p = glm::cross(direction, edge2);
+                    const float determinant = glm::dot(edge1, p);
+                    if(determinant == 0.0f){
+                        continue;
+                    }
+                    const float inverse = 1.0f/determinant;
+                    const glm::vec3 s = origin - a;
+                    const float u = glm::dot(s, p)*inverse;
+                    if(u < 0.0f || u > 1.0f){
+                        continue;
+                    }
+                    const glm::vec3 q = glm::cross(s, edge1);
+                    const float v = glm::dot(direction, q)*inverse;
+                    if(v < 0.0f || u + v > 1.0f){
+                        continue;
+                    }
+                    const float t = glm::dot(edge2, q)*inverse;
+                    if(t < 0.0f || t >= closest){
+                        continue;
+                    }
+                    closest = t;
+                    found = true;
+                    hit.triangle = triangle;
+                    hit.distance = t;
+                    hit.normal = glm::normalize(glm::cross(edge1, edge2));
+                }
+                continue;
+            }
+            // Nearest child on top of the stack, the other one may be skipped once a closer hit is found
+            float leftEntry, rightEntry;
+            const bool left = hitBox(m_nodes[node.first], origin, inverseDirection, closest, leftEntry);
+            const bool right = hitBox(m_nodes[node.first + 1], origin, inverseDirection, closest, rightEntry);
+            if(left && right){
+                const bool leftFirst = leftEntry <= rightEntry;
+                stack[stackSize++] = leftFirst ? node.first + 1 : node.first;
+                stack[stackSize++] = leftFirst ? node.first : node.first + 1;
+            }else if(left){
+                stack[stackSize++] = node.first;
+            }else if(right){
+                stack[stackSize++] = node.first + 1;
+            }
+        }
+        if(found && glm::dot(hit.normal, direction) > 0.0f){
+            hit.normal = -hit.normal;
+        }
+        return found;
+    }
+
+    size_t MeshBVH::queryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& triangles) const{
+        if(m_nodeCount == 0){
+            return 0;
+        }
+        const size_t initialSize = triangles.size();
+        uint32_t stack[MAX_DEPTH + 2];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize){
+            const BVHNode& node = m_nodes[stack[--stackSize]];
+            if(!overlapsBox(node, boxMin, boxMax)){
+                continue;
+            }
+            if(node.count == 0){
+                stack[stackSize++] = node.first;
+                stack[stackSize++] = node.first + 1;
+                continue;
+            }
+            for(uint32_t i=node.first; i<node.first + node.count; i++){
+                const uint32_t triangle = m_triangles[i];
+                if(triangleOverlapsBox(m_vertices[m_indices[3*triangle]].position, m_vertices[m_indices[3*triangle + 1]].position,
+                                       m_vertices[m_indices[3*triangle + 2]].position, boxMin, boxMax)){
+                    triangles.push_back(triangle);
+                }
+            }
+        }
+        return triangles.size() - initialSize;
+    }
+
+    bool triangleOverlapsBox(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& boxMin, const glm::vec3& boxMax){
+        const glm::vec3 center = 0.5f*(boxMin + boxMax);
+        const glm::vec3 halfSize = 0.5f*(boxMax - boxMin);
+        const glm::vec3 v0 = a - center, v1 = b - center, v2 = c - center;
+        // Box faces, triangle plane, then the 9 edge / box axis cross products
+        const glm::vec3 axes[3] = {glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)};
+        for(int i=0; i<3; i++){
+            if(separates(axes[i], v0, v1, v2, halfSize)){
+                return false;
+            }
+        }
+        const glm::vec3 edges[3] = {v1 - v0, v2 - v1, v0 - v2};
+        if(separates(glm::cross(edges[0], edges[1]), v0, v1, v2, halfSize)){
+            return false;
+        }
+        for(int e=0; e<3; e++){
+            for(int i=0; i<3; i++){
+                if(separates(glm::cross(axes[i], edges[e]), v0, v1, v2, halfSize)){
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+}
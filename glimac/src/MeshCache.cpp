@@ -0,0 +1,148 @@
+/**
+ * \file MeshCache.cpp
+ * \brief Maillages importés mis en cache
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Format binaire des objets 3D importés, relu par projection en mémoire et envoyé au GPU en un bloc
+ *
+ */
+
+#include "glimac/MeshCache.hpp"
+#include <cstring>
+#include <stdint.h>
+
+namespace glimac {
+
+    namespace {
+        const uint32_t MAGIC = 0x48534D57; // "WMSH"
+        const uint32_t VERSION = 2;
+
+        // 56 bytes : the vertices that follow stay aligned on their floats
+        struct CacheHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint32_t vertexStride;
+            uint32_t flipV;
+            uint32_t nodeCount;
+            uint32_t reserved;
+            uint64_t sourceSize;
+            int64_t sourceTime;
+            uint64_t dataSize;
+        };
+    }
+
+    BakedMesh::BakedMesh():
+        m_data(nullptr),
+        m_vertexCount(0),
+        m_indexCount(0),
+        m_fromCache(false) {
+    }
+
+    std::unique_ptr<BakedMesh> BakedMesh::load(const FilePath& source, bool flipV, ThreadPool* pool){
+        std::unique_ptr<BakedMesh> mesh(new BakedMesh());
+        const FilePath cacheFile = source.replaceExt("wmesh");
+        if(mesh->open(cacheFile, source, flipV) || mesh->bake(source, cacheFile, flipV, pool)){
+            return mesh;
+        }
+        return std::unique_ptr<BakedMesh>();
+    }
+
+    bool BakedMesh::open(const FilePath& cacheFile, const FilePath& source, bool flipV){
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if(!getFileStamp(source, sourceSize, sourceTime) || !m_file.open(cacheFile) || m_file.getSize() < sizeof(CacheHeader)){
+            return false;
+        }
+        CacheHeader header;
+        std::memcpy(&header, m_file.getData(), sizeof(header));
+        if(header.magic != MAGIC || header.version != VERSION || header.sourceSize != sourceSize || header.sourceTime != sourceTime
+            || header.flipV != (flipV ? 1u : 0u) || header.vertexStride != sizeof(ShapeVertex)
+            || header.indexCount % 3 != 0
+            || header.dataSize != uint64_t(header.vertexCount)*sizeof(ShapeVertex) + uint64_t(header.indexCount)*sizeof(uint32_t)
+                                + uint64_t(header.nodeCount)*sizeof(BVHNode) + uint64_t(header.indexCount/3)*sizeof(uint32_t)
+            || header.dataSize != m_file.getSize() - sizeof(header)){
+            m_file.close();
+            return false;
+        }
+        m_vertexCount = header.vertexCount;
+        m_indexCount = header.indexCount;
+        m_data = m_file.getData() + sizeof(header);
+        const unsigned char* nodes = m_data + getIndexOffset() + m_indexCount*sizeof(uint32_t);
+        const unsigned char* triangles = nodes + header.nodeCount*sizeof(BVHNode);
+        m_bvh.attach(getVertices(), getIndices(), (const BVHNode*)nodes, header.nodeCount, (const uint32_t*)triangles, m_indexCount/3);
+        if(!m_bvh.isValid(m_vertexCount)){
+            std::cerr << "[WARNING] Corrupted mesh cache " << cacheFile << ", imported again" << std::endl;
+            m_bvh.attach(nullptr, nullptr, nullptr, 0, nullptr, 0);
+            m_file.close();
+            return false;
+        }
+        m_fromCache = true;
+        return true;
+    }
+
+    bool BakedMesh::bake(const FilePath& source, const FilePath& cacheFile, bool flipV, ThreadPool* pool){
+        IndexedMesh mesh;
+        if(!loadObjMesh(source, mesh, pool)){
+            return false;
+        }
+        if(flipV){
+            for(size_t i=0; i<mesh.vertices.size(); i++){
+                mesh.vertices[i].texCoords.y = -mesh.vertices[i].texCoords.y;
+            }
+        }
+        m_vertexCount = mesh.vertices.size();
+        m_indexCount = mesh.indices.size();
+        const size_t vertexSize = m_vertexCount*sizeof(ShapeVertex);
+        m_baked.resize(vertexSize + m_indexCount*sizeof(uint32_t));
+        std::memcpy(m_baked.data(), mesh.vertices.data(), vertexSize);
+        std::memcpy(m_baked.data() + vertexSize, mesh.indices.data(), m_indexCount*sizeof(uint32_t));
+        m_data = m_baked.data();
+        m_bvh.build(getVertices(), getIndices(), m_indexCount/3, pool);
+        m_fromCache = false;
+
+        // Not fatal if the cache cannot be written : imported again next launch
+        CacheHeader header;
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.vertexCount = m_vertexCount;
+        header.indexCount = m_indexCount;
+        header.vertexStride = sizeof(ShapeVertex);
+        header.flipV = flipV ? 1 : 0;
+        header.nodeCount = m_bvh.getNodeCount();
+        header.reserved = 0;
+        const size_t nodeSize = m_bvh.getNodeCount()*sizeof(BVHNode);
+        const size_t triangleSize = m_bvh.getTriangleCount()*sizeof(uint32_t);
+        header.dataSize = m_baked.size() + nodeSize + triangleSize;
+        if(getFileStamp(source, header.sourceSize, header.sourceTime)){
+            std::ofstream output(cacheFile.c_str(), std::ios::binary | std::ios::trunc);
+            if(!output.write((const char*)&header, sizeof(header)) || !output.write((const char*)m_baked.data(), m_baked.size())
+                || !output.write((const char*)m_bvh.getNodes(), nodeSize) || !output.write((const char*)m_bvh.getTriangles(), triangleSize)){
+                std::cerr << "[WARNING] Unable to write the mesh cache " << cacheFile << std::endl;
+            }
+        }
+        return true;
+    }
+
+    void BakedMesh::upload(GLuint& vao, GLuint& buffer) const{
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glGenBuffers(1, &buffer);
+        // One upload : the indices follow the vertices in the same buffer
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, getIndexOffset() + m_indexCount*sizeof(uint32_t), m_data, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ShapeVertex), (const GLvoid*)offsetof(ShapeVertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ShapeVertex), (const GLvoid*)offsetof(ShapeVertex, normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ShapeVertex), (const GLvoid*)offsetof(ShapeVertex, texCoords));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+}
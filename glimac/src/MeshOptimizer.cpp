@@ -0,0 +1,180 @@
+/**
+ * \file MeshOptimizer.cpp
+ * \brief Optimisation des maillages indexés
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Ordre des triangles et des sommets pour les caches de sommets du GPU
+ *
+ */
+
+#include "glimac/MeshOptimizer.hpp"
+
+namespace glimac {
+
+    namespace {
+        // Simulated LRU cache, larger than the real ones so that the order suits any size
+        const int CACHE_SIZE = 32;
+        const float CACHE_DECAY_POWER = 1.5f;
+        const float LAST_TRIANGLE_SCORE = 0.75f;
+        const float VALENCE_BOOST_SCALE = 2.0f;
+        const float VALENCE_BOOST_POWER = 0.5f;
+
+        // Vertices used by the last triangle score a bit lower : they favour neither end of a strip
+        float vertexScore(int cachePosition, uint32_t remainingTriangles){
+            if(remainingTriangles == 0){
+                return -1.0f;
+            }
+            float score = 0.0f;
+            if(cachePosition >= 0){
+                if(cachePosition < 3){
+                    score = LAST_TRIANGLE_SCORE;
+                }else{
+                    const float scaler = 1.0f/(CACHE_SIZE - 3);
+                    score = std::pow(1.0f - (cachePosition - 3)*scaler, CACHE_DECAY_POWER);
+                }
+            }
+            // Vertices with few triangles left are finished first, so that they leave no holes
+            return score + VALENCE_BOOST_SCALE*std::pow(float(remainingTriangles), -VALENCE_BOOST_POWER);
+        }
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount){
+        const size_t triangleCount = indices.size()/3;
+        if(triangleCount == 0){
+            return;
+        }
+
+        // Triangles of each vertex, the first remaining[v] entries are those not emitted yet
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for(size_t i=0; i<triangleCount*3; i++){
+            remaining[indices[i]]++;
+        }
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for(size_t v=0; v<vertexCount; v++){
+            offsets[v + 1] = offsets[v] + remaining[v];
+        }
+        std::vector<uint32_t> adjacency(triangleCount*3);
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for(size_t i=0; i<triangleCount*3; i++){
+            adjacency[fill[indices[i]]++] = uint32_t(i/3);
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> scores(vertexCount);
+        for(size_t v=0; v<vertexCount; v++){
+            scores[v] = vertexScore(-1, remaining[v]);
+        }
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        int best = 0;
+        for(size_t t=0; t<triangleCount; t++){
+            triangleScores[t] = scores[indices[3*t]] + scores[indices[3*t + 1]] + scores[indices[3*t + 2]];
+            if(triangleScores[t] > triangleScores[best]){
+                best = int(t);
+            }
+        }
+
+        std::vector<uint32_t> ordered;
+        ordered.reserve(triangleCount*3);
+        uint32_t cache[CACHE_SIZE + 3];
+        int cacheCount = 0;
+        size_t cursor = 0;
+        for(size_t n=0; n<triangleCount; n++){
+            // Nothing left around the cache : next triangle in the original order
+            if(best < 0){
+                while(emitted[cursor]){
+                    cursor++;
+                }
+                best = int(cursor);
+            }
+            const uint32_t* triangle = &indices[3*best];
+            emitted[best] = true;
+            ordered.insert(ordered.end(), triangle, triangle + 3);
+
+            for(int k=0; k<3; k++){
+                const uint32_t v = triangle[k];
+                uint32_t* first = &adjacency[offsets[v]];
+                uint32_t* last = first + remaining[v];
+                uint32_t* found = std::find(first, last, uint32_t(best));
+                if(found != last){
+                    *found = *(last - 1);
+                    remaining[v]--;
+                }
+            }
+
+            // The triangle's vertices move to the front, the others are pushed back
+            uint32_t updated[CACHE_SIZE + 3];
+            int updatedCount = 0;
+            for(int k=0; k<3; k++){
+                if(std::find(updated, updated + updatedCount, triangle[k]) == updated + updatedCount){
+                    updated[updatedCount++] = triangle[k];
+                }
+            }
+            for(int i=0; i<cacheCount; i++){
+                if(std::find(updated, updated + updatedCount, cache[i]) == updated + updatedCount){
+                    updated[updatedCount++] = cache[i];
+                }
+            }
+            for(int i=0; i<updatedCount; i++){
+                const uint32_t v = updated[i];
+                cachePosition[v] = (i < CACHE_SIZE) ? i : -1;
+                scores[v] = vertexScore(cachePosition[v], remaining[v]);
+            }
+            cacheCount = std::min(updatedCount, CACHE_SIZE);
+            std::copy(updated, updated + cacheCount, cache);
+
+            // Only the triangles around the cache (and the evicted vertices) changed score
+            best = -1;
+            float bestScore = -1.0f;
+            for(int i=0; i<updatedCount; i++){
+                const uint32_t v = updated[i];
+                for(uint32_t a=offsets[v]; a<offsets[v] + remaining[v]; a++){
+                    const uint32_t t = adjacency[a];
+                    triangleScores[t] = scores[indices[3*t]] + scores[indices[3*t + 1]] + scores[indices[3*t + 2]];
+                    if(triangleScores[t] > bestScore){
+                        bestScore = triangleScores[t];
+                        best = int(t);
+                    }
+                }
+            }
+        }
+        indices.swap(ordered);
+    }
+
+    void optimizeVertexFetch(IndexedMesh& mesh){
+        const uint32_t unused = ~0u;
+        std::vector<uint32_t> remap(mesh.vertices.size(), unused);
+        std::vector<ShapeVertex> vertices;
+        vertices.reserve(mesh.vertices.size());
+        for(size_t i=0; i<mesh.indices.size(); i++){
+            uint32_t& index = mesh.indices[i];
+            if(remap[index] == unused){
+                remap[index] = uint32_t(vertices.size());
+                vertices.push_back(mesh.vertices[index]);
+            }
+            index = remap[index];
+        }
+        // Vertices no triangle uses are dropped
+        mesh.vertices.swap(vertices);
+    }
+
+    float computeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize){
+        if(indices.size() < 3){
+            return 0.0f;
+        }
+        // A vertex is in the FIFO while fewer than cacheSize misses happened since it entered
+        std::vector<int64_t> entered(vertexCount, -1);
+        int64_t misses = 0;
+        for(size_t i=0; i<indices.size(); i++){
+            const int64_t stamp = entered[indices[i]];
+            if(stamp < 0 || misses - stamp >= cacheSize){
+                entered[indices[i]] = misses;
+                misses++;
+            }
+        }
+        return float(misses)/float(indices.size()/3);
+    }
+
+}
@@ -0,0 +1,436 @@
+/**
+ * \file ObjMesh.cpp
+ * \brief Import rapide des objets 3D
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Lecture des fichiers OBJ projetés en mémoire, découpés en morceaux lus en parallèle, vers un
+ * maillage indexé
+ *
+ */
+
+#include "glimac/ObjMesh.hpp"
+#include "glimac/MappedFile.hpp"
+#include "glimac/MeshOptimizer.hpp"
+#include <limits>
+
+namespace glimac {
+
+    namespace {
+        // Below this size a file is not worth splitting
+        const size_t MIN_CHUNK_SIZE = 256 << 10;
+
+        // Attribute absent from the face corner (v, v/vt, v//vn)
+        const int32_t MISSING = std::numeric_limits<int32_t>::min();
+
+        enum Attribute { POSITION = 0, UV = 1, NORMAL = 2 };
+
+        // One corner of a triangle, indices resolved once every chunk is counted
+        struct Corner {
+            int32_t index[3]; /*!< 0-based, absolute or relative to the chunk start*/
+            uint8_t relative; /*!< Bit per attribute : index counted from the chunk start (negative OBJ index)*/
+        };
+
+        struct ObjChunk {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec2> uvs;
+            std::vector<glm::vec3> normals;
+            std::vector<Corner> corners;
+            std::string error;
+        };
+
+        struct CornerKey {
+            int32_t index[3];
+            bool operator==(const CornerKey& other) const{
+                return index[0] == other.index[0] && index[1] == other.index[1] && index[2] == other.index[2];
+            }
+        };
+
+        // Open addressing (linear probing) from (v, vt, vn) to the vertex index : one flat array, no node per entry
+        class CornerTable {
+            public:
+                CornerTable(size_t expected):
+                    m_count(0) {
+                    size_t capacity = 16;
+                    while(capacity < expected*2){
+                        capacity *= 2;
+                    }
+                    m_slots.resize(capacity);
+                }
+
+                // Index of the corner, or value once inserted
+                uint32_t findOrInsert(const CornerKey& key, uint32_t value, bool& inserted){
+                    if((m_count + 1)*10 > m_slots.size()*7){
+                        grow();
+                    }
+                    Slot& slot = find(key);
+                    inserted = (slot.value == EMPTY);
+                    if(inserted){
+                        slot.key = key;
+                        slot.value = value;
+                        m_count++;
+                    }
+                    return slot.value;
+                }
+
+            private:
+                static const uint32_t EMPTY = ~0u;
+
+                struct Slot {
+                    CornerKey key;
+                    uint32_t value;
+                    Slot(): value(EMPTY) {}
+                };
+
+                static size_t hash(const CornerKey& key){
+                    // 64 bit finaliser (MurmurHash3) over the three indices
+                    uint64_t h = (uint64_t(uint32_t(key.index[0])) << 32 | uint32_t(key.index[1])) ^ (uint64_t(uint32_t(key.index[2]))*0x9E3779B97F4A7C15ULL);
+                    h ^= h >> 33;
+                    h *= 0xFF51AFD7ED558CCDULL;
+                    h ^= h >> 33;
+                    h *= 0xC4CEB9FE1A85EC53ULL;
+                    h ^= h >> 33;
+                    return size_t(h);
+                }
+
+                Slot& find(const CornerKey& key){
+                    const size_t mask = m_slots.size() - 1;
+                    for(size_t i = hash(key) & mask; ; i = (i + 1) & mask){
+                        if(m_slots[i].value == EMPTY || m_slots[i].key == key){
+                            return m_slots[i];
+                        }
+                    }
+                }
+
+                void grow(){
+                    std::vector<Slot> previous(m_slots.size()*2);
+                    previous.swap(m_slots);
+                    for(size_t i=0; i<previous.size(); i++){
+                        if(previous[i].value != EMPTY){
+                            find(previous[i].key) = previous[i];
+                        }
+                    }
+                }
+
+                std::vector<Slot> m_slots;
+                size_t m_count;
+        };
+
+        const double POWERS_OF_TEN[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        inline bool isBlank(char c){
+            return c == ' ' || c == '\t';
+        }
+
+        inline bool isDigit(char c){
+            return c >= '0' && c <= '9';
+        }
+
+        // Decimal float without locale nor allocation : [-+]digits[.digits][(e|E)[-+]digits]
+        const char* parseFloat(const char* p, const char* end, float& out){
+            while(p < end && isBlank(*p)){
+                p++;
+            }
+            bool negative = false;
+            if(p < end && (*p == '-' || *p == '+')){
+                negative = (*p == '-');
+                p++;
+            }
+            uint64_t mantissa = 0;
+            int exponent = 0, digits = 0;
+            for(; p < end && isDigit(*p); p++, digits++){
+                if(mantissa < 100000000000000000ULL){
+                    mantissa = mantissa*10 + (*p - '0');
+                }else{
+                    exponent++;
+                }
+            }
+            if(p < end && *p == '.'){
+                for(p++; p < end && isDigit(*p); p++, digits++){
+                    if(mantissa < 100000000000000000ULL){
+                        mantissa = mantissa*10 + (*p - '0');
+                        exponent--;
+                    }
+                }
+            }
+            if(digits == 0){
+                return nullptr;
+            }
+            if(p < end && (*p == 'e' || *p == 'E')){
+                const char* q = p + 1;
+                bool negativeExponent = false;
+                if(q < end && (*q == '-' || *q == '+')){
+                    negativeExponent = (*q == '-');
+                    q++;
+                }
+                if(q < end && isDigit(*q)){
+                    int value = 0;
+                    for(; q < end && isDigit(*q); q++){
+                        value = std::min(value*10 + (*q - '0'), 1000);
+                    }
+                    exponent += negativeExponent ? -value : value;
+                    p = q;
+                }
+            }
+            double value = double(mantissa);
+            if(exponent != 0){
+                const int magnitude = std::abs(exponent);
+                const double scale = (magnitude <= 22) ? POWERS_OF_TEN[magnitude] : std::pow(10.0, magnitude);
+                value = (exponent < 0) ? value/scale : value*scale;
+            }
+            out = float(negative ? -value : value);
+            return p;
+        }
+
+        const char* parseInt(const char* p, const char* end, int32_t& out){
+            bool negative = false;
+            if(p < end && (*p == '-' || *p == '+')){
+                negative = (*p == '-');
+                p++;
+            }
+            if(p == end || !isDigit(*p)){
+                return nullptr;
+            }
+            int64_t value = 0;
+            for(; p < end && isDigit(*p); p++){
+                value = std::min<int64_t>(value*10 + (*p - '0'), std::numeric_limits<int32_t>::max());
+            }
+            out = int32_t(negative ? -value : value);
+            return p;
+        }
+
+        // v, v/vt, v//vn or v/vt/vn ; OBJ indices start at 1, negative ones count back from the last element
+        const char* parseCorner(const char* p, const char* end, const size_t* counts, Corner& corner){
+            corner.relative = 0;
+            for(int k=0; k<3; k++){
+                corner.index[k] = MISSING;
+            }
+            for(int k=0; k<3; k++){
+                if(k > 0){
+                    if(p == end || *p != '/'){
+                        break;
+                    }
+                    p++;
+                    // Empty texture coordinate : v//vn
+                    if(k == UV && p < end && *p == '/'){
+                        continue;
+                    }
+                }
+                int32_t value;
+                p = parseInt(p, end, value);
+                if(!p || value == 0){
+                    return nullptr;
+                }
+                if(value > 0){
+                    corner.index[k] = value - 1;
+                }else{
+                    corner.index[k] = int32_t(counts[k]) + value;
+                    corner.relative |= uint8_t(1 << k);
+                }
+            }
+            return p;
+        }
+
+        const char* skipLine(const char* p, const char* end){
+            while(p < end && *p != '\n'){
+                p++;
+            }
+            return (p < end) ? p + 1 : p;
+        }
+
+        bool atLineEnd(const char* p, const char* end){
+            while(p < end && (isBlank(*p) || *p == '\r')){
+                p++;
+            }
+            return p == end || *p == '\n' || *p == '#';
+        }
+
+        void parseChunk(const char* p, const char* end, ObjChunk& chunk){
+            std::vector<Corner> polygon;
+            while(p < end){
+                while(p < end && (isBlank(*p) || *p == '\r')){
+                    p++;
+                }
+                const char* line = p;
+                if(p + 1 < end && p[0] == 'v' && isBlank(p[1])){
+                    glm::vec3 position;
+                    if(!(p = parseFloat(p + 2, end, position.x)) || !(p = parseFloat(p, end, position.y)) || !(p = parseFloat(p, end, position.z))){
+                        chunk.error = "invalid vertex";
+                        return;
+                    }
+                    chunk.positions.push_back(position);
+                }else if(p + 2 < end && p[0] == 'v' && p[1] == 't' && isBlank(p[2])){
+                    glm::vec2 uv;
+                    if(!(p = parseFloat(p + 3, end, uv.x))){
+                        chunk.error = "invalid texture coordinate";
+                        return;
+                    }
+                    // The second coordinate is optional
+                    const char* next = parseFloat(p, end, uv.y);
+                    if(next){
+                        p = next;
+                    }else{
+                        uv.y = 0.0f;
+                    }
+                    chunk.uvs.push_back(uv);
+                }else if(p + 2 < end && p[0] == 'v' && p[1] == 'n' && isBlank(p[2])){
+                    glm::vec3 normal;
+                    if(!(p = parseFloat(p + 3, end, normal.x)) || !(p = parseFloat(p, end, normal.y)) || !(p = parseFloat(p, end, normal.z))){
+                        chunk.error = "invalid normal";
+                        return;
+                    }
+                    chunk.normals.push_back(normal);
+                }else if(p + 1 < end && p[0] == 'f' && isBlank(p[1])){
+                    const size_t counts[3] = { chunk.positions.size(), chunk.uvs.size(), chunk.normals.size() };
+                    polygon.clear();
+                    p++;
+                    while(!atLineEnd(p, end)){
+                        while(isBlank(*p)){
+                            p++;
+                        }
+                        Corner corner;
+                        if(!(p = parseCorner(p, end, counts, corner))){
+                            chunk.error = "invalid face";
+                            return;
+                        }
+                        polygon.push_back(corner);
+                    }
+                    if(polygon.size() < 3){
+                        chunk.error = "face with less than 3 corners";
+                        return;
+                    }
+                    // Fan triangulation, fine for the convex polygons exporters write
+                    for(size_t i=1; i+1<polygon.size(); i++){
+                        chunk.corners.push_back(polygon[0]);
+                        chunk.corners.push_back(polygon[i]);
+                        chunk.corners.push_back(polygon[i + 1]);
+                    }
+                }
+                // Comments, groups, materials, smoothing : ignored
+                p = skipLine((p > line) ? p : line, end);
+            }
+        }
+    }
+
+    bool loadObjMesh(const FilePath& filepath, IndexedMesh& mesh, ThreadPool* pool){
+        MappedFile file;
+        if(!file.open(filepath)){
+            std::cerr << "[ERROR] OBJ " << filepath << " : could not be opened" << std::endl;
+            return false;
+        }
+        const char* begin = (const char*)file.getData();
+        const char* end = begin + file.getSize();
+
+        // Chunks end on line boundaries
+        size_t chunkCount = 1;
+        if(pool){
+            chunkCount = std::max<size_t>(1, std::min(pool->getThreadCount() + 1, file.getSize()/MIN_CHUNK_SIZE));
+        }
+        std::vector<const char*> bounds(chunkCount + 1, end);
+        bounds[0] = begin;
+        for(size_t i=1; i<chunkCount; i++){
+            const char* split = std::max(begin + file.getSize()*i/chunkCount, bounds[i - 1]);
+            bounds[i] = skipLine(split, end);
+        }
+
+        std::vector<ObjChunk> chunks(chunkCount);
+        std::vector<std::future<void> > pending;
+        for(size_t i=1; i<chunkCount; i++){
+            const char* from = bounds[i];
+            const char* to = bounds[i + 1];
+            ObjChunk* chunk = &chunks[i];
+            pending.push_back(pool->submit([from, to, chunk](){ parseChunk(from, to, *chunk); }));
+        }
+        // This thread takes the first chunk
+        parseChunk(bounds[0], bounds[1], chunks[0]);
+        for(size_t i=0; i<pending.size(); i++){
+            pending[i].get();
+        }
+
+        // Merge : each chunk's elements follow those of the previous chunks
+        std::vector<glm::vec3> positions, normals;
+        std::vector<glm::vec2> uvs;
+        std::vector<size_t> bases[3];
+        size_t cornerCount = 0;
+        for(size_t i=0; i<chunkCount; i++){
+            if(!chunks[i].error.empty()){
+                std::cerr << "[ERROR] OBJ " << filepath << " : " << chunks[i].error << std::endl;
+                return false;
+            }
+            bases[POSITION].push_back(positions.size());
+            bases[UV].push_back(uvs.size());
+            bases[NORMAL].push_back(normals.size());
+            positions.insert(positions.end(), chunks[i].positions.begin(), chunks[i].positions.end());
+            uvs.insert(uvs.end(), chunks[i].uvs.begin(), chunks[i].uvs.end());
+            normals.insert(normals.end(), chunks[i].normals.begin(), chunks[i].normals.end());
+            cornerCount += chunks[i].corners.size();
+        }
+        const size_t sizes[3] = { positions.size(), uvs.size(), normals.size() };
+
+        // One vertex per distinct (v, vt, vn)
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.indices.reserve(cornerCount);
+        // A smooth mesh shares each vertex between about 6 corners
+        CornerTable vertexIndices(cornerCount/4);
+        std::vector<bool> needsNormal;
+        for(size_t i=0; i<chunkCount; i++){
+            const std::vector<Corner>& corners = chunks[i].corners;
+            for(size_t c=0; c<corners.size(); c++){
+                CornerKey key;
+                for(int k=0; k<3; k++){
+                    int64_t index = corners[c].index[k];
+                    if(index != MISSING){
+                        if(corners[c].relative & (1 << k)){
+                            index += bases[k][i];
+                        }
+                        if(index < 0 || index >= (int64_t)sizes[k]){
+                            std::cerr << "[ERROR] OBJ " << filepath << " : index out of range" << std::endl;
+                            return false;
+                        }
+                    }
+                    key.index[k] = int32_t(index);
+                }
+                bool inserted;
+                const uint32_t index = vertexIndices.findOrInsert(key, (uint32_t)mesh.vertices.size(), inserted);
+                if(inserted){
+                    ShapeVertex vertex;
+                    vertex.position = positions[key.index[POSITION]];
+                    vertex.texCoords = (key.index[UV] != MISSING) ? uvs[key.index[UV]] : glm::vec2(0.0f);
+                    vertex.normal = (key.index[NORMAL] != MISSING) ? normals[key.index[NORMAL]] : glm::vec3(0.0f);
+                    mesh.vertices.push_back(vertex);
+                    needsNormal.push_back(key.index[NORMAL] == MISSING);
+                }
+                mesh.indices.push_back(index);
+            }
+        }
+
+        // Missing normals : sum of the adjacent face normals, weighted by their area
+        if(std::find(needsNormal.begin(), needsNormal.end(), true) != needsNormal.end()){
+            for(size_t t=0; t+2<mesh.indices.size(); t+=3){
+                const glm::vec3& a = mesh.vertices[mesh.indices[t]].position;
+                const glm::vec3 faceNormal = glm::cross(mesh.vertices[mesh.indices[t + 1]].position - a, mesh.vertices[mesh.indices[t + 2]].position - a);
+                for(int k=0; k<3; k++){
+                    if(needsNormal[mesh.indices[t + k]]){
+                        mesh.vertices[mesh.indices[t + k]].normal += faceNormal;
+                    }
+                }
+            }
+            for(size_t v=0; v<mesh.vertices.size(); v++){
+                if(needsNormal[v] && glm::length(mesh.vertices[v].normal) > 0.0f){
+                    mesh.vertices[v].normal = glm::normalize(mesh.vertices[v].normal);
+                }
+            }
+        }
+
+        // GPU friendly order : triangles for the post-transform cache, then vertices in order of use
+        optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        optimizeVertexFetch(mesh);
+        return true;
+    }
+
+}
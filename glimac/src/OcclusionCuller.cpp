@@ -0,0 +1,364 @@
+/**
+ * \file OcclusionCuller.cpp
+ * \brief Elimination des objets cachés sur le CPU
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Tampon de profondeur basse résolution rempli par quelques grands pavés occultants, pyramide Hi-Z
+ *
+ */
+
+#include "glimac/OcclusionCuller.hpp"
+#include <algorithm>
+#include <limits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace glimac {
+
+    namespace {
+        // Corners closer than this (clip w) are treated as crossing the near plane
+        const float MIN_W = 1e-4f;
+        // Tolerance of the depth comparison, so that an occluder never hides the box it belongs to
+        const float DEPTH_EPSILON = 1e-5f;
+
+        // Smallest projected face kept as a front face (twice the area, in texels)
+        const float MIN_FACE_AREA = 1e-6f;
+
+        // Corner i of a box : bit 0 selects x, bit 1 y, bit 2 z. Counter-clockwise seen from outside the box
+        const int BOX_FACES[6][4] = {
+            {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}
+        };
+
+        // Edge function E(p) = A*p.x + B*p.y + C, positive on the left of u -> v
+        struct Edge {
+            float A, B, C;
+        };
+
+        Edge makeEdge(const glm::vec3& u, const glm::vec3& v){
+            Edge edge;
+            edge.A = -(v.y - u.y);
+            edge.B = v.x - u.x;
+            edge.C = -(edge.A*u.x + edge.B*u.y);
+            return edge;
+        }
+
+        // Largest change of an affine function from a texel center to its corners
+        float halfTexel(float A, float B){
+            return 0.5f*(std::abs(A) + std::abs(B));
+        }
+
+        float cross(const glm::vec3& o, const glm::vec3& a, const glm::vec3& b){
+            return (a.x - o.x)*(b.y - o.y) - (a.y - o.y)*(b.x - o.x);
+        }
+
+        // Counter-clockwise convex hull of the projected corners (monotone chain), returns its size
+        int convexHull(const glm::vec3 points[8], glm::vec3 hull[9]){
+            glm::vec3 sorted[8];
+            std::copy(points, points + 8, sorted);
+            std::sort(sorted, sorted + 8, [](const glm::vec3& a, const glm::vec3& b){
+                return a.x < b.x || (a.x == b.x && a.y < b.y);
+            });
+            int count = 0;
+            for(int i=0; i<8; i++){
+                while(count >= 2 && cross(hull[count-2], hull[count-1], sorted[i]) <= 0.0f){
+                    count--;
+                }
+                hull[count++] = sorted[i];
+            }
+            for(int i=6, lower=count+1; i>=0; i--){
+                while(count >= lower && cross(hull[count-2], hull[count-1], sorted[i]) <= 0.0f){
+                    count--;
+                }
+                hull[count++] = sorted[i];
+            }
+            return count - 1;
+        }
+
+        int nextPowerOfTwo(int n){
+            int p = 4;
+            while(p < n){
+                p <<= 1;
+            }
+            return p;
+        }
+
+        bool outsideFrustum(const glm::vec4 clip[8]){
+            for(int plane=0; plane<6; plane++){
+                const int axis = plane/2;
+                const float sign = (plane & 1) ? -1.0f : 1.0f;
+                bool allOut = true;
+                for(int i=0; i<8 && allOut; i++){
+                    allOut = clip[i].w + sign*clip[i][axis] < 0.0f;
+                }
+                if(allOut){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool crossesNearPlane(const glm::vec4 clip[8]){
+            for(int i=0; i<8; i++){
+                if(clip[i].w <= MIN_W || clip[i].z < -clip[i].w){
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    OcclusionCuller::OcclusionCuller(int width, int height):
+        m_width(nextPowerOfTwo(width)),
+        m_height(nextPowerOfTwo(height)),
+        m_viewProjection(1.0f),
+        m_occluderCount(0) {
+        int w = m_width, h = m_height;
+        while(true){
+            m_levels.push_back(std::vector<float>(w*h, 1.0f));
+            if(w == 1 && h == 1){
+                break;
+            }
+            w = std::max(1, w/2);
+            h = std::max(1, h/2);
+        }
+    }
+
+    void OcclusionCuller::beginFrame(const glm::mat4& viewProjection){
+        m_viewProjection = viewProjection;
+        m_occluderCount = 0;
+        std::fill(m_levels[0].begin(), m_levels[0].end(), 1.0f);
+    }
+
+    void OcclusionCuller::project(const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec4 clip[8]) const{
+        for(int i=0; i<8; i++){
+            const glm::vec3 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+            clip[i] = m_viewProjection * glm::vec4(corner, 1.0f);
+        }
+    }
+
+    void OcclusionCuller::addOccluder(const glm::vec3& boxMin, const glm::vec3& boxMax){
+        glm::vec4 clip[8];
+        project(boxMin, boxMax, clip);
+        // Occluders are optional : skip rather than clip the ones crossing the near plane
+        if(outsideFrustum(clip) || crossesNearPlane(clip)){
+            return;
+        }
+        glm::vec3 screen[8];
+        for(int i=0; i<8; i++){
+            const glm::vec3 ndc = glm::vec3(clip[i])/clip[i].w;
+            screen[i] = glm::vec3((ndc.x*0.5f + 0.5f)*m_width, (ndc.y*0.5f + 0.5f)*m_height, ndc.z*0.5f + 0.5f);
+        }
+        rasterizeBox(screen);
+        m_occluderCount++;
+    }
+
+    // Depth-only rasterization kept conservative : a texel is written only when the box covers all of it,
+    // with the farthest depth its front faces reach inside the texel
+    void OcclusionCuller::rasterizeBox(const glm::vec3 screen[8]){
+        // Silhouette moved half a texel inwards : a texel center passing it has its whole texel inside
+        glm::vec3 hull[9];
+        const int hullCount = convexHull(screen, hull);
+        if(hullCount < 3){
+            return;
+        }
+        Edge inner[8];
+        for(int i=0; i<hullCount; i++){
+            inner[i] = makeEdge(hull[i], hull[i+1]);
+            inner[i].C -= halfTexel(inner[i].A, inner[i].B);
+        }
+
+        // Front faces partition the silhouette : each one is tested on the texels it touches (edges moved
+        // half a texel outwards), its depth plane raised to its maximum over the texel
+        Edge outer[3][4];
+        float dA[3], dB[3], dC[3];
+        int faceCount = 0;
+        for(int f=0; f<6 && faceCount<3; f++){
+            const glm::vec3* q[4] = { &screen[BOX_FACES[f][0]], &screen[BOX_FACES[f][1]], &screen[BOX_FACES[f][2]], &screen[BOX_FACES[f][3]] };
+            const float first = cross(*q[0], *q[1], *q[2]);
+            const float second = cross(*q[0], *q[2], *q[3]);
+            if(first + second <= MIN_FACE_AREA){
+                continue;
+            }
+            // The face is planar : its depth is affine in screen space, taken from its larger half
+            const glm::vec3& a = *q[0];
+            const glm::vec3& b = (first >= second) ? *q[1] : *q[2];
+            const glm::vec3& c = (first >= second) ? *q[2] : *q[3];
+            const float area = std::max(first, second);
+            const Edge e0 = makeEdge(b, c), e1 = makeEdge(c, a), e2 = makeEdge(a, b);
+            dA[faceCount] = (e0.A*a.z + e1.A*b.z + e2.A*c.z)/area;
+            dB[faceCount] = (e0.B*a.z + e1.B*b.z + e2.B*c.z)/area;
+            dC[faceCount] = (e0.C*a.z + e1.C*b.z + e2.C*c.z)/area + halfTexel(dA[faceCount], dB[faceCount]);
+            for(int i=0; i<4; i++){
+                outer[faceCount][i] = makeEdge(*q[i], *q[(i+1)%4]);
+                outer[faceCount][i].C += halfTexel(outer[faceCount][i].A, outer[faceCount][i].B);
+            }
+            faceCount++;
+        }
+
+        float lowX = hull[0].x, highX = hull[0].x, lowY = hull[0].y, highY = hull[0].y;
+        for(int i=1; i<hullCount; i++){
+            lowX = std::min(lowX, hull[i].x);
+            highX = std::max(highX, hull[i].x);
+            lowY = std::min(lowY, hull[i].y);
+            highY = std::max(highY, hull[i].y);
+        }
+        const int minX = std::max(0, int(std::floor(lowX))) & ~3;
+        const int maxX = std::min(m_width - 1, int(std::floor(highX)));
+        const int minY = std::max(0, int(std::floor(lowY)));
+        const int maxY = std::min(m_height - 1, int(std::floor(highY)));
+        if(minX > maxX || minY > maxY){
+            return;
+        }
+
+        std::vector<float>& depth = m_levels[0];
+        for(int y=minY; y<=maxY; y++){
+            const float py = y + 0.5f;
+            float* row = &depth[y*m_width];
+#ifdef __SSE2__
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 lowest = _mm_set1_ps(-std::numeric_limits<float>::max());
+            const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            for(int x=minX; x<=maxX; x+=4){
+                const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), offsets);
+                __m128 covered = _mm_cmpeq_ps(zero, zero);
+                for(int i=0; i<hullCount; i++){
+                    covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(inner[i].A), px), _mm_set1_ps(inner[i].B*py + inner[i].C)), zero));
+                }
+                if(_mm_movemask_ps(covered) == 0){
+                    continue;
+                }
+                __m128 farthest = lowest;
+                __m128 touched = zero;
+                for(int f=0; f<faceCount; f++){
+                    __m128 touches = _mm_cmpeq_ps(zero, zero);
+                    for(int i=0; i<4; i++){
+                        touches = _mm_and_ps(touches, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(outer[f][i].A), px), _mm_set1_ps(outer[f][i].B*py + outer[f][i].C)), zero));
+                    }
+                    const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dA[f]), px), _mm_set1_ps(dB[f]*py + dC[f]));
+                    farthest = _mm_max_ps(farthest, _mm_or_ps(_mm_and_ps(touches, z), _mm_andnot_ps(touches, lowest)));
+                    touched = _mm_or_ps(touched, touches);
+                }
+                covered = _mm_and_ps(covered, touched);
+                const __m128 current = _mm_loadu_ps(row + x);
+                const __m128 closest = _mm_min_ps(current, farthest);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(covered, closest), _mm_andnot_ps(covered, current)));
+            }
+#else
+            for(int x=minX; x<=maxX; x++){
+                const float px = x + 0.5f;
+                bool covered = true;
+                for(int i=0; i<hullCount && covered; i++){
+                    covered = inner[i].A*px + inner[i].B*py + inner[i].C >= 0.0f;
+                }
+                if(!covered){
+                    continue;
+                }
+                float farthest = -std::numeric_limits<float>::max();
+                bool touched = false;
+                for(int f=0; f<faceCount; f++){
+                    bool touches = true;
+                    for(int i=0; i<4 && touches; i++){
+                        touches = outer[f][i].A*px + outer[f][i].B*py + outer[f][i].C >= 0.0f;
+                    }
+                    if(touches){
+                        farthest = std::max(farthest, dA[f]*px + dB[f]*py + dC[f]);
+                        touched = true;
+                    }
+                }
+                if(touched){
+                    row[x] = std::min(row[x], farthest);
+                }
+            }
+#endif
+        }
+    }
+
+    // Each texel keeps the farthest depth of the 2x2 texels below it
+    void OcclusionCuller::buildPyramid(){
+        for(size_t level=1; level<m_levels.size(); level++){
+            const int srcWidth = std::max(1, m_width >> (level-1));
+            const int srcHeight = std::max(1, m_height >> (level-1));
+            const int width = std::max(1, m_width >> level);
+            const int height = std::max(1, m_height >> level);
+            const std::vector<float>& src = m_levels[level-1];
+            std::vector<float>& dst = m_levels[level];
+            for(int y=0; y<height; y++){
+                const float* row0 = &src[std::min(2*y, srcHeight-1)*srcWidth];
+                const float* row1 = &src[std::min(2*y+1, srcHeight-1)*srcWidth];
+                int x = 0;
+#ifdef __SSE2__
+                if(srcWidth == 2*width){
+                    for(; x+4<=width; x+=4){
+                        const __m128 lo = _mm_max_ps(_mm_loadu_ps(row0 + 2*x), _mm_loadu_ps(row1 + 2*x));
+                        const __m128 hi = _mm_max_ps(_mm_loadu_ps(row0 + 2*x + 4), _mm_loadu_ps(row1 + 2*x + 4));
+                        const __m128 even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+                        const __m128 odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+                        _mm_storeu_ps(&dst[y*width + x], _mm_max_ps(even, odd));
+                    }
+                }
+#endif
+                for(; x<width; x++){
+                    const int x0 = std::min(2*x, srcWidth-1);
+                    const int x1 = std::min(2*x+1, srcWidth-1);
+                    dst[y*width + x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+                }
+            }
+        }
+    }
+
+    bool OcclusionCuller::isInFrustum(const glm::vec3& boxMin, const glm::vec3& boxMax) const{
+        glm::vec4 clip[8];
+        project(boxMin, boxMax, clip);
+        return !outsideFrustum(clip);
+    }
+
+    bool OcclusionCuller::isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const{
+        glm::vec4 clip[8];
+        project(boxMin, boxMax, clip);
+        if(outsideFrustum(clip)){
+            return false;
+        }
+        if(crossesNearPlane(clip)){
+            return true;
+        }
+
+        // Screen rectangle and closest depth of the box
+        glm::vec2 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+        float nearest = 1.0f;
+        for(int i=0; i<8; i++){
+            const glm::vec3 ndc = glm::vec3(clip[i])/clip[i].w;
+            const glm::vec2 p((ndc.x*0.5f + 0.5f)*m_width, (ndc.y*0.5f + 0.5f)*m_height);
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+            nearest = std::min(nearest, ndc.z*0.5f + 0.5f);
+        }
+        const int x0 = glm::clamp(int(std::floor(lo.x)), 0, m_width-1);
+        const int x1 = glm::clamp(int(std::floor(hi.x)), 0, m_width-1);
+        const int y0 = glm::clamp(int(std::floor(lo.y)), 0, m_height-1);
+        const int y1 = glm::clamp(int(std::floor(hi.y)), 0, m_height-1);
+
+        // Coarsest level where the rectangle spans at most 2x2 texels
+        int level = 0;
+        while(((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1) && level+1 < int(m_levels.size())){
+            level++;
+        }
+        for(int y=(y0 >> level); y<=(y1 >> level); y++){
+            for(int x=(x0 >> level); x<=(x1 >> level); x++){
+                if(nearest <= getDepth(level, x, y) + DEPTH_EPSILON){
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    float OcclusionCuller::getDepth(int level, int x, int y) const{
+        const int width = std::max(1, m_width >> level);
+        const int height = std::max(1, m_height >> level);
+        return m_levels[level][glm::clamp(y, 0, height-1)*width + glm::clamp(x, 0, width-1)];
+    }
+
+}
@@ -10,6 +10,7 @@
  */
 
 #include "glimac/Program.hpp"
+#include "glimac/UniformBuffer.hpp"
 #include <stdexcept>
 
 namespace glimac {
@@ -18,7 +19,70 @@ bool Program::link() {
 	glLinkProgram(m_nGLId);
 	GLint status;
 	glGetProgramiv(m_nGLId, GL_LINK_STATUS, &status);
-	return status == GL_TRUE;
+	if(status != GL_TRUE) {
+		return false;
+	}
+	linked();
+	return true;
+}
+
+bool Program::loadBinary(GLenum format, const std::vector<char>& binary) {
+	glProgramBinary(m_nGLId, format, binary.data(), (GLsizei)binary.size());
+	GLint status;
+	glGetProgramiv(m_nGLId, GL_LINK_STATUS, &status);
+	if(status != GL_TRUE) {
+		return false;
+	}
+	// A binary comes back like a fresh link : block bindings must be set again
+	linked();
+	return true;
+}
+
+bool Program::getBinary(GLenum& format, std::vector<char>& binary) const {
+	GLint length = 0;
+	glGetProgramiv(m_nGLId, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0) {
+		return false;
+	}
+	binary.resize(length);
+	GLsizei written = 0;
+	glGetProgramBinary(m_nGLId, length, &written, &format, binary.data());
+	binary.resize(written);
+	return written > 0;
+}
+
+void Program::linked() {
+	// Shared frame and material blocks
+	UniformBuffer::bindBlocks(m_nGLId);
+
+	// Every active uniform is looked up once : arrays under their name and each element
+	m_uniforms.clear();
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(m_nGLId, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(m_nGLId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> buffer(std::max(maxLength, 1));
+	for(GLint i = 0; i < count; ++i) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type;
+		glGetActiveUniform(m_nGLId, i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+		std::string name(buffer.data(), length);
+		const GLint location = glGetUniformLocation(m_nGLId, name.c_str());
+		// Members of uniform blocks have no location
+		if(location < 0) {
+			continue;
+		}
+		m_uniforms[name] = location;
+		const size_t bracket = name.rfind("[0]");
+		if(bracket != std::string::npos && bracket + 3 == name.size()) {
+			name.erase(bracket);
+			m_uniforms[name] = location;
+			for(GLint element = 1; element < size; ++element) {
+				const std::string elementName = name + "[" + std::to_string(element) + "]";
+				m_uniforms[elementName] = glGetUniformLocation(m_nGLId, elementName.c_str());
+			}
+		}
+	}
 }
 
 const std::string Program::getInfoLog() const {
@@ -0,0 +1,131 @@
+/**
+ * \file ProgramCache.cpp
+ * \brief Cache des programmes compilés
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Sauvegarde des programmes liés par le pilote, pour ne plus compiler les shaders à chaque lancement
+ *
+ */
+
+#include "glimac/ProgramCache.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+
+namespace glimac {
+
+    namespace {
+        // File layout : header, then the driver binary
+        const uint32_t MAGIC = 0x43504957; // "WIPC"
+
+        struct CacheHeader {
+            uint32_t magic;
+            uint32_t format;
+            uint64_t hash;
+            uint32_t size;
+            uint32_t padding;
+        };
+
+        // FNV-1a : stable between runs, unlike std::hash
+        uint64_t hashString(const std::string& text, uint64_t hash = 14695981039346656037ULL){
+            for(size_t i=0; i<text.size(); i++){
+                hash ^= (unsigned char)text[i];
+                hash *= 1099511628211ULL;
+            }
+            // Separator, so that "ab" + "c" and "a" + "bc" differ
+            hash ^= 0xFF;
+            hash *= 1099511628211ULL;
+            return hash;
+        }
+
+        std::string readFile(const FilePath& filepath){
+            std::ifstream input(filepath.c_str());
+            if(!input){
+                throw std::runtime_error("Unable to load the file " + filepath.str());
+            }
+            std::stringstream buffer;
+            buffer << input.rdbuf();
+            return buffer.str();
+        }
+
+        std::string glString(GLenum name){
+            const GLubyte* value = glGetString(name);
+            return value ? std::string((const char*)value) : std::string();
+        }
+
+        // "shaders/vertex.vs.glsl" -> "vertex"
+        std::string stem(const FilePath& filepath){
+            const std::string file = filepath.file();
+            return file.substr(0, file.find('.'));
+        }
+    }
+
+    ProgramCache::ProgramCache(const FilePath& directory):
+        m_directory(directory),
+        m_supported(false),
+        m_hits(0),
+        m_misses(0) {
+        if(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary){
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            m_supported = formats > 0;
+        }
+        m_driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+    }
+
+    Program ProgramCache::load(const FilePath& vsFile, const FilePath& fsFile){
+        const std::string vsSource = readFile(vsFile);
+        const std::string fsSource = readFile(fsFile);
+        const uint64_t hash = hashString(m_driver, hashString(fsSource, hashString(vsSource)));
+        const FilePath cacheFile = m_directory + (stem(vsFile) + "_" + stem(fsFile) + ".program");
+
+        Program program;
+        if(m_supported){
+            std::ifstream input(cacheFile.c_str(), std::ios::binary);
+            CacheHeader header;
+            if(input.read((char*)&header, sizeof(header)) && header.magic == MAGIC && header.hash == hash){
+                std::vector<char> binary(header.size);
+                if(input.read(binary.data(), binary.size()) && program.loadBinary(header.format, binary)){
+                    m_hits++;
+                    return program;
+                }
+            }
+        }
+
+        // Missing or stale : compile from the sources
+        m_misses++;
+        Shader vs(GL_VERTEX_SHADER);
+        vs.setSource(vsSource.c_str());
+        if(!vs.compile()){
+            throw std::runtime_error("Compilation error for vertex shader (from file " + vsFile.str() + "): " + vs.getInfoLog());
+        }
+        Shader fs(GL_FRAGMENT_SHADER);
+        fs.setSource(fsSource.c_str());
+        if(!fs.compile()){
+            throw std::runtime_error("Compilation error for fragment shader (from file " + fsFile.str() + "): " + fs.getInfoLog());
+        }
+        program.attachShader(vs);
+        program.attachShader(fs);
+        if(m_supported){
+            glProgramParameteri(program.getGLId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        if(!program.link()){
+            throw std::runtime_error("Link error (for files " + vsFile.str() + " and " + fsFile.str() + "): " + program.getInfoLog());
+        }
+
+        GLenum format;
+        std::vector<char> binary;
+        if(m_supported && program.getBinary(format, binary)){
+            CacheHeader header = { MAGIC, format, hash, (uint32_t)binary.size(), 0 };
+            std::ofstream output(cacheFile.c_str(), std::ios::binary | std::ios::trunc);
+            if(!output.write((const char*)&header, sizeof(header)) || !output.write(binary.data(), binary.size())){
+                // Not fatal : the program is compiled again next time
+                std::cerr << "[WARNING] Unable to write the program cache " << cacheFile << std::endl;
+            }
+        }
+        return program;
+    }
+
+}
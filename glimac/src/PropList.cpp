@@ -0,0 +1,215 @@
+/**
+ * \file PropList.cpp
+ * \brief Objets 3D posés dans la scène
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Décors de la scène : des maillages importés, référencés par leur identifiant et dessinés par instances
+ *
+ */
+
+#include "glimac/PropList.hpp"
+#include <limits>
+
+namespace glimac {
+
+    PropList::PropList():
+        m_dirty(false),
+        m_drawCallCount(0) {
+    }
+
+    PropList::~PropList(){
+        for(size_t i=0; i<m_meshes.size(); i++){
+            glDeleteVertexArrays(1, &m_meshes[i].vao);
+            glDeleteBuffers(1, &m_meshes[i].buffer);
+            glDeleteBuffers(1, &m_meshes[i].instanceBuffer);
+        }
+    }
+
+    int PropList::addMesh(std::unique_ptr<BakedMesh> mesh, GLuint texture){
+        MeshSlot slot;
+        slot.texture = texture;
+        slot.instanceCount = 0;
+        mesh->upload(slot.vao, slot.buffer);
+        slot.mesh = std::move(mesh);
+
+        // One model matrix per instance, a mat4 takes four attribute locations
+        glGenBuffers(1, &slot.instanceBuffer);
+        glBindVertexArray(slot.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, slot.instanceBuffer);
+        for(GLuint column=0; column<4; column++){
+            glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + column);
+            glVertexAttribPointer(INSTANCE_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (const GLvoid*)(column*sizeof(glm::vec4)));
+            glVertexAttribDivisor(INSTANCE_ATTRIBUTE + column, 1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        m_meshes.push_back(std::move(slot));
+        return m_meshes.size() - 1;
+    }
+
+    int PropList::addProp(const Prop& prop){
+        if(prop.meshId < 0 || prop.meshId >= getMeshCount()){
+            return -1;
+        }
+        m_props.push_back(prop);
+        m_dirty = true;
+        return m_props.size() - 1;
+    }
+
+    void PropList::setProp(int index, const Prop& prop){
+        if(prop.meshId < 0 || prop.meshId >= getMeshCount()){
+            return;
+        }
+        m_props[index] = prop;
+        m_dirty = true;
+    }
+
+    void PropList::deleteProp(int index){
+        m_props.erase(m_props.begin() + index);
+        m_dirty = true;
+    }
+
+    void PropList::clear(){
+        m_props.clear();
+        m_dirty = true;
+    }
+
+    void PropList::uploadInstances(){
+        // Counting sort of the matrices by mesh : each mesh gets one contiguous range
+        std::vector<size_t> first(m_meshes.size() + 1, 0);
+        for(size_t i=0; i<m_props.size(); i++){
+            first[m_props[i].meshId + 1]++;
+        }
+        for(size_t m=0; m<m_meshes.size(); m++){
+            first[m + 1] += first[m];
+        }
+        std::vector<glm::mat4> matrices(m_props.size());
+        std::vector<size_t> next(first.begin(), first.end() - 1);
+        for(size_t i=0; i<m_props.size(); i++){
+            matrices[next[m_props[i].meshId]++] = m_props[i].getModelMatrix();
+        }
+
+        for(size_t m=0; m<m_meshes.size(); m++){
+            MeshSlot& slot = m_meshes[m];
+            slot.instanceCount = first[m + 1] - first[m];
+            if(slot.instanceCount == 0){
+                continue;
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, slot.instanceBuffer);
+            glBufferData(GL_ARRAY_BUFFER, slot.instanceCount*sizeof(glm::mat4), &matrices[first[m]], GL_DYNAMIC_DRAW);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_dirty = false;
+    }
+
+    void PropList::draw(){
+        if(m_dirty){
+            uploadInstances();
+        }
+        m_drawCallCount = 0;
+        glActiveTexture(GL_TEXTURE0);
+        for(size_t m=0; m<m_meshes.size(); m++){
+            const MeshSlot& slot = m_meshes[m];
+            if(slot.instanceCount == 0){
+                continue;
+            }
+            glBindTexture(GL_TEXTURE_2D, slot.texture);
+            glBindVertexArray(slot.vao);
+            glDrawElementsInstanced(GL_TRIANGLES, slot.mesh->getIndexCount(), GL_UNSIGNED_INT, (const GLvoid*)slot.mesh->getIndexOffset(), slot.instanceCount);
+            m_drawCallCount++;
+        }
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    bool PropList::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, PropRayHit& hit) const{
+        if(glm::length(direction) == 0.0f){
+            return false;
+        }
+        const glm::vec3 d = glm::normalize(direction);
+        float closest = maxDistance;
+        bool found = false;
+        for(size_t i=0; i<m_props.size(); i++){
+            // Mesh space : an affine transform keeps the ray parameter, the distance stays in world units
+            const glm::mat4 model = m_props[i].getModelMatrix();
+            const glm::mat4 inverseModel = glm::inverse(model);
+            const glm::vec3 meshOrigin = glm::vec3(inverseModel*glm::vec4(origin, 1.0f));
+            const glm::vec3 meshDirection = glm::vec3(inverseModel*glm::vec4(d, 0.0f));
+            MeshRayHit meshHit;
+            if(m_meshes[m_props[i].meshId].mesh->getBVH().intersectRay(meshOrigin, meshDirection, closest, meshHit)){
+                closest = meshHit.distance;
+                found = true;
+                hit.prop = i;
+                hit.triangle = meshHit.triangle;
+                hit.distance = meshHit.distance;
+                hit.normal = glm::normalize(glm::transpose(glm::mat3(inverseModel))*meshHit.normal);
+            }
+        }
+        return found;
+    }
+
+    int PropList::findInBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const{
+        std::vector<uint32_t> candidates;
+        for(size_t i=0; i<m_props.size(); i++){
+            // The box turned into mesh space is bounded by a larger box : its triangles are then tested in world space
+            const glm::mat4 model = m_props[i].getModelMatrix();
+            const glm::mat4 inverseModel = glm::inverse(model);
+            glm::vec3 meshMin(std::numeric_limits<float>::max()), meshMax(-std::numeric_limits<float>::max());
+            for(int corner=0; corner<8; corner++){
+                const glm::vec3 point((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y, (corner & 4) ? boxMax.z : boxMin.z);
+                const glm::vec3 meshPoint = glm::vec3(inverseModel*glm::vec4(point, 1.0f));
+                meshMin = glm::min(meshMin, meshPoint);
+                meshMax = glm::max(meshMax, meshPoint);
+            }
+            const BakedMesh& mesh = *m_meshes[m_props[i].meshId].mesh;
+            candidates.clear();
+            mesh.getBVH().queryBox(meshMin, meshMax, candidates);
+            const ShapeVertex* vertices = mesh.getVertices();
+            const uint32_t* indices = mesh.getIndices();
+            for(size_t c=0; c<candidates.size(); c++){
+                const uint32_t* triangle = indices + 3*candidates[c];
+                if(triangleOverlapsBox(glm::vec3(model*glm::vec4(vertices[triangle[0]].position, 1.0f)),
+                                       glm::vec3(model*glm::vec4(vertices[triangle[1]].position, 1.0f)),
+                                       glm::vec3(model*glm::vec4(vertices[triangle[2]].position, 1.0f)), boxMin, boxMax)){
+                    return i;
+                }
+            }
+        }
+        return -1;
+    }
+
+    bool PropList::save(const std::string& filepath) const{
+        std::ofstream file(filepath);
+        if(!file){
+            std::cerr << "[ERROR] Unable to save the props in " << filepath << std::endl;
+            return false;
+        }
+        for(size_t i=0; i<m_props.size(); i++){
+            const Prop& prop = m_props[i];
+            file << prop.meshId << " " << prop.position.x << " " << prop.position.y << " " << prop.position.z
+                 << " " << prop.rotation << " " << prop.scale << "\n";
+        }
+        return true;
+    }
+
+    bool PropList::load(const std::string& filepath){
+        clear();
+        // Scenes saved before the props have no props file
+        std::ifstream file(filepath);
+        if(!file){
+            return false;
+        }
+        Prop prop;
+        while(file >> prop.meshId >> prop.position.x >> prop.position.y >> prop.position.z >> prop.rotation >> prop.scale){
+            if(addProp(prop) < 0){
+                std::cerr << "[WARNING] " << filepath << " : unknown mesh " << prop.meshId << ", prop skipped" << std::endl;
+            }
+        }
+        std::cout << "Loading... " << m_props.size() << "...props" << std::endl;
+        return true;
+    }
+
+}
@@ -0,0 +1,94 @@
+/**
+ * \file RangeAllocator.cpp
+ * \brief Sous-allocation de plages dans un buffer
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Allocation de plages contiguës (en éléments) dans un grand buffer, sans appel OpenGL
+ *
+ */
+
+#include "glimac/RangeAllocator.hpp"
+#include <iterator>
+
+namespace glimac {
+
+    const GLuint RangeAllocator::INVALID;
+
+    RangeAllocator::RangeAllocator(GLuint capacity):
+        m_capacity(0),
+        m_used(0) {
+        grow(capacity);
+    }
+
+    GLuint RangeAllocator::allocate(GLuint size){
+        if(size == 0){
+            return INVALID;
+        }
+        // Best fit : the smallest free range that is large enough
+        auto best = m_bySize.lower_bound(size);
+        if(best == m_bySize.end()){
+            return INVALID;
+        }
+        const GLuint offset = best->second;
+        const GLuint remaining = best->first - size;
+        eraseFree(m_free.find(offset));
+        if(remaining > 0){
+            insertFree(offset + size, remaining);
+        }
+        m_used += size;
+        return offset;
+    }
+
+    void RangeAllocator::release(GLuint offset, GLuint size){
+        if(size == 0){
+            return;
+        }
+        m_used -= size;
+        auto next = m_free.lower_bound(offset);
+        // Merge with the preceding free range
+        if(next != m_free.begin()){
+            auto previous = std::prev(next);
+            if(previous->first + previous->second == offset){
+                offset = previous->first;
+                size += previous->second;
+                eraseFree(previous);
+            }
+        }
+        // Merge with the following free range
+        if(next != m_free.end() && next->first == offset + size){
+            size += next->second;
+            eraseFree(next);
+        }
+        insertFree(offset, size);
+    }
+
+    void RangeAllocator::insertFree(GLuint offset, GLuint size){
+        m_free[offset] = size;
+        m_bySize.insert(std::make_pair(size, offset));
+    }
+
+    void RangeAllocator::eraseFree(std::map<GLuint, GLuint>::iterator it){
+        auto range = m_bySize.equal_range(it->second);
+        for(auto entry = range.first; entry != range.second; ++entry){
+            if(entry->second == it->first){
+                m_bySize.erase(entry);
+                break;
+            }
+        }
+        m_free.erase(it);
+    }
+
+    void RangeAllocator::grow(GLuint capacity){
+        if(capacity <= m_capacity){
+            return;
+        }
+        const GLuint oldCapacity = m_capacity;
+        m_capacity = capacity;
+        // The new space is a free range released at the end
+        m_used += capacity - oldCapacity;
+        release(oldCapacity, capacity - oldCapacity);
+    }
+
+}
@@ -46,7 +46,8 @@ bool SDLWindowManager::pollEvent(SDL_Event& e) {
 }
 
 bool SDLWindowManager::isKeyPressed(SDL_Keycode key) const {
-    return SDL_GetKeyboardState(nullptr)[key];
+    // The keyboard state is indexed by scancode (physical key), not by keycode
+    return SDL_GetKeyboardState(nullptr)[SDL_GetScancodeFromKey(key)];
 }
 
 // button can SDL_BUTTON_LEFT, SDL_BUTTON_RIGHT and SDL_BUTTON_MIDDLE
@@ -60,6 +61,12 @@ glm::ivec2 SDLWindowManager::getMousePosition() const {
     return mousePos;
 }
 
+glm::ivec2 SDLWindowManager::getWindowSize() const {
+    glm::ivec2 size;
+    SDL_GetWindowSize(window, &size.x, &size.y);
+    return size;
+}
+
 void SDLWindowManager::swapBuffers() {
     SDL_GL_SwapWindow(window);
 }
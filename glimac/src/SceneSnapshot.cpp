@@ -0,0 +1,146 @@
+/**
+ * \file SceneSnapshot.cpp
+ * \brief Copie figée d'une scène
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Contenu d'une scène (cubes, lumières, objets) échangé entre le thread de scène et le thread de rendu :
+ * lecture, écriture et génération procédurale
+ *
+ */
+
+#include "glimac/SceneSnapshot.hpp"
+
+namespace glimac {
+
+    std::shared_ptr<SceneSnapshot> SceneSnapshot::capture(const CubeList& cubeList, const SceneLights& lights, const PropList* propList){
+        std::shared_ptr<SceneSnapshot> scene(new SceneSnapshot());
+        scene->cubes.resize(cubeList.getSize());
+        for(size_t i=0; i<scene->cubes.size(); i++){
+            scene->cubes[i].position = glm::ivec3(cubeList.getTrans(i));
+            scene->cubes[i].texture = cubeList.getTextureIndex(i);
+        }
+        scene->lights = lights;
+        scene->hasLights = true;
+        if(propList){
+            for(int i=0; i<propList->getSize(); i++){
+                scene->props.push_back(propList->getProp(i));
+            }
+            scene->hasProps = true;
+        }
+        return scene;
+    }
+
+    bool writeSceneFile(const std::string& filepath, const SceneSnapshot& scene){
+        std::ofstream file(filepath);
+        if(!file){
+            std::cerr << "[ERROR] Unable to save the scene in " << filepath << std::endl;
+            return false;
+        }
+        for(size_t i=0; i<scene.cubes.size(); i++){
+            const SceneCube& cube = scene.cubes[i];
+            file << i << " " << cube.position.x << " " << cube.position.y << " " << cube.position.z << " " << cube.texture << " \n";
+        }
+        // Write lights
+        const SceneLights& lights = scene.lights;
+        file << lights.item_LightD << " " << lights.positionLightD[0] << " " << lights.positionLightD[1] << " "
+             << lights.positionLightD[2] << " " << lights.lightIntensity[0] << "\n";
+        file << lights.item_LightP << " " << lights.positionLightP[0] << " " << lights.positionLightP[1] << " "
+             << lights.positionLightP[2] << " " << lights.lightIntensity[1] << "\n";
+        if(!file){
+            std::cerr << "[ERROR] Unable to save the scene in " << filepath << std::endl;
+            return false;
+        }
+        if(!scene.hasProps){
+            return true;
+        }
+
+        std::ofstream propFile(filepath + ".props");
+        if(!propFile){
+            std::cerr << "[ERROR] Unable to save the props in " << filepath << ".props" << std::endl;
+            return false;
+        }
+        for(size_t i=0; i<scene.props.size(); i++){
+            const Prop& prop = scene.props[i];
+            propFile << prop.meshId << " " << prop.position.x << " " << prop.position.y << " " << prop.position.z
+                     << " " << prop.rotation << " " << prop.scale << "\n";
+        }
+        return true;
+    }
+
+    bool readSceneFile(const std::string& filepath, SceneSnapshot& scene){
+        std::ifstream file(filepath);
+        if(!file){
+            std::cerr << "[ERROR] Unable to open the scene " << filepath << std::endl;
+            return false;
+        }
+        std::vector<int> values;
+        int x;
+        while(file >> x){
+            values.push_back(x);
+        }
+        // Five values per cube (index, position, texture), then two lights of five values
+        if(values.size() < 10 || (values.size() - 10)%5 != 0){
+            std::cerr << "[ERROR] " << filepath << " is not a scene file" << std::endl;
+            return false;
+        }
+        const size_t cubeCount = (values.size() - 10)/5;
+        scene.cubes.resize(cubeCount);
+        for(size_t i=0; i<cubeCount; i++){
+            const int* cube = &values[5*i];
+            scene.cubes[i].position = glm::ivec3(cube[1], cube[2], cube[3]);
+            scene.cubes[i].texture = cube[4];
+        }
+        const int* light = &values[5*cubeCount];
+        scene.lights.item_LightD = light[0];
+        scene.lights.positionLightD = {light[1], light[2], light[3]};
+        scene.lights.lightIntensity[0] = light[4];
+        scene.lights.item_LightP = light[5];
+        scene.lights.positionLightP = {light[6], light[7], light[8]};
+        scene.lights.lightIntensity[1] = light[9];
+        scene.hasLights = true;
+
+        // Scenes saved before the props have no props file
+        scene.props.clear();
+        scene.hasProps = true;
+        std::ifstream propFile(filepath + ".props");
+        Prop prop;
+        while(propFile >> prop.meshId >> prop.position.x >> prop.position.y >> prop.position.z >> prop.rotation >> prop.scale){
+            scene.props.push_back(prop);
+        }
+        std::cout << "Loading... " << cubeCount << "...cubes, " << scene.props.size() << "...props" << std::endl;
+        return true;
+    }
+
+    void generateScene(const Eigen::MatrixXd& controlPoints, const std::string& rbf, float epsilon, SceneSnapshot& scene){
+        scene.cubes.clear();
+        scene.hasLights = false;
+        scene.hasProps = false;
+        if(controlPoints.rows() == 0){
+            return;
+        }
+        // Grid covering the control points
+        double lowerX = controlPoints(0,0), higherX = controlPoints(0,0);
+        double lowerZ = controlPoints(0,2), higherZ = controlPoints(0,2);
+        for(int i=1; i<controlPoints.rows(); i++){
+            lowerX = std::min(lowerX, controlPoints(i,0));
+            higherX = std::max(higherX, controlPoints(i,0));
+            lowerZ = std::min(lowerZ, controlPoints(i,2));
+            higherZ = std::max(higherZ, controlPoints(i,2));
+        }
+        // The weights only depend on the control points
+        const Eigen::VectorXd weights = CubeList::radialBasisFunction(controlPoints, rbf, epsilon);
+        for(int i=lowerX; i<=higherX; i++){
+            for(int j=lowerZ; j<=higherZ; j++){
+                int y = CubeList::interpolatePoints(i, j, controlPoints, weights);
+                if(y>-15){
+                    SceneCube cube = {glm::ivec3(i, y, j), 1};
+                    scene.cubes.push_back(cube);
+                }
+            }
+        }
+        std::cout << "Generating... " << scene.cubes.size() << "...cubes" << std::endl;
+    }
+
+}
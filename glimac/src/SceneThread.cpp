@@ -0,0 +1,368 @@
+/**
+ * \file SceneThread.cpp
+ * \brief Thread de scène
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Le thread de scène possède la liste de cubes : les éditions, le chargement, la sauvegarde et la
+ * génération lui sont envoyés par une file de commandes, il remaille les blocs modifiés et publie
+ * des images figées que le thread de rendu envoie au GPU
+ *
+ */
+
+#include "glimac/SceneThread.hpp"
+
+namespace glimac {
+
+    namespace {
+        // Length of the mouse picking ray
+        const float PICK_DISTANCE = 100.0f;
+    }
+
+    SceneThread::SceneThread(JobSystem* jobs):
+        m_pending(0),
+        m_stopping(false),
+        m_viewer(0.0f),
+        m_cursor(0),
+        m_viewChanged(true),
+        m_jobs(jobs),
+        m_meshViewer(0.0f),
+        m_statusCursor(0),
+        m_picked(false) {
+        // Started last : every attribute is ready
+        m_thread = std::thread(&SceneThread::work, this);
+    }
+
+    SceneThread::~SceneThread(){
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    void SceneThread::load(const std::string& filepath){
+        SceneCommand command;
+        command.type = SCENE_LOAD;
+        command.path = filepath;
+        push(command);
+    }
+
+    void SceneThread::save(const std::string& filepath, const SceneLights& lights, const PropList& propList){
+        SceneCommand command;
+        command.type = SCENE_SAVE;
+        command.path = filepath;
+        command.lights = lights;
+        for(int i=0; i<propList.getSize(); i++){
+            command.props.push_back(propList.getProp(i));
+        }
+        push(command);
+    }
+
+    void SceneThread::generate(const Eigen::MatrixXd& controlPoints, const std::string& rbf, float epsilon){
+        SceneCommand command;
+        command.type = SCENE_GENERATE;
+        command.controlPoints = controlPoints;
+        command.rbf = rbf;
+        command.epsilon = epsilon;
+        push(command);
+    }
+
+    void SceneThread::addCube(const glm::ivec3& cell, GLuint texture){
+        SceneCommand command;
+        command.type = SCENE_ADD_CUBE;
+        command.cell = cell;
+        command.texture = texture;
+        push(command);
+    }
+
+    void SceneThread::deleteCube(const glm::ivec3& cell){
+        SceneCommand command;
+        command.type = SCENE_DELETE_CUBE;
+        command.cell = cell;
+        push(command);
+    }
+
+    void SceneThread::setTexture(const glm::ivec3& cell, GLuint texture){
+        SceneCommand command;
+        command.type = SCENE_SET_TEXTURE;
+        command.cell = cell;
+        command.texture = texture;
+        push(command);
+    }
+
+    void SceneThread::extrude(const glm::ivec3& cell, GLuint texture){
+        SceneCommand command;
+        command.type = SCENE_EXTRUDE;
+        command.cell = cell;
+        command.texture = texture;
+        push(command);
+    }
+
+    void SceneThread::dig(const glm::ivec3& cell){
+        SceneCommand command;
+        command.type = SCENE_DIG;
+        command.cell = cell;
+        push(command);
+    }
+
+    void SceneThread::setEmission(GLuint texture, int level){
+        SceneCommand command;
+        command.type = SCENE_SET_EMISSION;
+        command.texture = texture;
+        command.level = level;
+        push(command);
+    }
+
+    void SceneThread::setSparseStorage(bool sparse){
+        SceneCommand command;
+        command.type = SCENE_SET_SPARSE;
+        command.sparse = sparse;
+        push(command);
+    }
+
+    void SceneThread::pick(const glm::vec3& origin, const glm::vec3& direction, bool frontCell, const PropRayHit* propHit){
+        SceneCommand command;
+        command.type = SCENE_PICK;
+        command.origin = origin;
+        command.direction = direction;
+        command.frontCell = frontCell;
+        command.propFound = propHit != nullptr;
+        if(propHit){
+            command.propHit = *propHit;
+        }
+        push(command);
+    }
+
+    void SceneThread::setView(const glm::vec3& viewerPosition, const glm::ivec3& cursor){
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            if(viewerPosition == m_viewer && cursor == m_cursor){
+                return;
+            }
+            m_viewer = viewerPosition;
+            m_cursor = cursor;
+            m_viewChanged = true;
+        }
+        m_wake.notify_one();
+    }
+
+    std::shared_ptr<const SceneFrame> SceneThread::takeFrame(){
+        return std::atomic_exchange(&m_published, std::shared_ptr<SceneFrame>());
+    }
+
+    void SceneThread::push(SceneCommand& command){
+        if(isFileCommand(command.type)){
+            m_pending++;
+        }
+        // A full queue is drained by the scene thread, the command is only moved once there is room
+        while(!m_commands.push(std::move(command))){
+            std::this_thread::yield();
+        }
+        // Taking the lock orders this push before the scene thread going to sleep checks the queue
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wake.notify_one();
+    }
+
+    // Every cube of the list is replaced, in the order of the scene
+    void SceneThread::replaceCubes(const SceneSnapshot& scene){
+        while(m_cubeList.getSize()){
+            m_cubeList.popCube();
+        }
+        for(size_t i=0; i<scene.cubes.size(); i++){
+            Cube cube;
+            cube.setTrans(scene.cubes[i].position.x, scene.cubes[i].position.y, scene.cubes[i].position.z);
+            cube.setTextureIndex(scene.cubes[i].texture);
+            m_cubeList.addCube(cube);
+        }
+    }
+
+    int SceneThread::findCube(const glm::ivec3& cell) const{
+        if(m_cubeList.findAt(cell.x, cell.y, cell.z) == 0){
+            return -1;
+        }
+        for(int i=0; i<(int)m_cubeList.getSize(); i++){
+            if(m_cubeList.getTrans(i) == glm::vec3(cell)){
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void SceneThread::execute(SceneCommand& command){
+        const glm::ivec3 up(0, 1, 0);
+        switch(command.type){
+            case SCENE_SAVE: {
+                std::shared_ptr<SceneSnapshot> scene = SceneSnapshot::capture(m_cubeList, command.lights);
+                scene->props.swap(command.props);
+                scene->hasProps = true;
+                writeSceneFile(command.path, *scene);
+                break;
+            }
+            case SCENE_LOAD:
+            case SCENE_GENERATE: {
+                std::shared_ptr<SceneSnapshot> scene(new SceneSnapshot());
+                if(command.type == SCENE_LOAD){
+                    if(!readSceneFile(command.path, *scene)){
+                        return;
+                    }
+                }else{
+                    generateScene(command.controlPoints, command.rbf, command.epsilon, *scene);
+                }
+                replaceCubes(*scene);
+                // Only the lights and props are left for the render thread
+                std::vector<SceneCube>().swap(scene->cubes);
+                m_loadedScenes.push_back(scene);
+                break;
+            }
+            case SCENE_ADD_CUBE: {
+                Cube cube;
+                cube.setTrans(command.cell.x, command.cell.y, command.cell.z);
+                cube.setTextureIndex(command.texture);
+                m_cubeList.addCube(cube);
+                break;
+            }
+            case SCENE_DELETE_CUBE: {
+                const int index = findCube(command.cell);
+                if(index != -1){
+                    m_cubeList.deleteCube(index);
+                }
+                break;
+            }
+            case SCENE_SET_TEXTURE: {
+                const int index = findCube(command.cell);
+                if(index != -1){
+                    m_cubeList.setTextureIndex(index, command.texture);
+                }
+                break;
+            }
+            case SCENE_EXTRUDE: {
+                // Checked again here : edits queued before this one may have filled the cell above
+                const glm::ivec3 above = command.cell + up;
+                if(findCube(command.cell) != -1 && m_cubeList.findAt(above.x, above.y, above.z) == 0){
+                    SceneCommand add;
+                    add.type = SCENE_ADD_CUBE;
+                    add.cell = above;
+                    add.texture = command.texture;
+                    execute(add);
+                }else{
+                    std::cout << "[ERROR] Cannot extrude a non-cube or cube with no space above!" << std::endl;
+                }
+                break;
+            }
+            case SCENE_DIG: {
+                const glm::ivec3 above = command.cell + up, under = command.cell - up;
+                const int index = findCube(command.cell);
+                if(index != -1 && m_cubeList.findAt(under.x, under.y, under.z) != 0 && m_cubeList.findAt(above.x, above.y, above.z) == 0){
+                    m_cubeList.deleteCube(index);
+                }else{
+                    std::cout << "[ERROR] Cannot dig a non-cube or cube that is not above a column!" << std::endl;
+                }
+                break;
+            }
+            case SCENE_SET_EMISSION:
+                m_cubeList.setEmission(command.texture, command.level);
+                break;
+            case SCENE_SET_SPARSE:
+                m_cubeList.setSparseStorage(command.sparse);
+                break;
+            case SCENE_PICK: {
+                // Props in front of the voxel hit win, the prop ray is cast by the render thread
+                VoxelRayHit hit;
+                const bool voxelHit = m_cubeList.getStorage().raycast(command.origin, command.direction, PICK_DISTANCE, hit);
+                const bool propHit = command.propFound && (!voxelHit || command.propHit.distance < hit.distance);
+                m_pick = ScenePick();
+                m_pick.found = voxelHit || propHit;
+                if(propHit){
+                    const glm::vec3 point = command.origin + glm::normalize(command.direction) * command.propHit.distance;
+                    if(command.frontCell){
+                        m_pick.cell = glm::ivec3(glm::round(point + 0.5f * command.propHit.normal));
+                    }else{
+                        m_pick.cell = glm::ivec3(glm::round(point));
+                        m_pick.prop = command.propHit.prop;
+                    }
+                }else if(voxelHit){
+                    m_pick.cell = command.frontCell ? hit.cell + hit.normal : hit.cell;
+                }
+                m_picked = true;
+                break;
+            }
+        }
+    }
+
+    // Remeshes the edited chunks and publishes them, merged into the frame not taken yet if any
+    void SceneThread::publish(){
+        m_cubeList.updateMeshes(m_meshViewer, m_jobs);
+
+        std::shared_ptr<SceneFrame> frame = std::atomic_exchange(&m_published, std::shared_ptr<SceneFrame>());
+        if(!frame){
+            frame.reset(new SceneFrame());
+        }
+        // Copied : the list keeps its meshes to rebuild them, the render thread reads the copies without locking
+        const std::vector<int64_t> updated = m_cubeList.takeUpdatedChunks();
+        for(size_t i=0; i<updated.size(); i++){
+            const ChunkMesh* mesh = m_cubeList.getChunkMesh(updated[i]);
+            frame->meshes[updated[i]] = mesh ? std::shared_ptr<const ChunkMesh>(new ChunkMesh(*mesh)) : std::shared_ptr<const ChunkMesh>();
+        }
+        frame->scenes.insert(frame->scenes.end(), m_loadedScenes.begin(), m_loadedScenes.end());
+        m_loadedScenes.clear();
+        if(m_picked){
+            frame->picked = true;
+            frame->pick = m_pick;
+            m_picked = false;
+        }
+
+        SceneStatus& status = frame->status;
+        const glm::ivec3& cell = m_statusCursor;
+        status.cursor = cell;
+        status.cursorCube = findCube(cell);
+        status.cursorTexture = (status.cursorCube != -1) ? m_cubeList.getTextureIndex(status.cursorCube) : 0;
+        status.cubeAbove = m_cubeList.findAt(cell.x, cell.y + 1, cell.z) != 0;
+        status.cubeUnder = m_cubeList.findAt(cell.x, cell.y - 1, cell.z) != 0;
+        status.cubeCount = m_cubeList.getSize();
+        status.storageMemory = m_cubeList.getStorage().getMemoryUsage();
+        status.lightMemory = m_cubeList.getLight().getMemoryUsage();
+
+        std::atomic_store(&m_published, frame);
+    }
+
+    void SceneThread::work(){
+        SceneCommand command;
+        while(true){
+            bool changed = false;
+            int finished = 0;
+            while(m_commands.pop(command)){
+                finished += isFileCommand(command.type);
+                execute(command);
+                // Release the scene and the control points before sleeping
+                command = SceneCommand();
+                changed = true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+                if(m_viewChanged){
+                    m_meshViewer = m_viewer;
+                    m_statusCursor = m_cursor;
+                    m_viewChanged = false;
+                    changed = true;
+                }
+            }
+            // One remeshing for the whole batch of commands
+            if(changed){
+                publish();
+            }
+            m_pending -= finished;
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this](){ return m_stopping || m_viewChanged || !m_commands.isEmpty(); });
+            if(m_stopping && m_commands.isEmpty()){
+                return;
+            }
+        }
+    }
+
+}
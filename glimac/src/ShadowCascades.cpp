@@ -0,0 +1,218 @@
+/**
+ * \file ShadowCascades.cpp
+ * \brief Ombres de la lumière directionnelle
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Cartes d'ombres en cascades pour la lumière directionnelle, gardées en cache tant que la scène
+ * et la lumière ne changent pas
+ *
+ */
+
+#include "glimac/ShadowCascades.hpp"
+#include <limits>
+
+namespace glimac {
+
+    namespace {
+        // Shadows stop at this view depth (or at the far plane if closer)
+        const float MAX_DISTANCE = 96.0f;
+        // Blend between logarithmic (1) and uniform (0) splits
+        const float SPLIT_LAMBDA = 0.75f;
+        // A cascade covers this much more than its slice : the camera can move a little before it is re-rendered
+        const float COVERAGE = 1.25f;
+        // Extra depth around the casters, in world units
+        const float DEPTH_MARGIN = 1.0f;
+        // Slope scaled depth bias of the shadow pass
+        const float POLYGON_OFFSET_FACTOR = 2.0f;
+        const float POLYGON_OFFSET_UNITS = 4.0f;
+
+        // Light space rectangle and depth range of a world space box
+        void lightSpaceBounds(const glm::mat4& lightView, const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3& lo, glm::vec3& hi){
+            lo = glm::vec3(std::numeric_limits<float>::max());
+            hi = glm::vec3(-std::numeric_limits<float>::max());
+            for(int i=0; i<8; i++){
+                const glm::vec3 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+                const glm::vec3 p = glm::vec3(lightView * glm::vec4(corner, 1.0f));
+                lo = glm::min(lo, p);
+                hi = glm::max(hi, p);
+            }
+        }
+    }
+
+    const int ShadowCascades::CASCADE_COUNT;
+    const int ShadowCascades::RESOLUTION;
+    const GLuint ShadowCascades::TEXTURE_UNIT;
+
+    ShadowCascades::ShadowCascades():
+        m_lightDirection(0.0f),
+        m_renderedCount(0) {
+        for(int i=0; i<CASCADE_COUNT; i++){
+            m_cascades[i].center = glm::vec2(0.0f);
+            m_cascades[i].halfSize = 0.0f;
+            m_cascades[i].depthRange = glm::vec2(0.0f);
+            m_cascades[i].splitFar = 0.0f;
+            m_cascades[i].dirty = true;
+        }
+
+        // One depth layer per cascade, compared by the sampler (hardware 2x2 filtering)
+        glGenTextures(1, &m_texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, RESOLUTION, RESOLUTION, CASCADE_COUNT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        // Depth only framebuffer, the layer is attached before each cascade
+        glGenFramebuffers(1, &m_framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            std::cerr << "[ERROR] Shadow framebuffer is incomplete" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ShadowCascades::~ShadowCascades(){
+        glDeleteFramebuffers(1, &m_framebuffer);
+        glDeleteTextures(1, &m_texture);
+    }
+
+    void ShadowCascades::update(const ChunkRenderer& chunkRenderer, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightDirection){
+        const float nearPlane = projection[3][2]/(projection[2][2] - 1.0f);
+        const float farPlane = projection[3][2]/(projection[2][2] + 1.0f);
+        const float distance = std::min(farPlane, MAX_DISTANCE);
+        const float tanX = 1.0f/projection[0][0];
+        const float tanY = 1.0f/projection[1][1];
+        m_inverseView = glm::inverse(view);
+
+        // The light space only depends on the light : cached cascades stay valid when the camera moves
+        const glm::vec3 direction = glm::normalize(lightDirection);
+        const bool lightMoved = glm::dot(direction, m_lightDirection) < 0.9999f;
+        if(lightMoved){
+            m_lightDirection = direction;
+            const glm::vec3 up = (std::abs(direction.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            m_lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+        }
+
+        // Every caster of the scene must be inside the depth range of a cascade
+        glm::vec3 sceneMin, sceneMax, sceneLo, sceneHi;
+        const bool hasScene = chunkRenderer.getBounds(sceneMin, sceneMax);
+        if(hasScene){
+            lightSpaceBounds(m_lightView, sceneMin, sceneMax, sceneLo, sceneHi);
+        }
+        const std::vector<glm::ivec3>& updated = chunkRenderer.getUpdatedOrigins();
+
+        float splitNear = nearPlane;
+        for(int i=0; i<CASCADE_COUNT; i++){
+            Cascade& cascade = m_cascades[i];
+            const float ratio = float(i+1)/CASCADE_COUNT;
+            const float splitFar = SPLIT_LAMBDA*nearPlane*std::pow(distance/nearPlane, ratio) + (1.0f - SPLIT_LAMBDA)*(nearPlane + (distance - nearPlane)*ratio);
+            cascade.splitFar = splitFar;
+
+            // Bounding sphere of the slice : its size does not change with the camera orientation
+            const float middle = 0.5f*(splitNear + splitFar);
+            const float radius = glm::length(glm::vec3(splitFar*tanX, splitFar*tanY, splitFar - middle));
+            const glm::vec3 center = glm::vec3(m_lightView * m_inverseView * glm::vec4(0.0f, 0.0f, -middle, 1.0f));
+            splitNear = splitFar;
+
+            const float halfSize = radius*COVERAGE;
+            bool fits = !lightMoved && std::abs(cascade.halfSize - halfSize) <= 0.01f*halfSize
+                && std::abs(center.x - cascade.center.x) + radius <= cascade.halfSize
+                && std::abs(center.y - cascade.center.y) + radius <= cascade.halfSize;
+            if(fits && hasScene){
+                fits = sceneLo.z >= cascade.depthRange.x && sceneHi.z <= cascade.depthRange.y;
+            }
+            if(!fits){
+                // Snapped to the texel grid : re-rendered cascades do not shimmer
+                const float texel = 2.0f*halfSize/RESOLUTION;
+                cascade.halfSize = halfSize;
+                cascade.center = glm::floor(glm::vec2(center)/texel)*texel;
+                cascade.depthRange = glm::vec2(center.z - radius, center.z + radius);
+                if(hasScene){
+                    cascade.depthRange = glm::vec2(std::min(cascade.depthRange.x, sceneLo.z), std::max(cascade.depthRange.y, sceneHi.z));
+                }
+                cascade.depthRange += glm::vec2(-DEPTH_MARGIN, DEPTH_MARGIN);
+                const glm::mat4 lightProjection = glm::ortho(cascade.center.x - halfSize, cascade.center.x + halfSize,
+                    cascade.center.y - halfSize, cascade.center.y + halfSize, -cascade.depthRange.y, -cascade.depthRange.x);
+                cascade.viewProjection = lightProjection * m_lightView;
+                cascade.dirty = true;
+            }
+
+            // Only the chunks remeshed under the cascade invalidate it
+            for(size_t j=0; j<updated.size() && !cascade.dirty; j++){
+                const glm::vec3 boxMin = glm::vec3(updated[j]) - glm::vec3(0.5f);
+                glm::vec3 lo, hi;
+                lightSpaceBounds(m_lightView, boxMin, boxMin + glm::vec3(Chunk::SIZE), lo, hi);
+                cascade.dirty = lo.x <= cascade.center.x + cascade.halfSize && hi.x >= cascade.center.x - cascade.halfSize
+                    && lo.y <= cascade.center.y + cascade.halfSize && hi.y >= cascade.center.y - cascade.halfSize;
+            }
+        }
+    }
+
+    void ShadowCascades::render(ChunkRenderer& chunkRenderer, GLint uLightViewProjection){
+        m_renderedCount = 0;
+        bool dirty = false;
+        for(int i=0; i<CASCADE_COUNT; i++){
+            dirty = dirty || m_cascades[i].dirty;
+        }
+        if(!dirty){
+            return;
+        }
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+        glViewport(0, 0, RESOLUTION, RESOLUTION);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+        for(int i=0; i<CASCADE_COUNT; i++){
+            Cascade& cascade = m_cascades[i];
+            if(!cascade.dirty){
+                continue;
+            }
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glUniformMatrix4fv(uLightViewProjection, 1, GL_FALSE, glm::value_ptr(cascade.viewProjection));
+            chunkRenderer.drawDepth(cascade.viewProjection);
+            cascade.dirty = false;
+            m_renderedCount++;
+        }
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    void ShadowCascades::bind() const{
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void ShadowCascades::fillFrameData(FrameData& frame) const{
+        // From view space to [0, 1] texture coordinates and depth of each cascade
+        const glm::mat4 bias = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+        for(int i=0; i<CASCADE_COUNT; i++){
+            frame.shadowMatrices[i] = bias * m_cascades[i].viewProjection * m_inverseView;
+        }
+        frame.shadowSplits = glm::vec4(m_cascades[0].splitFar, m_cascades[1].splitFar, m_cascades[2].splitFar, 1.0f);
+    }
+
+    // Like the light cluster samplers : the shadow sampler must not stay on unit 0
+    void ShadowCascades::bindSamplers(GLuint program){
+        const GLint location = glGetUniformLocation(program, "uShadowMap");
+        if(location != -1){
+            glUniform1i(location, TEXTURE_UNIT);
+        }
+    }
+
+}
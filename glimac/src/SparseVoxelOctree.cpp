@@ -0,0 +1,311 @@
+/**
+ * \file SparseVoxelOctree.cpp
+ * \brief Octree creux de voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Octree creux dont les noeuds homogènes sont fusionnés (scènes très grandes et peu denses)
+ *
+ */
+
+#include "glimac/SparseVoxelOctree.hpp"
+#include <limits>
+
+namespace glimac {
+
+    const uint32_t SparseVoxelOctree::LEAF;
+
+    namespace {
+        const int INITIAL_DEPTH = 4;
+        const int MAX_DEPTH = 21;
+
+        // Child slot of a local position in a node whose children have edge "half"
+        int childSlot(const glm::ivec3& local, int half){
+            return (local.x >= half ? 1 : 0) | (local.y >= half ? 2 : 0) | (local.z >= half ? 4 : 0);
+        }
+
+        glm::ivec3 childOffset(int slot, int half){
+            return glm::ivec3((slot & 1) ? half : 0, (slot & 2) ? half : 0, (slot & 4) ? half : 0);
+        }
+    }
+
+    SparseVoxelOctree::SparseVoxelOctree(){
+        clear();
+    }
+
+    void SparseVoxelOctree::clear(){
+        m_nodes.assign(1, Node());
+        m_freeBlocks.clear();
+        m_depth = INITIAL_DEPTH;
+        m_origin = glm::ivec3(-(1 << (INITIAL_DEPTH-1)));
+    }
+
+    bool SparseVoxelOctree::contains(const glm::ivec3& position) const{
+        const int size = 1 << m_depth;
+        glm::ivec3 local = position - m_origin;
+        return local.x >= 0 && local.y >= 0 && local.z >= 0 && local.x < size && local.y < size && local.z < size;
+    }
+
+    GLuint SparseVoxelOctree::get(const glm::ivec3& position) const{
+        if(!contains(position)){
+            return 0;
+        }
+        glm::ivec3 leafOrigin;
+        int leafSize;
+        return m_nodes[findLeaf(position - m_origin, leafOrigin, leafSize)].value;
+    }
+
+    uint32_t SparseVoxelOctree::findLeaf(const glm::ivec3& local, glm::ivec3& leafOrigin, int& leafSize) const{
+        uint32_t node = 0;
+        int size = 1 << m_depth;
+        leafOrigin = glm::ivec3(0);
+        while(m_nodes[node].children != LEAF){
+            size >>= 1;
+            const int slot = childSlot(local - leafOrigin, size);
+            leafOrigin += childOffset(slot, size);
+            node = m_nodes[node].children + slot;
+        }
+        leafSize = size;
+        return node;
+    }
+
+    void SparseVoxelOctree::set(const glm::ivec3& position, GLuint value){
+        if(!contains(position)){
+            if(value == 0){
+                return;
+            }
+            growToContain(position);
+            if(!contains(position)){
+                return;
+            }
+        }
+
+        // Descend, splitting uniform leaves on the way
+        uint32_t path[MAX_DEPTH+1];
+        int pathLength = 0;
+        glm::ivec3 local = position - m_origin;
+        uint32_t node = 0;
+        int size = 1 << m_depth;
+        while(size > 1){
+            if(m_nodes[node].children == LEAF){
+                if(m_nodes[node].value == value){
+                    return;
+                }
+                const uint32_t block = allocateBlock(m_nodes[node].value);
+                m_nodes[node].children = block;
+            }
+            path[pathLength++] = node;
+            size >>= 1;
+            const int slot = childSlot(local, size);
+            local -= childOffset(slot, size);
+            node = m_nodes[node].children + slot;
+        }
+        if(m_nodes[node].value == value){
+            return;
+        }
+        m_nodes[node].value = value;
+
+        // Collapse parents whose 8 children became identical leaves
+        for(int i=pathLength-1; i>=0; i--){
+            const uint32_t first = m_nodes[path[i]].children;
+            for(int k=0; k<8; k++){
+                if(m_nodes[first+k].children != LEAF || m_nodes[first+k].value != value){
+                    return;
+                }
+            }
+            m_freeBlocks.push_back(first);
+            m_nodes[path[i]].children = LEAF;
+            m_nodes[path[i]].value = value;
+        }
+    }
+
+    // Double the root edge until it contains the position; the old root becomes one of the children
+    void SparseVoxelOctree::growToContain(const glm::ivec3& position){
+        while(!contains(position)){
+            if(m_depth >= MAX_DEPTH){
+                std::cerr << "[ERROR] Octree cannot grow to reach (" << position.x << ", " << position.y << ", " << position.z << ")." << std::endl;
+                return;
+            }
+            const int size = 1 << m_depth;
+            glm::ivec3 newOrigin = m_origin;
+            int slot = 0;
+            for(int axis=0; axis<3; axis++){
+                if(position[axis] < m_origin[axis]){
+                    newOrigin[axis] -= size;
+                    slot |= (1 << axis);
+                }
+            }
+            const Node oldRoot = m_nodes[0];
+            if(oldRoot.children != LEAF || oldRoot.value != 0){
+                const uint32_t block = allocateBlock(0);
+                m_nodes[block + slot] = oldRoot;
+                m_nodes[0] = Node();
+                m_nodes[0].children = block;
+            }
+            m_origin = newOrigin;
+            m_depth++;
+        }
+    }
+
+    uint32_t SparseVoxelOctree::allocateBlock(GLuint value){
+        uint32_t block;
+        if(!m_freeBlocks.empty()){
+            block = m_freeBlocks.back();
+            m_freeBlocks.pop_back();
+        }else{
+            block = m_nodes.size();
+            m_nodes.resize(m_nodes.size()+8);
+        }
+        for(int k=0; k<8; k++){
+            m_nodes[block+k] = Node(value);
+        }
+        return block;
+    }
+
+    void SparseVoxelOctree::getCells(std::vector<VoxelCell>& out) const{
+        collectCells(0, m_origin, 1 << m_depth, 1, out);
+    }
+
+    void SparseVoxelOctree::extractLOD(int level, std::vector<VoxelCell>& out) const{
+        collectCells(0, m_origin, 1 << m_depth, 1 << std::max(level, 0), out);
+    }
+
+    void SparseVoxelOctree::collectCells(uint32_t node, const glm::ivec3& origin, int size, int minSize, std::vector<VoxelCell>& out) const{
+        const Node& n = m_nodes[node];
+        if(n.children == LEAF){
+            if(n.value != 0){
+                out.push_back(VoxelCell(origin, size, n.value));
+            }
+            return;
+        }
+        if(size <= minSize){
+            // Representative value : the non-empty value covering the largest volume
+            std::unordered_map<GLuint, long long> volumes;
+            accumulateVolume(node, size, volumes);
+            GLuint best = 0;
+            long long bestVolume = 0;
+            for(auto it = volumes.begin(); it != volumes.end(); ++it){
+                if(it->second > bestVolume){
+                    best = it->first;
+                    bestVolume = it->second;
+                }
+            }
+            if(best != 0){
+                out.push_back(VoxelCell(origin, size, best));
+            }
+            return;
+        }
+        const int half = size/2;
+        for(int slot=0; slot<8; slot++){
+            collectCells(n.children + slot, origin + childOffset(slot, half), half, minSize, out);
+        }
+    }
+
+    void SparseVoxelOctree::accumulateVolume(uint32_t node, int size, std::unordered_map<GLuint, long long>& volumes) const{
+        const Node& n = m_nodes[node];
+        if(n.children == LEAF){
+            if(n.value != 0){
+                volumes[n.value] += (long long)size*size*size;
+            }
+            return;
+        }
+        for(int slot=0; slot<8; slot++){
+            accumulateVolume(n.children + slot, size/2, volumes);
+        }
+    }
+
+    size_t SparseVoxelOctree::getMemoryUsage() const{
+        return sizeof(SparseVoxelOctree) + m_nodes.capacity()*sizeof(Node) + m_freeBlocks.capacity()*sizeof(uint32_t);
+    }
+
+    // Walk the leaves crossed by the ray : empty regions are skipped one whole node at a time
+    bool SparseVoxelOctree::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, VoxelRayHit& hit) const{
+        if(glm::length(direction) == 0.0f){
+            return false;
+        }
+        const glm::vec3 d = glm::normalize(direction);
+        // Local grid space : voxel v covers [v - origin, v - origin + 1]
+        const glm::vec3 o = origin + glm::vec3(0.5f) - glm::vec3(m_origin);
+        const float size = float(1 << m_depth);
+
+        // Clip the ray against the root box
+        float tMin = 0.0f, tMax = maxDistance;
+        int entryAxis = -1;
+        for(int axis=0; axis<3; axis++){
+            if(d[axis] == 0.0f){
+                if(o[axis] < 0.0f || o[axis] >= size){
+                    return false;
+                }
+                continue;
+            }
+            float t1 = (0.0f - o[axis])/d[axis];
+            float t2 = (size - o[axis])/d[axis];
+            if(t1 > t2){
+                std::swap(t1, t2);
+            }
+            if(t1 > tMin){
+                tMin = t1;
+                entryAxis = axis;
+            }
+            tMax = std::min(tMax, t2);
+            if(tMin > tMax){
+                return false;
+            }
+        }
+
+        const int rootSize = 1 << m_depth;
+        glm::ivec3 cell = glm::ivec3(glm::floor(o + d*tMin));
+        cell = glm::clamp(cell, glm::ivec3(0), glm::ivec3(rootSize-1));
+        if(entryAxis != -1){
+            cell[entryAxis] = (d[entryAxis] > 0.0f) ? 0 : rootSize-1;
+        }
+        int lastAxis = entryAxis;
+        float t = tMin;
+
+        while(true){
+            glm::ivec3 leafOrigin;
+            int leafSize;
+            const uint32_t leaf = findLeaf(cell, leafOrigin, leafSize);
+            if(m_nodes[leaf].value != 0){
+                hit.cell = cell + m_origin;
+                hit.normal = glm::ivec3(0);
+                if(lastAxis != -1){
+                    hit.normal[lastAxis] = (d[lastAxis] > 0.0f) ? -1 : 1;
+                }
+                hit.value = m_nodes[leaf].value;
+                hit.distance = t;
+                return true;
+            }
+
+            // Leave the leaf through its nearest exit face
+            float tExit = std::numeric_limits<float>::max();
+            int axis = -1;
+            for(int a=0; a<3; a++){
+                if(d[a] > 0.0f){
+                    float tt = (float(leafOrigin[a] + leafSize) - o[a])/d[a];
+                    if(tt < tExit){ tExit = tt; axis = a; }
+                }else if(d[a] < 0.0f){
+                    float tt = (float(leafOrigin[a]) - o[a])/d[a];
+                    if(tt < tExit){ tExit = tt; axis = a; }
+                }
+            }
+            if(axis == -1 || tExit > tMax){
+                return false;
+            }
+            t = std::max(t, tExit);
+            const glm::vec3 p = o + d*t;
+            for(int a=0; a<3; a++){
+                if(a != axis){
+                    cell[a] = glm::clamp(int(std::floor(p[a])), leafOrigin[a], leafOrigin[a] + leafSize - 1);
+                }
+            }
+            cell[axis] = (d[axis] > 0.0f) ? leafOrigin[axis] + leafSize : leafOrigin[axis] - 1;
+            if(cell[axis] < 0 || cell[axis] >= rootSize){
+                return false;
+            }
+            lastAxis = axis;
+        }
+    }
+
+}
@@ -17,8 +17,8 @@ namespace glimac {
 Texture::Texture(){};
 Texture::~Texture(){};
 // Renvoit le pointeur vers les données
-void Texture::setUniformLocation(Program &program, const GLchar* name){
-    m_uTexture = glGetUniformLocation(program.getGLId(), name);
+void Texture::setUniformLocation(const Program &program, const GLchar* name){
+    m_uTexture = program.getUniformLocation(name);
 }
 
 void Texture::setImage(const FilePath &filepath){
@@ -29,4 +29,14 @@ void Texture::setImage(const FilePath &filepath){
     }
 }
 
+void Texture::upload(std::unique_ptr<BakedTexture> baked){
+    if(baked == NULL){
+        // The loader already printed the file and the reason
+        std::cerr << "Une texture n'a pas pu etre chargée. \n" << std::endl;
+        exit(0);
+    }
+    // Mipmaps included, the file mapping is released with the baked texture
+    m_texture = baked->upload();
+}
+
 }
@@ -0,0 +1,371 @@
+/**
+ * \file TextureCache.cpp
+ * \brief Textures préparées pour le GPU
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Cache des textures décodées, avec leurs mipmaps et éventuellement compressées (BC1/BC3), à
+ * envoyer telles quelles au GPU
+ *
+ */
+
+#include "glimac/TextureCache.hpp"
+#include "glimac/stb_image.h"
+#include <cstring>
+#include <stdint.h>
+
+namespace glimac {
+
+    namespace {
+        const uint32_t MAGIC = 0x58455457; // "WTEX"
+        const uint32_t VERSION = 1;
+        // Larger than any texture a driver accepts : a bigger header is corrupted
+        const uint32_t MAX_SIZE = 1 << 15;
+
+        struct CacheHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t format;
+            uint32_t width;
+            uint32_t height;
+            uint32_t levelCount;
+            uint64_t sourceSize;
+            int64_t sourceTime;
+            uint64_t dataSize;
+        };
+
+        bool isCompressed(GLenum format){
+            return format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                || format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        }
+
+        bool isValidChain(const CacheHeader& header){
+            if(header.width == 0 || header.height == 0 || header.width > MAX_SIZE || header.height > MAX_SIZE || header.levelCount == 0
+                || (!isCompressed(header.format) && header.format != GL_RGBA8)){
+                return false;
+            }
+            uint32_t fullChain = 1;
+            for(uint32_t size = std::max(header.width, header.height); size > 1; size /= 2){
+                fullChain++;
+            }
+            if(header.levelCount > fullChain){
+                return false;
+            }
+            uint64_t chainSize = 0;
+            for(uint32_t level=0; level<header.levelCount; level++){
+                chainSize += getLevelSize(header.format, std::max(header.width >> level, 1u), std::max(header.height >> level, 1u));
+            }
+            return chainSize == header.dataSize;
+        }
+
+        // 2x2 box filter, the last row or column is repeated on odd sizes
+        std::vector<unsigned char> downsample(const std::vector<unsigned char>& pixels, int width, int height){
+            const int halfWidth = std::max(width/2, 1);
+            const int halfHeight = std::max(height/2, 1);
+            std::vector<unsigned char> half(halfWidth*halfHeight*4);
+            for(int y=0; y<halfHeight; y++){
+                const int y0 = std::min(2*y, height-1), y1 = std::min(2*y+1, height-1);
+                for(int x=0; x<halfWidth; x++){
+                    const int x0 = std::min(2*x, width-1), x1 = std::min(2*x+1, width-1);
+                    for(int c=0; c<4; c++){
+                        const int sum = pixels[(y0*width + x0)*4 + c] + pixels[(y0*width + x1)*4 + c]
+                                      + pixels[(y1*width + x0)*4 + c] + pixels[(y1*width + x1)*4 + c];
+                        half[(y*halfWidth + x)*4 + c] = (unsigned char)((sum + 2)/4);
+                    }
+                }
+            }
+            return half;
+        }
+
+        uint16_t to565(const float* color){
+            const int r = glm::clamp(int(color[0]*31.0f/255.0f + 0.5f), 0, 31);
+            const int g = glm::clamp(int(color[1]*63.0f/255.0f + 0.5f), 0, 63);
+            const int b = glm::clamp(int(color[2]*31.0f/255.0f + 0.5f), 0, 31);
+            return uint16_t((r << 11) | (g << 5) | b);
+        }
+
+        void from565(uint16_t color, int* out){
+            out[0] = ((color >> 11) & 31)*255/31;
+            out[1] = ((color >> 5) & 63)*255/63;
+            out[2] = (color & 31)*255/31;
+        }
+
+        // BC1 colour block : endpoints at both ends of the principal axis of the 16 colours
+        void encodeColorBlock(const unsigned char* block, unsigned char* out){
+            float mean[3] = {0.0f, 0.0f, 0.0f};
+            for(int i=0; i<16; i++){
+                for(int c=0; c<3; c++){
+                    mean[c] += block[i*4 + c]/16.0f;
+                }
+            }
+            float covariance[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}; // rr rg rb gg gb bb
+            for(int i=0; i<16; i++){
+                const float r = block[i*4] - mean[0], g = block[i*4 + 1] - mean[1], b = block[i*4 + 2] - mean[2];
+                covariance[0] += r*r; covariance[1] += r*g; covariance[2] += r*b;
+                covariance[3] += g*g; covariance[4] += g*b; covariance[5] += b*b;
+            }
+            // Power iteration : a few steps are enough to pick the direction
+            float axis[3] = {1.0f, 1.0f, 1.0f};
+            for(int step=0; step<4; step++){
+                const float x = covariance[0]*axis[0] + covariance[1]*axis[1] + covariance[2]*axis[2];
+                const float y = covariance[1]*axis[0] + covariance[3]*axis[1] + covariance[4]*axis[2];
+                const float z = covariance[2]*axis[0] + covariance[4]*axis[1] + covariance[5]*axis[2];
+                const float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+                if(length <= 0.0f){
+                    break;
+                }
+                axis[0] = x/length; axis[1] = y/length; axis[2] = z/length;
+            }
+            int minIndex = 0, maxIndex = 0;
+            float minProjection = 1e9f, maxProjection = -1e9f;
+            for(int i=0; i<16; i++){
+                const float projection = block[i*4]*axis[0] + block[i*4 + 1]*axis[1] + block[i*4 + 2]*axis[2];
+                if(projection < minProjection){ minProjection = projection; minIndex = i; }
+                if(projection > maxProjection){ maxProjection = projection; maxIndex = i; }
+            }
+            float high[3], low[3];
+            for(int c=0; c<3; c++){
+                high[c] = block[maxIndex*4 + c];
+                low[c] = block[minIndex*4 + c];
+            }
+            uint16_t color0 = to565(high), color1 = to565(low);
+            // color0 > color1 selects the 4 colour mode
+            if(color0 < color1){
+                std::swap(color0, color1);
+            }
+            uint32_t indices = 0;
+            if(color0 != color1){
+                int palette[4][3];
+                from565(color0, palette[0]);
+                from565(color1, palette[1]);
+                for(int c=0; c<3; c++){
+                    palette[2][c] = (2*palette[0][c] + palette[1][c])/3;
+                    palette[3][c] = (palette[0][c] + 2*palette[1][c])/3;
+                }
+                for(int i=0; i<16; i++){
+                    int best = 0, bestDistance = 1 << 30;
+                    for(int p=0; p<4; p++){
+                        const int dr = block[i*4] - palette[p][0], dg = block[i*4 + 1] - palette[p][1], db = block[i*4 + 2] - palette[p][2];
+                        const int distance = dr*dr + dg*dg + db*db;
+                        if(distance < bestDistance){
+                            bestDistance = distance;
+                            best = p;
+                        }
+                    }
+                    indices |= uint32_t(best) << (2*i);
+                }
+            }
+            out[0] = color0 & 0xFF; out[1] = color0 >> 8;
+            out[2] = color1 & 0xFF; out[3] = color1 >> 8;
+            for(int i=0; i<4; i++){
+                out[4 + i] = (indices >> (8*i)) & 0xFF;
+            }
+        }
+
+        // BC3 alpha block : 8 interpolated values between the extremes
+        void encodeAlphaBlock(const unsigned char* block, unsigned char* out){
+            int alpha0 = 0, alpha1 = 255;
+            for(int i=0; i<16; i++){
+                alpha0 = std::max(alpha0, (int)block[i*4 + 3]);
+                alpha1 = std::min(alpha1, (int)block[i*4 + 3]);
+            }
+            uint64_t indices = 0;
+            if(alpha0 != alpha1){
+                int palette[8] = {alpha0, alpha1};
+                for(int p=1; p<7; p++){
+                    palette[p + 1] = ((7 - p)*alpha0 + p*alpha1)/7;
+                }
+                for(int i=0; i<16; i++){
+                    int best = 0, bestDistance = 256;
+                    for(int p=0; p<8; p++){
+                        const int distance = std::abs(block[i*4 + 3] - palette[p]);
+                        if(distance < bestDistance){
+                            bestDistance = distance;
+                            best = p;
+                        }
+                    }
+                    indices |= uint64_t(best) << (3*i);
+                }
+            }
+            out[0] = (unsigned char)alpha0;
+            out[1] = (unsigned char)alpha1;
+            for(int i=0; i<6; i++){
+                out[2 + i] = (indices >> (8*i)) & 0xFF;
+            }
+        }
+
+        // Appends one level, blocks of 4x4 pixels (edges repeated)
+        void encodeLevel(const std::vector<unsigned char>& pixels, int width, int height, GLenum format, std::vector<unsigned char>& out){
+            unsigned char block[64];
+            for(int by=0; by<height; by+=4){
+                for(int bx=0; bx<width; bx+=4){
+                    for(int y=0; y<4; y++){
+                        for(int x=0; x<4; x++){
+                            const int px = std::min(bx + x, width-1), py = std::min(by + y, height-1);
+                            std::memcpy(block + (y*4 + x)*4, &pixels[(py*width + px)*4], 4);
+                        }
+                    }
+                    const size_t offset = out.size();
+                    if(format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT){
+                        out.resize(offset + 16);
+                        encodeAlphaBlock(block, &out[offset]);
+                        encodeColorBlock(block, &out[offset + 8]);
+                    }else{
+                        out.resize(offset + 8);
+                        encodeColorBlock(block, &out[offset]);
+                    }
+                }
+            }
+        }
+    }
+
+    BakedTexture::BakedTexture():
+        m_levels(nullptr),
+        m_format(GL_RGBA8),
+        m_width(0),
+        m_height(0),
+        m_levelCount(0),
+        m_fromCache(false) {
+    }
+
+    std::unique_ptr<BakedTexture> BakedTexture::load(const FilePath& source, bool compress){
+        std::unique_ptr<BakedTexture> texture(new BakedTexture());
+        const FilePath cacheFile = source.replaceExt("wtex");
+        if(texture->open(cacheFile, source, compress) || texture->bake(source, cacheFile, compress)){
+            return texture;
+        }
+        return std::unique_ptr<BakedTexture>();
+    }
+
+    bool BakedTexture::open(const FilePath& cacheFile, const FilePath& source, bool compress){
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if(!getFileStamp(source, sourceSize, sourceTime) || !m_file.open(cacheFile) || m_file.getSize() < sizeof(CacheHeader)){
+            return false;
+        }
+        CacheHeader header;
+        std::memcpy(&header, m_file.getData(), sizeof(header));
+        if(header.magic != MAGIC || header.version != VERSION || header.sourceSize != sourceSize || header.sourceTime != sourceTime
+            || isCompressed(header.format) != compress || header.dataSize != m_file.getSize() - sizeof(header)){
+            m_file.close();
+            return false;
+        }
+        // The mip chain described by the header must fill the data exactly, at most down to 1x1
+        if(!isValidChain(header)){
+            std::cerr << "[WARNING] Corrupted texture cache " << cacheFile << ", baked again" << std::endl;
+            m_file.close();
+            return false;
+        }
+        m_format = header.format;
+        m_width = header.width;
+        m_height = header.height;
+        m_levelCount = header.levelCount;
+        m_levels = m_file.getData() + sizeof(header);
+        m_fromCache = true;
+        return true;
+    }
+
+    bool BakedTexture::bake(const FilePath& source, const FilePath& cacheFile, bool compress){
+        int width, height, components;
+        unsigned char* data = stbi_load(source.c_str(), &width, &height, &components, 4);
+        if(!data){
+            std::cerr << "loading image " << source << " error: " << stbi_failure_reason() << std::endl;
+            return false;
+        }
+        std::vector<unsigned char> pixels(data, data + width*height*4);
+        stbi_image_free(data);
+
+        m_format = GL_RGBA8;
+        if(compress){
+            bool opaque = true;
+            for(size_t i=3; i<pixels.size() && opaque; i+=4){
+                opaque = pixels[i] == 255;
+            }
+            m_format = opaque ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        }
+        m_width = width;
+        m_height = height;
+        m_levelCount = 0;
+        m_baked.clear();
+        while(true){
+            if(compress){
+                encodeLevel(pixels, width, height, m_format, m_baked);
+            }else{
+                m_baked.insert(m_baked.end(), pixels.begin(), pixels.end());
+            }
+            m_levelCount++;
+            if(width == 1 && height == 1){
+                break;
+            }
+            pixels = downsample(pixels, width, height);
+            width = std::max(width/2, 1);
+            height = std::max(height/2, 1);
+        }
+        m_levels = m_baked.data();
+        m_fromCache = false;
+
+        // Not fatal if the cache cannot be written : baked again next launch
+        CacheHeader header;
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.format = m_format;
+        header.width = m_width;
+        header.height = m_height;
+        header.levelCount = m_levelCount;
+        header.dataSize = m_baked.size();
+        if(getFileStamp(source, header.sourceSize, header.sourceTime)){
+            std::ofstream output(cacheFile.c_str(), std::ios::binary | std::ios::trunc);
+            if(!output.write((const char*)&header, sizeof(header)) || !output.write((const char*)m_baked.data(), m_baked.size())){
+                std::cerr << "[WARNING] Unable to write the texture cache " << cacheFile << std::endl;
+            }
+        }
+        return true;
+    }
+
+    GLuint BakedTexture::upload() const{
+        return uploadMipChain(m_format, m_width, m_height, m_levelCount, m_levels);
+    }
+
+    std::future<std::unique_ptr<BakedTexture> > loadBakedTextureAsync(ThreadPool& pool, const FilePath& source, bool compress){
+        return pool.submit([source, compress](){ return BakedTexture::load(source, compress); });
+    }
+
+    size_t getLevelSize(GLenum format, GLsizei width, GLsizei height){
+        const size_t blocks = size_t((width + 3)/4)*((height + 3)/4);
+        if(format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT){
+            return blocks*8;
+        }
+        if(isCompressed(format)){
+            return blocks*16;
+        }
+        return size_t(width)*height*4;
+    }
+
+    GLuint uploadMipChain(GLenum format, GLsizei width, GLsizei height, GLsizei levelCount, const unsigned char* levels){
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        size_t offset = 0;
+        for(GLsizei level=0; level<levelCount; level++){
+            const size_t size = getLevelSize(format, width, height);
+            if(isCompressed(format)){
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, (GLsizei)size, levels + offset);
+            }else{
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels + offset);
+            }
+            offset += size;
+            width = std::max(width/2, 1);
+            height = std::max(height/2, 1);
+        }
+
+        // Only the uploaded levels are sampled
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, std::max(levelCount - 1, 0));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (levelCount > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return texture;
+    }
+
+}
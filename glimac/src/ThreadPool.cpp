@@ -0,0 +1,56 @@
+/**
+ * \file ThreadPool.cpp
+ * \brief Groupe de threads de travail
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Threads de travail qui exécutent des tâches en parallèle du thread principal
+ *
+ */
+
+#include "glimac/ThreadPool.hpp"
+
+namespace glimac {
+
+    ThreadPool::ThreadPool(unsigned int threadCount):
+        m_stopping(false) {
+        if(threadCount == 0){
+            // hardware_concurrency may answer 0 when unknown
+            const unsigned int cores = std::thread::hardware_concurrency();
+            threadCount = (cores > 1) ? cores - 1 : 1;
+        }
+        for(unsigned int i=0; i<threadCount; i++){
+            m_threads.push_back(std::thread(&ThreadPool::work, this));
+        }
+    }
+
+    ThreadPool::~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_condition.notify_all();
+        for(size_t i=0; i<m_threads.size(); i++){
+            m_threads[i].join();
+        }
+    }
+
+    void ThreadPool::work(){
+        while(true){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this](){ return m_stopping || !m_tasks.empty(); });
+                if(m_tasks.empty()){
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            // Exceptions are stored in the future by the packaged task
+            task();
+        }
+    }
+
+}
@@ -0,0 +1,51 @@
+/**
+ * \file UniformBuffer.cpp
+ * \brief Blocs d'uniformes partagés par les shaders
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Données de l'image (caméra, lumières) et du matériau, envoyées une fois par image dans des UBO
+ *
+ */
+
+#include "glimac/UniformBuffer.hpp"
+
+namespace glimac {
+
+    const GLuint UniformBuffer::FRAME_DATA_BINDING;
+    const GLuint UniformBuffer::MATERIAL_DATA_BINDING;
+
+    UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size):
+        m_binding(binding),
+        m_size(size) {
+        glGenBuffers(1, &m_buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, m_size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer);
+    }
+
+    UniformBuffer::~UniformBuffer(){
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    void UniformBuffer::update(const void* data){
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, m_size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // GLSL 3.30 has no layout(binding) : the block to binding point association is made here, once per program
+    void UniformBuffer::bindBlocks(GLuint program){
+        const GLuint frameData = glGetUniformBlockIndex(program, "FrameData");
+        if(frameData != GL_INVALID_INDEX){
+            glUniformBlockBinding(program, frameData, FRAME_DATA_BINDING);
+        }
+        const GLuint materialData = glGetUniformBlockIndex(program, "MaterialData");
+        if(materialData != GL_INVALID_INDEX){
+            glUniformBlockBinding(program, materialData, MATERIAL_DATA_BINDING);
+        }
+    }
+
+}
@@ -0,0 +1,138 @@
+/**
+ * \file UploadRing.cpp
+ * \brief Tampon circulaire d'envoi au GPU
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Tampon circulaire projeté en mémoire et protégé par des fences, pour envoyer des données au GPU
+ * sans allocation du pilote
+ *
+ */
+
+#include "glimac/UploadRing.hpp"
+#include <cstring>
+
+namespace glimac {
+
+    namespace {
+        // Satisfies GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT on common hardware, so that writes can be bound as ranges
+        const GLsizeiptr WRITE_ALIGNMENT = 256;
+    }
+
+    const GLintptr UploadRing::INVALID;
+
+    UploadRing::UploadRing(GLsizeiptr size):
+        m_sectionSize((size/SECTIONS) & ~(WRITE_ALIGNMENT - 1)),
+        m_section(0),
+        m_head(0),
+        m_mapped(nullptr) {
+        for(int i=0; i<SECTIONS; i++){
+            m_fences[i] = 0;
+            m_touched[i] = false;
+        }
+        glGenBuffers(1, &m_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+        if(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage){
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_COPY_WRITE_BUFFER, m_sectionSize*SECTIONS, nullptr, flags);
+            m_mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_sectionSize*SECTIONS, flags);
+        }
+        else{
+            glBufferData(GL_COPY_WRITE_BUFFER, m_sectionSize*SECTIONS, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    UploadRing::~UploadRing(){
+        for(int i=0; i<SECTIONS; i++){
+            if(m_fences[i]){
+                glDeleteSync(m_fences[i]);
+            }
+        }
+        if(m_mapped){
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    GLintptr UploadRing::write(const void* data, GLsizeiptr size){
+        const GLsizeiptr aligned = (size + WRITE_ALIGNMENT - 1) & ~(WRITE_ALIGNMENT - 1);
+        if(size <= 0 || aligned > m_sectionSize){
+            return INVALID;
+        }
+        if(m_head + aligned > m_sectionSize){
+            nextSection();
+        }
+        const GLintptr offset = m_section*m_sectionSize + m_head;
+        m_head += aligned;
+        m_touched[m_section] = true;
+
+        if(m_mapped){
+            std::memcpy(m_mapped + offset, data, size);
+        }
+        else{
+            // The fences guarantee the GPU is done with this range : no need for the driver to synchronize
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+            void* destination = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            std::memcpy(destination, data, size);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        return offset;
+    }
+
+    void UploadRing::upload(GLuint buffer, GLintptr offset, const void* data, GLsizeiptr size){
+        if(size <= 0){
+            return;
+        }
+        const GLintptr source = write(data, size);
+        if(source == INVALID){
+            // Larger than a section : rare enough to let the driver handle it
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            return;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source, offset, size);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // Fences are set at the end of the frame : the data written in a section may be read by any later command of the frame
+    void UploadRing::endFrame(){
+        for(int i=0; i<SECTIONS; i++){
+            if(m_touched[i]){
+                m_fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                m_touched[i] = false;
+            }
+        }
+        nextSection();
+    }
+
+    void UploadRing::nextSection(){
+        m_section = (m_section + 1) % SECTIONS;
+        m_head = 0;
+        // Wrapping around within a single frame : fence what was submitted so far
+        if(m_touched[m_section]){
+            m_fences[m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        m_touched[m_section] = false;
+
+        // Only blocks when the CPU runs SECTIONS frames ahead of the GPU
+        GLsync fence = m_fences[m_section];
+        if(fence){
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            while(glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED){
+                flags = 0;
+            }
+            glDeleteSync(fence);
+            m_fences[m_section] = 0;
+        }
+    }
+
+}
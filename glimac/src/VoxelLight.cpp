@@ -0,0 +1,278 @@
+/**
+ * \file VoxelLight.cpp
+ * \brief Lumière des voxels (ciel et blocs lumineux)
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Propagation sur le CPU de la lumière du ciel et des blocs lumineux à travers les voxels vides,
+ * mise à jour à chaque ajout ou suppression de voxel
+ *
+ */
+
+#include "glimac/VoxelLight.hpp"
+#include "glimac/ChunkGrid.hpp"
+#include <limits>
+
+namespace glimac {
+
+    const int VoxelLight::MAX_LEVEL;
+
+    namespace {
+        const glm::ivec3 NEIGHBOURS[6] = {
+            glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0),
+            glm::ivec3(0, -1, 0), glm::ivec3(0, 1, 0),
+            glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)
+        };
+
+        // Voxel values are texture indices + 1 : one byte is enough
+        const size_t VALUE_COUNT = 256;
+
+        int64_t columnKey(const glm::ivec3& position){
+            return ChunkGrid::packKey(glm::ivec3(position.x, 0, position.z));
+        }
+    }
+
+    VoxelLight::VoxelLight():
+        m_minY(std::numeric_limits<int>::max()),
+        m_emission(VALUE_COUNT, 0) {
+    }
+
+    bool VoxelLight::seesSky(const glm::ivec3& position) const{
+        auto it = m_tops.find(columnKey(position));
+        return it == m_tops.end() || position.y > it->second;
+    }
+
+    uint8_t VoxelLight::get(const glm::ivec3& position) const{
+        auto it = m_chunks.find(ChunkGrid::packKey(ChunkGrid::toChunkCoord(position)));
+        if(it == m_chunks.end()){
+            return seesSky(position) ? uint8_t(MAX_LEVEL << 4) : 0;
+        }
+        const glm::ivec3 local = ChunkGrid::toLocalCoord(position);
+        return it->second[Chunk::index(local.x, local.y, local.z)];
+    }
+
+    void VoxelLight::getBlock(const glm::ivec3& minCorner, const glm::ivec3& size, uint8_t* out) const{
+        for(int y=0; y<size.y; y++){
+            for(int z=0; z<size.z; z++){
+                for(int x=0; x<size.x; x++){
+                    *out++ = get(minCorner + glm::ivec3(x, y, z));
+                }
+            }
+        }
+    }
+
+    int VoxelLight::getLevel(const glm::ivec3& position, Channel channel) const{
+        const uint8_t levels = get(position);
+        return (channel == SKY) ? (levels >> 4) : (levels & 15);
+    }
+
+    void VoxelLight::setLevel(const glm::ivec3& position, Channel channel, int level){
+        const glm::ivec3 chunkCoord = ChunkGrid::toChunkCoord(position);
+        auto it = m_chunks.find(ChunkGrid::packKey(chunkCoord));
+        if(it == m_chunks.end()){
+            // A new chunk starts from the implicit levels : sky above the columns, dark below
+            std::vector<uint8_t> levels(Chunk::VOLUME, 0);
+            const glm::ivec3 origin = chunkCoord*Chunk::SIZE;
+            for(int z=0; z<Chunk::SIZE; z++){
+                for(int x=0; x<Chunk::SIZE; x++){
+                    auto top = m_tops.find(columnKey(origin + glm::ivec3(x, 0, z)));
+                    for(int y=0; y<Chunk::SIZE; y++){
+                        if(top == m_tops.end() || origin.y + y > top->second){
+                            levels[Chunk::index(x, y, z)] = uint8_t(MAX_LEVEL << 4);
+                        }
+                    }
+                }
+            }
+            it = m_chunks.insert(std::make_pair(ChunkGrid::packKey(chunkCoord), levels)).first;
+        }
+        const glm::ivec3 local = ChunkGrid::toLocalCoord(position);
+        uint8_t& levels = it->second[Chunk::index(local.x, local.y, local.z)];
+        const uint8_t updated = (channel == SKY) ? uint8_t((levels & 15) | (level << 4)) : uint8_t((levels & 0xF0) | level);
+        if(updated == levels){
+            return;
+        }
+        levels = updated;
+
+        // Faces of every chunk within one voxel read this cell (smooth lighting)
+        const glm::ivec3 from = ChunkGrid::toChunkCoord(position - glm::ivec3(1));
+        const glm::ivec3 to = ChunkGrid::toChunkCoord(position + glm::ivec3(1));
+        for(int x=from.x; x<=to.x; x++){
+            for(int y=from.y; y<=to.y; y++){
+                for(int z=from.z; z<=to.z; z++){
+                    m_changedChunks.insert(ChunkGrid::packKey(glm::ivec3(x, y, z)));
+                }
+            }
+        }
+    }
+
+    // Cells keeping their level whatever their neighbours : open sky, glowing voxels
+    bool VoxelLight::isSource(const VoxelStorage& storage, const glm::ivec3& position, Channel channel) const{
+        if(channel == SKY){
+            return seesSky(position);
+        }
+        return getEmission(storage.get(position)) > 0;
+    }
+
+    void VoxelLight::remove(const glm::ivec3& position, Channel channel, int level){
+        setLevel(position, channel, 0);
+        if(level > 0){
+            m_removeQueue[channel].push_back(std::make_pair(position, level));
+        }
+    }
+
+    void VoxelLight::addNeighbours(const glm::ivec3& position, Channel channel){
+        for(int i=0; i<6; i++){
+            m_addQueue[channel].push_back(position + NEIGHBOURS[i]);
+        }
+    }
+
+    // Turn off every cell that was lit through the removed ones, the brighter border is queued for propagation
+    void VoxelLight::depropagate(const VoxelStorage& storage, Channel channel){
+        std::deque<std::pair<glm::ivec3, int> >& queue = m_removeQueue[channel];
+        while(!queue.empty()){
+            const glm::ivec3 position = queue.front().first;
+            const int level = queue.front().second;
+            queue.pop_front();
+            for(int i=0; i<6; i++){
+                const glm::ivec3 neighbour = position + NEIGHBOURS[i];
+                const int neighbourLevel = getLevel(neighbour, channel);
+                if(neighbourLevel == 0){
+                    continue;
+                }
+                if(neighbourLevel < level && !isSource(storage, neighbour, channel)){
+                    remove(neighbour, channel, neighbourLevel);
+                }else{
+                    m_addQueue[channel].push_back(neighbour);
+                }
+            }
+        }
+    }
+
+    // Breadth first : each empty neighbour gets the level minus one, if that is brighter than its own
+    void VoxelLight::propagate(const VoxelStorage& storage, Channel channel){
+        std::deque<glm::ivec3>& queue = m_addQueue[channel];
+        while(!queue.empty()){
+            const glm::ivec3 position = queue.front();
+            queue.pop_front();
+            const int level = getLevel(position, channel);
+            if(level <= 1){
+                continue;
+            }
+            for(int i=0; i<6; i++){
+                const glm::ivec3 neighbour = position + NEIGHBOURS[i];
+                if(storage.get(neighbour) != Chunk::EMPTY || getLevel(neighbour, channel) >= level - 1){
+                    continue;
+                }
+                setLevel(neighbour, channel, level - 1);
+                queue.push_back(neighbour);
+            }
+        }
+    }
+
+    void VoxelLight::update(const VoxelStorage& storage, const glm::ivec3& position, GLuint previous, GLuint value){
+        const bool wasSolid = previous != Chunk::EMPTY;
+        const bool solid = value != Chunk::EMPTY;
+
+        // Block light : the cell loses what it had, then glows or lets its neighbours in
+        remove(position, BLOCK, getLevel(position, BLOCK));
+        if(!solid){
+            addNeighbours(position, BLOCK);
+        }
+        const int emission = getEmission(value);
+        if(emission > 0){
+            setLevel(position, BLOCK, emission);
+            m_addQueue[BLOCK].push_back(position);
+        }
+
+        // Sky light : only an added or dug voxel changes it
+        const int64_t column = columnKey(position);
+        if(solid && !wasSolid){
+            const int sky = getLevel(position, SKY);
+            m_minY = std::min(m_minY, position.y);
+            auto top = m_tops.find(column);
+            if(top == m_tops.end() || position.y > top->second){
+                // The column below loses the sky, down to the former top (or the lowest voxel of the scene)
+                const int bottom = (top == m_tops.end()) ? m_minY - 1 : top->second + 1;
+                m_tops[column] = position.y;
+                for(int y=position.y-1; y>=bottom; y--){
+                    remove(glm::ivec3(position.x, y, position.z), SKY, MAX_LEVEL);
+                }
+            }
+            remove(position, SKY, sky);
+        }else if(!solid && wasSolid){
+            auto top = m_tops.find(column);
+            if(top != m_tops.end() && position.y == top->second){
+                // The column below sees the sky again, down to the next voxel
+                int next = position.y - 1;
+                while(next >= m_minY && storage.get(glm::ivec3(position.x, next, position.z)) == Chunk::EMPTY){
+                    next--;
+                }
+                int bottom = m_minY - 1;
+                if(next >= m_minY){
+                    top->second = next;
+                    bottom = next + 1;
+                }else{
+                    m_tops.erase(top);
+                }
+                for(int y=position.y; y>=bottom; y--){
+                    setLevel(glm::ivec3(position.x, y, position.z), SKY, MAX_LEVEL);
+                    m_addQueue[SKY].push_back(glm::ivec3(position.x, y, position.z));
+                }
+            }else{
+                addNeighbours(position, SKY);
+            }
+        }
+
+        depropagate(storage, SKY);
+        depropagate(storage, BLOCK);
+        propagate(storage, SKY);
+        propagate(storage, BLOCK);
+    }
+
+    void VoxelLight::setEmission(const VoxelStorage& storage, GLuint value, int level){
+        if(value >= m_emission.size() || m_emission[value] == level){
+            return;
+        }
+        m_emission[value] = glm::clamp(level, 0, MAX_LEVEL);
+
+        // Rare edit : all block light is cleared and propagated again from every glowing voxel
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it){
+            const glm::ivec3 origin = ChunkGrid::unpackKey(it->first)*Chunk::SIZE;
+            for(int y=0; y<Chunk::SIZE; y++){
+                for(int z=0; z<Chunk::SIZE; z++){
+                    for(int x=0; x<Chunk::SIZE; x++){
+                        if(it->second[Chunk::index(x, y, z)] & 15){
+                            setLevel(origin + glm::ivec3(x, y, z), BLOCK, 0);
+                        }
+                    }
+                }
+            }
+        }
+        std::vector<VoxelCell> cells;
+        storage.getCells(cells);
+        for(size_t i=0; i<cells.size(); i++){
+            const int emission = getEmission(cells[i].value);
+            if(emission == 0){
+                continue;
+            }
+            for(int x=0; x<cells[i].size; x++){
+                for(int y=0; y<cells[i].size; y++){
+                    for(int z=0; z<cells[i].size; z++){
+                        const glm::ivec3 position = cells[i].position + glm::ivec3(x, y, z);
+                        setLevel(position, BLOCK, emission);
+                        m_addQueue[BLOCK].push_back(position);
+                    }
+                }
+            }
+        }
+        propagate(storage, BLOCK);
+    }
+
+    std::vector<int64_t> VoxelLight::takeChangedChunks(){
+        std::vector<int64_t> changed(m_changedChunks.begin(), m_changedChunks.end());
+        m_changedChunks.clear();
+        return changed;
+    }
+
+}
@@ -0,0 +1,32 @@
+/**
+ * \file VoxelStorage.cpp
+ * \brief Interface de stockage des voxels
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Comportements par défaut de l'interface de stockage des voxels
+ *
+ */
+
+#include "glimac/VoxelStorage.hpp"
+
+namespace glimac {
+
+    bool VoxelStorage::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, VoxelRayHit& hit) const{
+        return voxelDDA(origin, direction, maxDistance, [this](const glm::ivec3& cell) -> GLuint {
+            return this->get(cell);
+        }, hit);
+    }
+
+    void VoxelStorage::getBlock(const glm::ivec3& minCorner, const glm::ivec3& size, GLuint* out) const{
+        for(int y=0; y<size.y; y++){
+            for(int z=0; z<size.z; z++){
+                for(int x=0; x<size.x; x++){
+                    *out++ = get(minCorner + glm::ivec3(x, y, z));
+                }
+            }
+        }
+    }
+
+}
@@ -14,6 +14,9 @@
 #include <string.h>
 
 #include "glimac/text.hpp"
+#include "glimac/TextureCache.hpp"
+#include "glimac/MappedFile.hpp"
+#include <stdint.h>
 
 
 GLuint loadBMP_custom(const char * imagepath){
@@ -107,51 +110,94 @@ GLuint loadBMP_custom(const char * imagepath){
 #define FOURCC_DXT1 0x31545844 // Equivalent to "DXT1" in ASCII
 #define FOURCC_DXT3 0x33545844 // Equivalent to "DXT3" in ASCII
 #define FOURCC_DXT5 0x35545844 // Equivalent to "DXT5" in ASCII
-
-GLuint loadDDS(const char * imagepath){
-
-	unsigned char header[124];
-
-	FILE *fp;
-
-	/* try to open the file */
-	fp = fopen(imagepath, "rb");
-	if (fp == NULL){
-		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath); getchar();
-		return 0;
+#define FOURCC_DX10 0x30315844 // Equivalent to "DX10" in ASCII : a DDS_HEADER_DXT10 follows the header
+
+namespace {
+
+	// Layout of the file after the "DDS " magic (all fields little endian)
+	struct DDSPixelFormat {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t masks[4];
+	};
+
+	struct DDSHeader {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved[11];
+		DDSPixelFormat pixelFormat;
+		uint32_t caps[4];
+		uint32_t reserved2;
+	};
+
+	struct DDSHeaderDX10 {
+		uint32_t dxgiFormat;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+	const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	const uint32_t DDPF_FOURCC = 0x4;
+	const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+	const uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+	// sRGB variants are read as linear : the renderer does not convert colours
+	GLenum formatFromDXGI(uint32_t dxgiFormat){
+		switch(dxgiFormat){
+		case 28: case 29: return GL_RGBA8; // R8G8B8A8_UNORM(_SRGB)
+		case 71: case 72: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; // BC1
+		case 74: case 75: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; // BC2
+		case 77: case 78: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; // BC3
+		default: return 0;
+		}
 	}
 
-	/* verify the type of file */
-	char filecode[4];
-	fread(filecode, 1, 4, fp);
-	if (strncmp(filecode, "DDS ", 4) != 0) {
-		fclose(fp);
+	GLuint failDDS(const char * imagepath, const char * reason){
+		std::cerr << "[ERROR] DDS " << imagepath << " : " << reason << std::endl;
 		return 0;
 	}
 
-	/* get the surface desc */
-	fread(&header, 124, 1, fp);
+}
 
-	unsigned int height      = *(unsigned int*)&(header[8 ]);
-	unsigned int width	     = *(unsigned int*)&(header[12]);
-	unsigned int linearSize	 = *(unsigned int*)&(header[16]);
-	unsigned int mipMapCount = *(unsigned int*)&(header[24]);
-	unsigned int fourCC      = *(unsigned int*)&(header[80]);
+GLuint loadDDS(const char * imagepath){
 
+	// The levels are uploaded straight from the mapping : no copy of the file
+	glimac::MappedFile file;
+	if(!file.open(imagepath)){
+		return failDDS(imagepath, "could not be opened");
+	}
+	const unsigned char * data = file.getData();
+	const size_t fileSize = file.getSize();
 
-	unsigned char * buffer;
-	unsigned int bufsize;
-	/* how big is it going to be including all mipmaps? */
-	bufsize = mipMapCount > 1 ? linearSize * 2 : linearSize;
-	buffer = (unsigned char*)malloc(bufsize * sizeof(unsigned char));
-	fread(buffer, 1, bufsize, fp);
-	/* close the file pointer */
-	fclose(fp);
+	/* verify the type of file */
+	DDSHeader header;
+	if(fileSize < 4 + sizeof(header) || memcmp(data, "DDS ", 4) != 0){
+		return failDDS(imagepath, "not a DDS file");
+	}
+	memcpy(&header, data + 4, sizeof(header));
+	if(header.size != sizeof(DDSHeader) || header.pixelFormat.size != sizeof(DDSPixelFormat)){
+		return failDDS(imagepath, "invalid header");
+	}
+	if(header.width == 0 || header.height == 0){
+		return failDDS(imagepath, "empty image");
+	}
+	size_t offset = 4 + sizeof(header);
 
-	unsigned int components  = (fourCC == FOURCC_DXT1) ? 3 : 4;
-	unsigned int format;
-	switch(fourCC)
-	{
+	/* find the format, from the four CC or the DX10 extension */
+	GLenum format = 0;
+	if(!(header.pixelFormat.flags & DDPF_FOURCC)){
+		return failDDS(imagepath, "uncompressed legacy formats are not supported");
+	}
+	switch(header.pixelFormat.fourCC){
 	case FOURCC_DXT1:
 		format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
 		break;
@@ -161,42 +207,41 @@ GLuint loadDDS(const char * imagepath){
 	case FOURCC_DXT5:
 		format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 		break;
+	case FOURCC_DX10: {
+		DDSHeaderDX10 extension;
+		if(fileSize < offset + sizeof(extension)){
+			return failDDS(imagepath, "truncated DX10 header");
+		}
+		memcpy(&extension, data + offset, sizeof(extension));
+		offset += sizeof(extension);
+		if(extension.resourceDimension != DDS_DIMENSION_TEXTURE2D || (extension.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)){
+			return failDDS(imagepath, "only 2D textures are supported");
+		}
+		// Arrays : the first slice is used
+		format = formatFromDXGI(extension.dxgiFormat);
+		break;
+	}
 	default:
-		free(buffer);
-		return 0;
+		break;
 	}
-
-	// Create one OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-
-	// "Bind" the newly created texture : all future texture functions will modify this texture
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
-
-	unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
-	unsigned int offset = 0;
-
-	/* load the mipmaps */
-	for (unsigned int level = 0; level < mipMapCount && (width || height); ++level)
-	{
-		unsigned int size = ((width+3)/4)*((height+3)/4)*blockSize;
-		glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height,
-			0, size, buffer + offset);
-
-		offset += size;
-		width  /= 2;
-		height /= 2;
-
-		// Deal with Non-Power-Of-Two textures. This code is not included in the webpage to reduce clutter.
-		if(width < 1) width = 1;
-		if(height < 1) height = 1;
-
+	if(format == 0){
+		return failDDS(imagepath, "unsupported pixel format");
 	}
 
-	free(buffer);
-
-	return textureID;
-
+	/* exact size of the mip chain, at most down to 1x1 */
+	unsigned int fullChain = 1;
+	for(unsigned int size = std::max(header.width, header.height); size > 1; size /= 2){
+		fullChain++;
+	}
+	unsigned int mipMapCount = (header.flags & DDSD_MIPMAPCOUNT) ? header.mipMapCount : 1;
+	mipMapCount = std::min(std::max(mipMapCount, 1u), fullChain);
+	size_t chainSize = 0;
+	for(unsigned int level = 0; level < mipMapCount; ++level){
+		chainSize += glimac::getLevelSize(format, std::max(header.width >> level, 1u), std::max(header.height >> level, 1u));
+	}
+	if(chainSize > fileSize - offset){
+		return failDDS(imagepath, "truncated image data");
+	}
 
+	return glimac::uploadMipChain(format, header.width, header.height, mipMapCount, data + offset);
 }
@@ -54,12 +54,17 @@
 // Include GLImac
 #include <glimac/SDLWindowManager.hpp>
 #include <glimac/Program.hpp>
+#include <glimac/ProgramCache.hpp>
 #include <glimac/FilePath.hpp>
 #include <glimac/glm.hpp>
 #include <glimac/Image.hpp>
 #include <glimac/Cube.hpp>
 #include <glimac/Texture.hpp>
+#include <glimac/ThreadPool.hpp>
 #include <glimac/CubeList.hpp>
+#include <glimac/UniformBuffer.hpp>
+#include <glimac/LightClusters.hpp>
+#include <glimac/ShadowCascades.hpp>
 #include <glimac/Controls.hpp>
 
 // Include imGUI
@@ -166,62 +171,70 @@ int main(int argc, char** argv) {
     // Setup Dear ImGui style
     ImGui::StyleColorsDark();
 
+    /** DECODING TEXTURES **/
+    // Worker threads read the baked textures (or bake them on the first launch), while the shaders compile
+    ThreadPool threadPool;
+    const bool compressTextures = GLEW_EXT_texture_compression_s3tc;
+    const char* texturePaths[] = {
+        "../../World_Imaker/assets/textures/rouge.png",
+        "../../World_Imaker/assets/textures/bois.png",
+        "../../World_Imaker/assets/textures/brique.png",
+        "../../World_Imaker/assets/textures/cailloux.png",
+        "../../World_Imaker/assets/textures/eau.png",
+        "../../World_Imaker/assets/textures/goudron.png",
+        "../../World_Imaker/assets/textures/herbe.png",
+        "../../World_Imaker/assets/textures/marbre.png",
+        "../../World_Imaker/assets/textures/mosaique.png",
+        "../../World_Imaker/assets/textures/sol_metalique.png",
+        "../../World_Imaker/assets/textures/white.png",
+        "../../World_Imaker/assets/textures/zero.png",
+        "../../World_Imaker/assets/textures/plus.png",
+        "../../World_Imaker/assets/textures/equal.png"
+    };
+    std::vector<std::future<std::unique_ptr<BakedTexture> > > decodedTextures;
+    for(uint i = 0; i<IM_ARRAYSIZE(texturePaths); i++){
+        decodedTextures.push_back(loadBakedTextureAsync(threadPool, texturePaths[i], compressTextures));
+    }
+
      /** LOADING SHADERS **/
     FilePath applicationPath(argv[0]);
-    Program program = loadProgram(
+    ProgramCache programCache(applicationPath.dirPath() + "shaders");
+    Program program = programCache.load(
         applicationPath.dirPath() + "shaders/vertex.vs.glsl",
         applicationPath.dirPath() + "shaders/fragment.fs.glsl"
     );
     program.use();
 
     // Get uniform variable ID
-    GLint uMVPMatrix = glGetUniformLocation(program.getGLId(), "uMVPMatrix");
-    GLint uMVMatrix = glGetUniformLocation(program.getGLId(), "uMVMatrix");
-    GLint uNormalMatrix = glGetUniformLocation(program.getGLId(), "uNormalMatrix");
-    
-    //Get uniform variables for light
-    GLint uKd = glGetUniformLocation(program.getGLId(), "uKd");
-    GLint uKs = glGetUniformLocation(program.getGLId(), "uKs");
-    GLint uShininess = glGetUniformLocation(program.getGLId(), "uShininess");
-    GLint uLightPos_vs = glGetUniformLocation(program.getGLId(), "uLightPos_vs");
-    GLint uLightDir_vs = glGetUniformLocation(program.getGLId(), "uLightDir_vs");
-    GLint uLightIntensityP = glGetUniformLocation(program.getGLId(), "uLightIntensityP");
-    GLint uLightIntensityD = glGetUniformLocation(program.getGLId(), "uLightIntensityD");
+    GLint uModelMatrix = program.getUniformLocation("uModelMatrix");
+    GLint uNormalMatrix = program.getUniformLocation("uNormalMatrix");
+
+    // Camera and lights are sent once per frame, the material once : shared by every program through their uniform blocks
+    UniformBuffer frameUniforms(UniformBuffer::FRAME_DATA_BINDING, sizeof(FrameData));
+    UniformBuffer materialUniforms(UniformBuffer::MATERIAL_DATA_BINDING, sizeof(MaterialData));
+    MaterialData material;
+    material.diffuse = glm::vec4(0.6, 0.6, 0.6, 0.0);
+    material.specular = glm::vec4(0.0, 0.0, 0.0, 32.0);
+    materialUniforms.update(&material);
+    // Point lights go through the light clusters (texture units 1 to 3)
+    LightClusters lightClusters;
+    LightClusters::bindSamplers(program.getGLId());
+    // No chunk meshes here, hence no shadows : the sampler only has to leave unit 0
+    ShadowCascades::bindSamplers(program.getGLId());
+    std::vector<PointLight> sceneLights(1);
     
     /** INITIALIZE TEXTURES **/
-    uint nbOfTextures = 14;
+    uint nbOfTextures = decodedTextures.size();
     std::vector<Texture> textures(nbOfTextures);
 
     for(int i=0; i<textures.size(); i++){
-        char const *pchar = "uTexture" + i;
-        textures[i].setUniformLocation(program, (GLchar*)pchar);
+        // Every texture is sampled through uTextureSampler, on unit 0
+        textures[i].setUniformLocation(program, "uTextureSampler");
     }
 
-    // Loading textures
-    textures[0].setImage("../../World_Imaker/assets/textures/rouge.png");
-    textures[1].setImage("../../World_Imaker/assets/textures/bois.png");
-    textures[2].setImage("../../World_Imaker/assets/textures/brique.png");
-    textures[3].setImage("../../World_Imaker/assets/textures/cailloux.png");
-    textures[4].setImage("../../World_Imaker/assets/textures/eau.png");
-    textures[5].setImage("../../World_Imaker/assets/textures/goudron.png");
-    textures[6].setImage("../../World_Imaker/assets/textures/herbe.png");
-    textures[7].setImage("../../World_Imaker/assets/textures/marbre.png");
-    textures[8].setImage("../../World_Imaker/assets/textures/mosaique.png");
-    textures[9].setImage("../../World_Imaker/assets/textures/sol_metalique.png");
-    textures[10].setImage("../../World_Imaker/assets/textures/white.png");
-    textures[11].setImage("../../World_Imaker/assets/textures/zero.png");
-    textures[12].setImage("../../World_Imaker/assets/textures/plus.png");
-    textures[13].setImage("../../World_Imaker/assets/textures/equal.png");
-
-    // Textures
+    // Textures : each image is uploaded once its worker thread is done
     for(uint i = 0; i<textures.size(); i++){
-        glGenTextures(1,textures[i].getTexturePointer());
-        glBindTexture(GL_TEXTURE_2D,textures[i].getTexture());   // Texture binding
-        glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,textures[i].getImageWidth(),textures[i].getImageHeight(),0,GL_RGBA,GL_FLOAT,textures[i].getImagePixels());
-
-        //Filters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        textures[i].upload(decodedTextures[i].get());
     }
 
     /** INITIALIZE VBOs **/
@@ -746,13 +759,17 @@ int main(int argc, char** argv) {
         }
 
         // Rendu lumière
-        glUniform3f(uKd, 0.6, 0.6, 0.6);
-        glUniform3f(uKs, 0, 0.0, 0.0);
-        glUniform1f(uShininess, 32.0);
-        glm::vec4 LightPos = ViewMatrix * glm::vec4((float) positionLightP[0], (float) positionLightP[1], (float) positionLightP[2], 1);
-        glUniform3f(uLightPos_vs, LightPos.x, LightPos.y, LightPos.z);
-        glm::vec4 LightDir = ViewMatrix * glm::vec4((float) positionLightD[0], (float) positionLightD[1], (float) positionLightD[2], 1);
-        glUniform3f(uLightDir_vs, LightDir.x, LightDir.y, LightDir.z);
+        FrameData frame;
+        frame.view = ViewMatrix;
+        frame.projection = ProjectionMatrix;
+        frame.viewProjection = ProjectionMatrix * ViewMatrix;
+        // The coordinates point towards the directional light, which travels the opposite way
+        glm::vec3 lightDirection = -glm::vec3((float) positionLightD[0], (float) positionLightD[1], (float) positionLightD[2]);
+        if(lightDirection == glm::vec3(0.0f)){
+            lightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+        }
+        frame.lightDirection_vs = ViewMatrix * glm::vec4(lightDirection, 0);
+        frame.shadowSplits = glm::vec4(0.0);
         
         // On/Off lights
         /*if (item_LightD == 0){
@@ -769,19 +786,21 @@ int main(int argc, char** argv) {
             tmpIntensityP = lightIntensity[1];
             lightIntensity[1] = 0;
         }*/
-        glUniform3f(uLightIntensityD, lightIntensity[0], lightIntensity[0], lightIntensity[0]);   
-        glUniform3f(uLightIntensityP, lightIntensity[1], lightIntensity[1], lightIntensity[1]);   
+        frame.lightIntensityD = glm::vec4(glm::vec3(lightIntensity[0]), 0.0);
+        sceneLights[0] = PointLight(glm::vec3(positionLightP[0], positionLightP[1], positionLightP[2]), glm::vec3(1.0f), (float) lightIntensity[1], 16.0f);
+        lightClusters.update(sceneLights, ViewMatrix, ProjectionMatrix);
+        lightClusters.fillFrameData(frame);
+        lightClusters.bind();
+        frameUniforms.update(&frame);
 
 
         // Cursor move
         cursor.setTrans(cursorPosition[0], cursorPosition[1], cursorPosition[2]);
 
-        // Reset MVP
+        // Reset model matrix
         glm::mat4 ModelMatrix = glm::mat4(1.0f);
-        glm::mat4 NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrix));
-        glUniformMatrix4fv(uMVPMatrix, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix * ViewMatrix * ModelMatrix)); //Model View Projection
-        glUniformMatrix4fv(uMVMatrix, 1, GL_FALSE, glm::value_ptr(ViewMatrix * ModelMatrix));
-        glUniformMatrix4fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+        glUniformMatrix4fv(uModelMatrix, 1, GL_FALSE, glm::value_ptr(ModelMatrix));
+        glUniformMatrix3fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(glm::mat3(ViewMatrix * ModelMatrix)))));
         
         // Enable depth test
         glEnable(GL_DEPTH_TEST);
@@ -800,9 +819,7 @@ int main(int argc, char** argv) {
         /*ModelMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(0.0f,0.0f,0.0f));
         ModelMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(0.0f,0.0f,0.0f));
         ModelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f,0.0f,0.0f));
-        glUniformMatrix4fv(uMVPMatrix, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix * ViewMatrix * ModelMatrix)); //Model View Projection
-        glUniformMatrix4fv(uMVMatrix, 1, GL_FALSE, glm::value_ptr(ViewMatrix * ModelMatrix)); //Model View Projection
-        glUniformMatrix4fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(NormalMatrix)); //Model View Projection*/
+        glUniformMatrix4fv(uModelMatrix, 1, GL_FALSE, glm::value_ptr(ModelMatrix));*/
 
         // Reset variables
         currentActive = -1;
@@ -840,10 +857,9 @@ int main(int argc, char** argv) {
             ModelMatrix = glm::scale(glm::mat4(1.0f), myCubeList.getScale(myCubeList.getCubeIndex(i)));
             ModelMatrix = glm::rotate(ModelMatrix, myCubeList.getRotDeg(myCubeList.getCubeIndex(i)), myCubeList.getRot(myCubeList.getCubeIndex(i)));
             ModelMatrix = glm::translate(ModelMatrix, myCubeList.getTrans(myCubeList.getCubeIndex(i)));
-            // Reset ModelViewProjection matrices
-            glUniformMatrix4fv(uMVPMatrix, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix * ViewMatrix * ModelMatrix)); //Model View Projection
-            glUniformMatrix4fv(uMVMatrix, 1, GL_FALSE, glm::value_ptr( ViewMatrix * ModelMatrix)); //Model View Projection
-            glUniformMatrix4fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(ViewMatrix * ModelMatrix)))); //Model View Projection
+            // Only the model matrix changes per cube, view and projection are in the frame block
+            glUniformMatrix4fv(uModelMatrix, 1, GL_FALSE, glm::value_ptr(ModelMatrix));
+            glUniformMatrix3fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(glm::mat3(ViewMatrix * ModelMatrix)))));
 
             // Draw cube
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *myCubeList.getIBOListItem(myCubeList.getCubeIndex(i)+1));
@@ -863,7 +879,8 @@ int main(int argc, char** argv) {
         ModelMatrix = glm::rotate(ModelMatrix, cursor.getRotDeg(), cursor.getRot());
         ModelMatrix = glm::translate(ModelMatrix, cursor.getTrans());
         
-        glUniformMatrix4fv(uMVPMatrix, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix * ViewMatrix * ModelMatrix)); //Model View Projection
+        glUniformMatrix4fv(uModelMatrix, 1, GL_FALSE, glm::value_ptr(ModelMatrix));
+        glUniformMatrix3fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(glm::mat3(ViewMatrix * ModelMatrix)))));
 
         // Draw cursor
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *myCubeList.getIBOListItem(0));
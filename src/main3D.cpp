@@ -45,14 +45,22 @@
 #include <fstream>
 #include <string>
 #include <glimac/Program.hpp>
+#include <glimac/ProgramCache.hpp>
 #include <glimac/FilePath.hpp>
 #include <glimac/glm.hpp>
 #include <glimac/Image.hpp>
 #include <glimac/Cube.hpp>
 #include <glimac/Texture.hpp>
+#include <glimac/ThreadPool.hpp>
 #include <glimac/CubeList.hpp>
+#include <glimac/UniformBuffer.hpp>
+#include <glimac/LightClusters.hpp>
+#include <glimac/ShadowCascades.hpp>
+#include <glimac/ChunkRenderer.hpp>
 #include <glimac/Controls.hpp>
 #include <glimac/objloader.hpp>
+#include <glimac/PropList.hpp>
+#include <glimac/SceneThread.hpp>
 #include <glimac/text.hpp>
 #include <cstddef>
 #include <vector>
@@ -101,26 +109,11 @@ int main(int argc, char** argv) {
     std::cout << "OpenGL Version : " << glGetString(GL_VERSION) << std::endl;
     std::cout << "GLEW Version : " << glewGetString(GLEW_VERSION) << std::endl;
 
-    /** INITIALIZE SCENE **/    
-    // Add 3 cubes
-    CubeList myCubeList;
-    myCubeList.addCube(Cube());
-    myCubeList.addCube(Cube());
-    myCubeList.addCube(Cube());
-
-    // Translate cubes
-    myCubeList.setTrans(0, 0,0,0);
-    myCubeList.setTrans(1, -1,0,0);
-    myCubeList.setTrans(2, 1,0,0);
-
-    // Link cubes with textures
-    myCubeList.setTextureIndex(0, 1);
-    myCubeList.setTextureIndex(1, 1);
-    myCubeList.setTextureIndex(2, 1);
-
-    // Initialize cursor (a very special cube)
+    /** INITIALIZE SCENE **/
+    // The cubes belong to the scene thread (first 3 cubes added once it runs)
+    // Initialize cursor (a very special cube) on the first cube
     Cube cursor;
-    cursor.setTrans(myCubeList.getTrans(0).x,myCubeList.getTrans(0).y,myCubeList.getTrans(0).z);
+    cursor.setTrans(0,0,0);
     cursor.setTextureIndex(0);
 
 
@@ -173,166 +166,175 @@ int main(int argc, char** argv) {
     // Setup Dear ImGui style
     ImGui::StyleColorsDark();
 
+    /** DECODING TEXTURES **/
+    // Worker threads read the baked textures (or bake them on the first launch), while the shaders compile.
+    // They only serve the startup loading : the pool is destroyed before the meshing threads start
+    std::unique_ptr<ThreadPool> threadPool(new ThreadPool());
+    const bool compressTextures = GLEW_EXT_texture_compression_s3tc;
+    const char* texturePaths[] = {
+        "../../World_Imaker/assets/textures/rouge.png",
+        "../../World_Imaker/assets/textures/bois.png",
+        "../../World_Imaker/assets/textures/brique.png",
+        "../../World_Imaker/assets/textures/cailloux.png",
+        "../../World_Imaker/assets/textures/eau.png",
+        "../../World_Imaker/assets/textures/goudron.png",
+        "../../World_Imaker/assets/textures/herbe.png",
+        "../../World_Imaker/assets/textures/marbre.png",
+        "../../World_Imaker/assets/textures/mosaique.png",
+        "../../World_Imaker/assets/textures/sol_metalique.png"
+    };
+    std::vector<std::future<std::unique_ptr<BakedTexture> > > decodedTextures;
+    for(uint i = 0; i<IM_ARRAYSIZE(texturePaths); i++){
+        decodedTextures.push_back(loadBakedTextureAsync(*threadPool, texturePaths[i], compressTextures));
+    }
+
      /** LOADING SHADERS **/
     FilePath applicationPath(argv[0]);
-    Program program = loadProgram(
+    // Linked programs are kept next to their sources, compiled again only when a shader changes
+    ProgramCache programCache(applicationPath.dirPath() + "shaders");
+    Program program = programCache.load(
         applicationPath.dirPath() + "shaders/vertex.vs.glsl",
         applicationPath.dirPath() + "shaders/fragment.fs.glsl"
     );
+    // Depth only program of the shadow cascades
+    Program shadowProgram = programCache.load(
+        applicationPath.dirPath() + "shaders/shadow.vs.glsl",
+        applicationPath.dirPath() + "shaders/shadow.fs.glsl"
+    );
+    GLint uLightViewProjection = shadowProgram.getUniformLocation("uLightViewProjection");
+    std::cout << "Shader programs : " << programCache.getHitCount() << " from cache, " << programCache.getMissCount() << " compiled" << std::endl;
     program.use();
 
     // Get uniform variable ID
-    GLint uMVPMatrix = glGetUniformLocation(program.getGLId(), "uMVPMatrix");
-    GLint uMVMatrix = glGetUniformLocation(program.getGLId(), "uMVMatrix");
-    GLint uNormalMatrix = glGetUniformLocation(program.getGLId(), "uNormalMatrix");
-    
-    //Get uniform variables for light
-    GLint uKd = glGetUniformLocation(program.getGLId(), "uKd");
-    GLint uKs = glGetUniformLocation(program.getGLId(), "uKs");
-    GLint uShininess = glGetUniformLocation(program.getGLId(), "uShininess");
-    GLint uLightPos_vs = glGetUniformLocation(program.getGLId(), "uLightPos_vs");
-    GLint uLightDir_vs = glGetUniformLocation(program.getGLId(), "uLightDir_vs");
-    GLint uLightIntensityP = glGetUniformLocation(program.getGLId(), "uLightIntensityP");
-    GLint uLightIntensityD = glGetUniformLocation(program.getGLId(), "uLightIntensityD");
+    GLint uModelMatrix = program.getUniformLocation("uModelMatrix");
+    GLint uNormalMatrix = program.getUniformLocation("uNormalMatrix");
+    GLint uPackedVertices = program.getUniformLocation("uPackedVertices");
+    GLint uInstanced = program.getUniformLocation("uInstanced");
+
+    // Camera and lights are sent once per frame, the material once : shared by every program through their uniform blocks
+    UniformBuffer frameUniforms(UniformBuffer::FRAME_DATA_BINDING, sizeof(FrameData));
+    UniformBuffer materialUniforms(UniformBuffer::MATERIAL_DATA_BINDING, sizeof(MaterialData));
+    MaterialData material;
+    material.diffuse = glm::vec4(0.6, 0.6, 0.6, 0.0);
+    material.specular = glm::vec4(0.0, 0.0, 0.0, 32.0);
+    materialUniforms.update(&material);
+    // Point lights are binned per cluster each frame and read from texture buffers (units 1 to 3)
+    LightClusters lightClusters;
+    LightClusters::bindSamplers(program.getGLId());
+    // Directional light shadows (texture unit 4), cached between frames
+    ShadowCascades shadowCascades;
+    ShadowCascades::bindSamplers(program.getGLId());
     
     /** INITIALIZE TEXTURES **/
-    uint nbOfTextures = 10;
+    uint nbOfTextures = decodedTextures.size();
     std::vector<Texture> textures(nbOfTextures);
 
     for(int i=0; i<textures.size(); i++){
-        char const *pchar = "uTexture" + i;
-        textures[i].setUniformLocation(program, (GLchar*)pchar);
+        // Every texture is sampled through uTextureSampler, on unit 0
+        textures[i].setUniformLocation(program, "uTextureSampler");
     }
 
-    // Loading textures
-    textures[0].setImage("../../World_Imaker/assets/textures/rouge.png");
-    textures[1].setImage("../../World_Imaker/assets/textures/bois.png");
-    textures[2].setImage("../../World_Imaker/assets/textures/brique.png");
-    textures[3].setImage("../../World_Imaker/assets/textures/cailloux.png");
-    textures[4].setImage("../../World_Imaker/assets/textures/eau.png");
-    textures[5].setImage("../../World_Imaker/assets/textures/goudron.png");
-    textures[6].setImage("../../World_Imaker/assets/textures/herbe.png");
-    textures[7].setImage("../../World_Imaker/assets/textures/marbre.png");
-    textures[8].setImage("../../World_Imaker/assets/textures/mosaique.png");
-    textures[9].setImage("../../World_Imaker/assets/textures/sol_metalique.png");
-
-    // Textures
+    // Textures : each image is uploaded once its worker thread is done
     for(uint i = 0; i<textures.size(); i++){
-        glGenTextures(1,textures[i].getTexturePointer());
-        glBindTexture(GL_TEXTURE_2D,textures[i].getTexture());   // Texture binding
-        glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,textures[i].getImageWidth(),textures[i].getImageHeight(),0,GL_RGBA,GL_FLOAT,textures[i].getImagePixels());
-
-        //Filters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        textures[i].upload(decodedTextures[i].get());
     }
 
     /** INITIALIZE VBOs **/
-    // For the cursor
+    // For the cursor (the cubes are drawn from the chunk meshes)
     // Generate one buffer, put the resulting identifier in vertexbuffer
-    glGenBuffers(1, myCubeList.getVBOListItem(0));
+    GLuint cursorVBO, cursorVAO, cursorIBO;
+    glGenBuffers(1, &cursorVBO);
     // Bind buffer
-    glBindBuffer(GL_ARRAY_BUFFER, *myCubeList.getVBOListItem(0));
+    glBindBuffer(GL_ARRAY_BUFFER, cursorVBO);
     // Send data to CG
     glBufferData(GL_ARRAY_BUFFER, cursor.getVertexCount()*sizeof(Vertex3DTexture), cursor.getDataPointer(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, *myCubeList.getVBOListItem(0));
-
-    // Repeat for all cubes of the scene (i+1 because the cursor is 0)
-    myCubeList.generateVBO();
 
     /** INITIALIZE VAOs **/
+    const GLuint VERTEX_ATTR_POSITION = 0;
+    const GLuint VERTEX_ATTR_NORMAL = 1;
+    const GLuint VERTEX_ATTR_TEXTURE = 2;
     // Generate a VAO
-    glGenVertexArrays(1, myCubeList.getVAOListItem(0));
+    glGenVertexArrays(1, &cursorVAO);
     // VAO Binding
-    glBindVertexArray(*myCubeList.getVAOListItem(0));
-    glBindBuffer(GL_ARRAY_BUFFER, *myCubeList.getVAOListItem(0));
+    glBindVertexArray(cursorVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cursorVBO);
     // 1st attribute buffer : position
-    glEnableVertexAttribArray(myCubeList.getVBOPositionAttribute());
-    glVertexAttribPointer(myCubeList.getVBOPositionAttribute(),3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, position));
+    glEnableVertexAttribArray(VERTEX_ATTR_POSITION);
+    glVertexAttribPointer(VERTEX_ATTR_POSITION,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, position));
     // 2nd attribute buffer : normal
-    glEnableVertexAttribArray(myCubeList.getVBONormalAttribute());
-    glVertexAttribPointer(myCubeList.getVBONormalAttribute(),3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, normal));
+    glEnableVertexAttribArray(VERTEX_ATTR_NORMAL);
+    glVertexAttribPointer(VERTEX_ATTR_NORMAL,3,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, normal));
     // 3rd attribute buffer : texture
-    glEnableVertexAttribArray(myCubeList.getVBOTextureAttribute());
-    glVertexAttribPointer(myCubeList.getVBOTextureAttribute(),2,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, texture));
-
-    //Repeat for all cubes of the scene (i+1 because the cursor is 0)
-    myCubeList.generateVAO();
+    glEnableVertexAttribArray(VERTEX_ATTR_TEXTURE);
+    glVertexAttribPointer(VERTEX_ATTR_TEXTURE,2,GL_FLOAT, GL_FALSE, sizeof(Vertex3DTexture), (const GLvoid*)offsetof(Vertex3DTexture, texture));
 
     /** INITIALIZE IBOs **/
     // Generate buffer
-    glGenBuffers(1, myCubeList.getIBOListItem(0));
+    glGenBuffers(1, &cursorIBO);
     // Bind IBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *myCubeList.getIBOListItem(0));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cursorIBO);
     // Send data
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, cursor.getIBOCountBorder()*sizeof(uint32_t), cursor.getIBOPointerBorder(), GL_STATIC_DRAW);
 
-    //Repeat for all cubes of the scene (i+1 because the cursor is 0)
-    myCubeList.generateIBO();
-
     // Stop binding
     glBindVertexArray(0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-    /** SORT CUBES BY TEXTURE **/
-    myCubeList.printCubes();
-    myCubeList.sortCubes();
-    myCubeList.printCubes();
-
-    // Create and compile our GLSL program from the shaders
-	//GLuint programID = LoadShaders( "StandardShading.vertexshader", "StandardShading.fragmentshader" );
-
-	// Get a handle for our "MVP" uniform
-	GLuint MatrixID = glGetUniformLocation(program.getGLId(), "MVP");
-	GLuint ViewMatrixID = glGetUniformLocation(program.getGLId(), "V");
-	GLuint ModelMatrixID = glGetUniformLocation(program.getGLId(), "M");
-
-	// Load the texture
-	GLuint Texture = loadDDS("../assets/models/uvmap.DDS");
-
-	// Get a handle for our "myTextureSampler" uniform
-	GLuint TextureID  = glGetUniformLocation(program.getGLId(), "myTextureSampler");
-
-	// Read our .obj file
-	std::vector<glm::vec3> vertices;
-	std::vector<glm::vec2> uvs;
-	std::vector<glm::vec3> normals;
-	bool res = loadOBJ("../assets/models/suzanne.obj", vertices, uvs, normals);
-
-	// Load it into a VBO
-
-	GLuint vertexbuffer;
-	glGenBuffers(1, &vertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), &vertices[0], GL_STATIC_DRAW);
-
-	GLuint uvbuffer;
-	glGenBuffers(1, &uvbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-	glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), &uvs[0], GL_STATIC_DRAW);
-
-	GLuint normalbuffer;
-	glGenBuffers(1, &normalbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), &normals[0], GL_STATIC_DRAW);
+    /** PROPS **/
+    // Imported models, from their binary cache (parsed on the worker threads on first launch)
+    const char* itemsModels[] = { "Suzanne" };
+    const char* modelPaths[] = { "../assets/models/suzanne.obj" };
+    const char* modelTextures[] = { "../assets/models/uvmap.DDS" };
+    PropList propList;
+    std::vector<GLuint> propTextures;
+    for(int i=0; i<IM_ARRAYSIZE(modelPaths); i++){
+        // Invert V coordinate since we only use DDS textures, which are inverted
+        std::unique_ptr<BakedMesh> mesh = BakedMesh::load(modelPaths[i], true, threadPool.get());
+        if(!mesh){
+            std::cerr << "[ERROR] Unable to load the model " << modelPaths[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "Model " << itemsModels[i] << " : " << mesh->getVertexCount() << " vertices, " << mesh->getIndexCount()/3 << " triangles"
+            << (mesh->isFromCache() ? " (cache)" : " (imported)") << std::endl;
+        propTextures.push_back(loadDDS(modelTextures[i]));
+        propList.addMesh(std::move(mesh), propTextures.back());
+    }
+    propList.addProp(Prop(0));
+    // Textures and models are loaded : their threads would only sleep next to the JobSystem's
+    threadPool.reset();
 
     /** INITIALIZE LOOP **/
     bool done = false; // is looping
 
     int currentActive = -1; // current selected cube
 
-    int item_LightP = 0;
-    int item_LightD = 0; // Lights on/off
+    // Light settings, saved with the scene
+    SceneLights lightSettings;
+    int& item_LightP = lightSettings.item_LightP;
+    int& item_LightD = lightSettings.item_LightD; // Lights on/off
+    int item_glowTexture = 0; // Texture edited in the voxel light menu
+    bool sparseStorage = false; // Voxel storage of the scene thread
+
+    const char* itemsTextures[] = { "Bois", "Brique", "Cailloux", "Eau", "Goudron", "Herbe", "Marbre", "Mosaique", "Sol metalique"};
+    std::vector<int> glowLevels(IM_ARRAYSIZE(itemsTextures), 0); // Light emitted by each texture of the menu
 
     // Cursor position
     std::vector<int> cursorPosition{1,1,1};
 
     // Directive light position
-    std::vector<int> positionLightD{1,1,1};
-    std::vector<int> lightIntensity{2,2};
+    std::vector<int>& positionLightD = lightSettings.positionLightD;
 
     // Spotlight position
-    std::vector<int> positionLightP{1,1,1};
+    std::vector<int>& positionLightP = lightSettings.positionLightP;
+
+    // Placed point lights (torches), sent with the spotlight to the light clusters
+    std::vector<PointLight> torches;
+    std::vector<PointLight> sceneLights;
+    int selectedTorch = -1;
+
+    // Props : selected one and model of the next one
+    int selectedProp = -1;
+    int item_propModel = 0;
 
     // Extrude/Dig state
     bool thereIsACubeAbove, thereIsACubeUnder = false;
@@ -343,10 +345,29 @@ int main(int argc, char** argv) {
     std::string rbf = "default";
     float epsilon = 1.0;
 
+    // Chunk meshes (built from the voxel storage, with baked ambient occlusion)
+    ChunkRenderer chunkRenderer;
+    // Dirty chunks are meshed on every core by the scene thread, this thread only uploads them
+    JobSystem jobSystem;
+    // The scene thread owns the cubes : edits, loading, saving and generation are sent to it in order,
+    // the render thread only reads the frames it publishes (meshes, loaded lights and props, cursor state)
+    SceneThread sceneThread(&jobSystem);
+    SceneStatus sceneStatus;
+    const ChunkMeshUpdates noMeshUpdate;
+    // Add 3 cubes
+    sceneThread.addCube(glm::ivec3(0,0,0), 1);
+    sceneThread.addCube(glm::ivec3(-1,0,0), 1);
+    sceneThread.addCube(glm::ivec3(1,0,0), 1);
+    // Software depth buffer used to skip the chunks hidden behind terrain
+    OcclusionCuller occlusionCuller;
+
     // Camera initialisation
     Controls c;
-    c.calculateVectors();
-    c.computeFinalMatrices();
+    // Projection ratio of the whole window (the menus are drawn over it)
+    const glm::ivec2 windowSize = windowManager.getWindowSize();
+    c.setAspectRatio((float)windowSize.x / windowSize.y);
+    // Time of the previous frame, for the continuous camera movement
+    float lastFrameTime = windowManager.getTime();
 
     // Initialize control points matrix for RBF
     Eigen::MatrixXd controlPoints(0,3);
@@ -370,11 +391,17 @@ int main(int argc, char** argv) {
             ImGui_ImplSDL2_ProcessEvent(&e);           
 
             if(e.type == SDL_QUIT){
-                myCubeList.save("../backup/backup.txt", item_LightD, positionLightD, item_LightP, positionLightP, lightIntensity);
+                // Written before the scene thread stops
+                sceneThread.save("../backup/backup.txt", lightSettings, propList);
                 done = true;
             }
 
-            c.calculateVectors();   // Calculate the new vectors of the camera
+            if(e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED){
+                // Drawing, projection and picking all follow the window
+                glViewport(0, 0, e.window.data1, e.window.data2);
+                c.setAspectRatio((float)e.window.data1 / e.window.data2);
+            }
+
             if(e.type == SDL_KEYDOWN){
                 if(!ImGui::IsAnyItemActive()){ // Avoid keyboard events when an input is focused
                     // Move the cursor
@@ -397,45 +424,7 @@ int main(int argc, char** argv) {
                         cursor.setTrans(cursor.getTrans().x, cursor.getTrans().y, cursor.getTrans().z + 1);
                     }
 
-                    // Move the camera
-                    if (e.key.keysym.sym == SDLK_KP_8){
-                        glm::vec3 newPos = c.getPosition() + (c.getUp() * c.getSpeed());
-                        c.setPosition(newPos);
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_2){
-                        glm::vec3 newPos = c.getPosition() - (c.getUp() * c.getSpeed());
-                        c.setPosition(newPos);
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_6){
-                        glm::vec3 newPos = c.getPosition() + (c.getRight() * c.getSpeed());
-                        c.setPosition(newPos);
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_4){
-                        glm::vec3 newPos = c.getPosition() - (c.getRight() * c.getSpeed());
-                        c.setPosition(newPos);
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_PLUS){
-                        glm::vec3 newPos = c.getPosition() + (c.getDirection() * c.getSpeed());
-                        c.setPosition(newPos);
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_MINUS){
-                        glm::vec3 newPos = c.getPosition() - (c.getDirection() * c.getSpeed());
-                        c.setPosition(newPos);
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_9){
-                        c.calculateVectors();
-                        c.setHorizontalAngle(c.getHorizontalAngle() + c.getSpeed());
-                        c.computeFinalMatrices();
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_7){
-                        c.setHorizontalAngle(c.getHorizontalAngle() - c.getSpeed());
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_3){
-                        c.setVerticalAngle(c.getVerticalAngle() + c.getSpeed());
-                    }
-                    if (e.key.keysym.sym == SDLK_KP_1){
-                        c.setVerticalAngle(c.getVerticalAngle() - c.getSpeed());
-                    }
+                    // Reset the camera (moved with the keypad below, each frame)
                     if (e.key.keysym.sym == SDLK_KP_5){
                         c.setPosition(glm::vec3(0,0,5));
                         c.setHorizontalAngle(3.14f);
@@ -444,8 +433,68 @@ int main(int argc, char** argv) {
                 }
                 
             }
-            c.computeFinalMatrices();   // Calculate the new matrix for the camera
+
+            // Mouse picking : left click selects the cube (or prop) under the mouse, right click the free cell in front of the hit face
+            if(e.type == SDL_MOUSEBUTTONDOWN && !io.WantCaptureMouse){
+                glm::vec3 rayOrigin, rayDirection;
+                // Same window size as the projection ratio
+                const glm::ivec2 viewportSize = windowManager.getWindowSize();
+                c.getRay(windowManager.getMousePosition(), glm::vec4(0.0f, 0.0f, viewportSize.x, viewportSize.y), rayOrigin, rayDirection);
+                // Props through their BVH here, the voxels on the scene thread : the nearest hit moves the cursor
+                PropRayHit propHit;
+                const bool propFound = propList.raycast(rayOrigin, rayDirection, 100.0f, propHit);
+                sceneThread.pick(rayOrigin, rayDirection, e.button.button == SDL_BUTTON_RIGHT, propFound ? &propHit : nullptr);
+            }
         }
+
+        // Camera : held keypad keys move it at a constant speed whatever the frame rate
+        const float frameTime = windowManager.getTime();
+        const float deltaTime = glm::min(frameTime - lastFrameTime, 0.1f); // no jump after a long frame
+        lastFrameTime = frameTime;
+        if(!ImGui::IsAnyItemActive()){
+            glm::vec3 cameraMove(
+                (float)windowManager.isKeyPressed(SDLK_KP_6) - (float)windowManager.isKeyPressed(SDLK_KP_4),
+                (float)windowManager.isKeyPressed(SDLK_KP_8) - (float)windowManager.isKeyPressed(SDLK_KP_2),
+                (float)windowManager.isKeyPressed(SDLK_KP_PLUS) - (float)windowManager.isKeyPressed(SDLK_KP_MINUS));
+            c.move(cameraMove, deltaTime);
+            c.turn((float)windowManager.isKeyPressed(SDLK_KP_9) - (float)windowManager.isKeyPressed(SDLK_KP_7),
+                   (float)windowManager.isKeyPressed(SDLK_KP_3) - (float)windowManager.isKeyPressed(SDLK_KP_1), deltaTime);
+        }
+
+        // Last frame published by the scene thread : scenes read or generated replace the lights and props
+        std::shared_ptr<const SceneFrame> sceneFrame = sceneThread.takeFrame();
+        if(sceneFrame){
+            for(size_t i=0; i<sceneFrame->scenes.size(); i++){
+                const SceneSnapshot& scene = *sceneFrame->scenes[i];
+                if(scene.hasLights){
+                    lightSettings = scene.lights;
+                }
+                if(scene.hasProps){
+                    propList.clear();
+                    selectedProp = -1;
+                    for(size_t j=0; j<scene.props.size(); j++){
+                        if(propList.addProp(scene.props[j]) < 0){
+                            std::cerr << "[WARNING] Unknown mesh " << scene.props[j].meshId << ", prop skipped" << std::endl;
+                        }
+                    }
+                }
+            }
+            if(sceneFrame->picked && sceneFrame->pick.found){
+                cursor.setTrans(sceneFrame->pick.cell.x, sceneFrame->pick.cell.y, sceneFrame->pick.cell.z);
+                if(sceneFrame->pick.prop != -1){
+                    selectedProp = sceneFrame->pick.prop;
+                }
+            }
+            sceneStatus = sceneFrame->status;
+        }
+        sceneThread.setView(c.getPosition(), glm::ivec3(cursor.getTrans()));
+
+        // Cube under the cursor and its neighbours, unknown until the scene thread describes this cell
+        const glm::ivec3 selectedCell = glm::ivec3(cursor.getTrans());
+        const bool statusOnCursor = sceneStatus.cursor == selectedCell;
+        currentActive = statusOnCursor ? sceneStatus.cursorCube : -1;
+        thereIsACubeAbove = statusOnCursor && sceneStatus.cubeAbove;
+        thereIsACubeUnder = statusOnCursor && sceneStatus.cubeUnder;
                     
         // Feed inputs to Dear ImGui, start new frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -507,6 +556,7 @@ int main(int argc, char** argv) {
         ImGui::InputInt("yD", &positionLightD[1]);
         ImGui::Text("Z :");
         ImGui::InputInt("zD", &positionLightD[2]);
+        ImGui::Text("Shadow cascades rendered : %d / %d", shadowCascades.getRenderedCount(), ShadowCascades::CASCADE_COUNT);
 
         // Spotlight
         ImGui::Text("Lumiere ponctuelle :");
@@ -518,6 +568,35 @@ int main(int argc, char** argv) {
         ImGui::Text("Z :");
         ImGui::InputInt("zP", &positionLightP[2]);
 
+        // Torches
+        ImGui::Text("Torches :");
+        if(ImGui::Button("Add torch at cursor") && torches.size() + 1 < (size_t)LightClusters::MAX_LIGHTS){
+            torches.push_back(PointLight(glm::vec3(cursorPosition[0], cursorPosition[1], cursorPosition[2]), glm::vec3(1.0f, 0.7f, 0.4f), 3.0f, 8.0f));
+            selectedTorch = torches.size()-1;
+        }
+        if(!torches.empty()){
+            ImGui::SliderInt("Torch", &selectedTorch, 0, torches.size()-1);
+            selectedTorch = glm::clamp(selectedTorch, 0, (int)torches.size()-1);
+            PointLight& torch = torches[selectedTorch];
+            ImGui::InputFloat3("Position", glm::value_ptr(torch.position));
+            ImGui::ColorEdit3("Color", glm::value_ptr(torch.color));
+            ImGui::SliderFloat("Intensity", &torch.intensity, 0.0f, 20.0f);
+            ImGui::SliderFloat("Radius", &torch.radius, 1.0f, 32.0f);
+            if(ImGui::Button("Remove torch")){
+                torches.erase(torches.begin() + selectedTorch);
+                selectedTorch = torches.empty() ? -1 : glm::min(selectedTorch, (int)torches.size()-1);
+            }
+        }
+        ImGui::Text("Point lights : %u (%u cluster references)", (uint)lightClusters.getLightCount(), (uint)lightClusters.getIndexCount());
+
+        // Voxel light : sky and glowing textures, flood-filled through empty voxels
+        ImGui::Text("Lumiere des voxels :");
+        ImGui::Combo("Glowing texture", &item_glowTexture, itemsTextures, IM_ARRAYSIZE(itemsTextures));
+        if(ImGui::SliderInt("Glow", &glowLevels[item_glowTexture], 0, VoxelLight::MAX_LEVEL)){
+            sceneThread.setEmission(item_glowTexture+1, glowLevels[item_glowTexture]);
+        }
+        ImGui::Text("Light storage : %u KB", (uint)(sceneStatus.lightMemory/1024));
+
         ImGui::End();
 
         // File menu
@@ -537,31 +616,19 @@ int main(int argc, char** argv) {
         ImGui::Text("Save file :");
         ImGui::InputText("Save Path", &filePath);
         if(ImGui::Button("Save")){
-            myCubeList.save(filePath, item_LightD, positionLightD, item_LightP, positionLightP, lightIntensity);
+            sceneThread.save(filePath, lightSettings, propList);
         }
 
         // Load
         ImGui::Text("Load file :");
         ImGui::InputText("Load Path", &loadFilePath);
         if(ImGui::Button("Load")){
-
-            // Read file to load
-            std::vector<int> file;
-            myCubeList.read(loadFilePath, file);
-            
-            // Save current file
-            myCubeList.save("../backup/backup.txt", item_LightD, positionLightD, item_LightP, positionLightP, lightIntensity);
-
-            // Reset cube list
-            std::cout << "Deleting ..." << myCubeList.getSize() << "...cubes" << std::endl;
-            while(myCubeList.getSize()){
-                int i = 0;
-                myCubeList.deleteCube(i);
-                currentActive = -1;
-            }
-            
-            // Load file
-            myCubeList.load(file, cursorPosition, currentActive, item_LightD, positionLightD, item_LightP, positionLightP, lightIntensity);
+            // Save current file, then read the new one (edits made meanwhile apply to the new scene)
+            sceneThread.save("../backup/backup.txt", lightSettings, propList);
+            sceneThread.load(loadFilePath);
+        }
+        if(sceneThread.isBusy()){
+            ImGui::Text("Scene thread working...");
         }
 
         ImGui::End();
@@ -641,49 +708,26 @@ int main(int argc, char** argv) {
 
         // Generate
         if(ImGui::Button("Generate scene")){
-            // Save current file
-            myCubeList.save("../backup/backup.txt", item_LightD, positionLightD, item_LightP, positionLightP, lightIntensity);
-
-            // Reset cube list
-            std::cout << "Deleting ..." << myCubeList.getSize() << "...cubes" << std::endl;
-            while(myCubeList.getSize()){
-                int i = 0;
-                myCubeList.deleteCube(i);
-                currentActive = -1;
-            }
-            
-            // Generate scene
-            if(controlPoints.rows()>0){
-                double lowerX, higherX = controlPoints(0,0);
-                double lowerZ, higherZ = controlPoints(0,2);
-
-                for(int i=1; i<controlPoints.rows(); i++){
-                    if(controlPoints(i,0)<lowerX){
-                        lowerX=controlPoints(i,0);
-                    }else if(controlPoints(i,0)>higherX){
-                        higherX=controlPoints(i,0);
-                    }else if(controlPoints(i,2)>higherZ){
-                        higherZ=controlPoints(i,2);
-                    }else if(controlPoints(i,2)<lowerZ){
-                        lowerZ=controlPoints(i,2);
-                    }
-                }
-                for(int i=lowerX;i<=higherX;i++){
-                    for(int j=lowerZ; j<=higherZ; j++){
-                        int y = myCubeList.interpolatePoints(i,j, controlPoints, rbf, epsilon);
-                        if(y>-15){
-                            myCubeList.addCube(Cube());
-                            myCubeList.setTrans(myCubeList.getSize()-1, i,y,j);
-                            if(i==controlPoints(0,0) && y==controlPoints(0,1)&&j==controlPoints(0,2)){
-                                myCubeList.setTextureIndex(myCubeList.getSize()-1, 2);
-                            }
-                            myCubeList.setTextureIndex(myCubeList.getSize()-1, 1);
-                        }
-                    }
-                }
+            // Save current file, then generate the new scene (the weights are solved once on the scene thread)
+            sceneThread.save("../backup/backup.txt", lightSettings, propList);
+            sceneThread.generate(controlPoints, rbf, epsilon);
+        }
+
+        // Voxel storage (sparse octree for large and mostly empty scenes)
+        if(ImGui::Checkbox("Sparse octree", &sparseStorage)){
+            sceneThread.setSparseStorage(sparseStorage);
+        }
+        ImGui::Text("Voxel memory : %u Ko (%u cubes)", (uint)(sceneStatus.storageMemory/1024), (uint)sceneStatus.cubeCount);
+        ImGui::Text("Chunks drawn : %u / %u", (uint)chunkRenderer.getVisibleChunkCount(), (uint)chunkRenderer.getChunkCount());
+        ImGui::Text("Meshing threads : %u (%u jobs stolen)", (uint)jobSystem.getWorkerCount() + 1, (uint)jobSystem.getStealCount());
+        // Multi-draw indirect (OpenGL 4.3), otherwise one draw call per chunk and material
+        if(chunkRenderer.isMultiDrawSupported()){
+            bool multiDraw = chunkRenderer.isMultiDraw();
+            if(ImGui::Checkbox("Multi-draw indirect", &multiDraw)){
+                chunkRenderer.setMultiDraw(multiDraw);
             }
-            
         }
+        ImGui::Text("Draw calls : %u", (uint)chunkRenderer.getDrawCallCount());
 
         ImGui::End();
 
@@ -699,16 +743,14 @@ int main(int argc, char** argv) {
             ImGui::SetWindowPos(ImVec2(windowWidth,80), true);
         }
 
-        // Selected cube
-        int selectedCube = currentActive;
-        ImGui::Text("Selected cube :");
-        ImGui::InputInt("index", &selectedCube);
+        // Selected cube : the first one placed under the cursor
+        const int selectedCube = currentActive;
+        ImGui::Text("Selected cube : %d", selectedCube);
 
         // Texture
-        const char* itemsTextures[] = { "Bois", "Brique", "Cailloux", "Eau", "Goudron", "Herbe", "Marbre", "Mosaique", "Sol metalique"};
-        int item_currentTexture = myCubeList.getTextureIndex(selectedCube)-1;
+        int item_currentTexture = (selectedCube != -1) ? (int)sceneStatus.cursorTexture-1 : 0;
         ImGui::Text("Texture:");
-        ImGui::Combo("Texture", &item_currentTexture, itemsTextures, IM_ARRAYSIZE(itemsTextures));
+        const bool textureChanged = ImGui::Combo("Texture", &item_currentTexture, itemsTextures, IM_ARRAYSIZE(itemsTextures));
         
         // Add/Delete cube
         if(selectedCube == -1){
@@ -721,137 +763,132 @@ int main(int argc, char** argv) {
         ImGui::Text("Modify cube :");
         if(ImGui::Button("Extrude")){
             if(selectedCube!=-1 && !thereIsACubeAbove){
+                sceneThread.extrude(selectedCell, item_currentTexture+1);
                 cursorPosition[1]++;
-                myCubeList.addCube(Cube());
-                myCubeList.setTrans(myCubeList.getSize()-1, cursorPosition[0], cursorPosition[1], cursorPosition[2]);
-                myCubeList.setTextureIndex(myCubeList.getSize()-1, item_currentTexture+1);
-                currentActive = myCubeList.getSize()-1;
             }else{
                 std::cout << "[ERROR] Cannot extrude a non-cube or cube with no space above!" << std::endl;
             }
         };
         if(ImGui::Button("Dig")){
             if(selectedCube!=-1 && thereIsACubeUnder && !thereIsACubeAbove){
-                myCubeList.deleteCube(selectedCube);
+                sceneThread.dig(selectedCell);
                 cursorPosition[1]--;
             }else{
                 std::cout << "[ERROR] Cannot dig a non-cube or cube that is not above a column!" << std::endl;
             }
         };
 
+        // Props
+        ImGui::Text("Props :");
+        ImGui::Combo("Model", &item_propModel, itemsModels, IM_ARRAYSIZE(itemsModels));
+        if(ImGui::Button("Add prop at cursor")){
+            selectedProp = propList.addProp(Prop(item_propModel, glm::vec3(cursorPosition[0], cursorPosition[1], cursorPosition[2])));
+        }
+        if(propList.getSize()){
+            ImGui::SliderInt("Prop", &selectedProp, 0, propList.getSize()-1);
+            selectedProp = glm::clamp(selectedProp, 0, propList.getSize()-1);
+            Prop prop = propList.getProp(selectedProp);
+            bool propChanged = ImGui::Combo("Prop model", &prop.meshId, itemsModels, IM_ARRAYSIZE(itemsModels));
+            propChanged |= ImGui::InputFloat3("Prop position", glm::value_ptr(prop.position));
+            propChanged |= ImGui::SliderFloat("Prop rotation", &prop.rotation, 0.0f, 360.0f);
+            propChanged |= ImGui::SliderFloat("Prop scale", &prop.scale, 0.1f, 10.0f);
+            if(propChanged){
+                propList.setProp(selectedProp, prop);
+            }
+            if(ImGui::Button("Remove prop")){
+                propList.deleteProp(selectedProp);
+                selectedProp = propList.getSize() ? glm::min(selectedProp, propList.getSize()-1) : -1;
+            }
+        }
+        ImGui::Text("Props : %d (%d draw calls)", propList.getSize(), propList.getDrawCallCount());
+        const glm::vec3 cursorCell((float)cursorPosition[0], (float)cursorPosition[1], (float)cursorPosition[2]);
+        const int propAtCursor = propList.findInBox(cursorCell - glm::vec3(0.5f), cursorCell + glm::vec3(0.5f));
+        if(propAtCursor != -1){
+            ImGui::Text("Cursor touches prop %d", propAtCursor);
+        }
+
         ImGui::End();
 
         // Reset texture index (from ImGui)
-        myCubeList.setTextureIndex(selectedCube, item_currentTexture+1);
+        if(textureChanged && selectedCube != -1){
+            sceneThread.setTexture(selectedCell, item_currentTexture+1);
+        }
 
         // Add/Delete cube (from ImGui)
         if(addCube == true){
-            myCubeList.addCube(Cube());
-            myCubeList.setTrans(myCubeList.getSize()-1, cursorPosition[0], cursorPosition[1], cursorPosition[2]);
-            myCubeList.setTextureIndex(myCubeList.getSize()-1, 1);
-            currentActive = myCubeList.getSize()-1;
+            sceneThread.addCube(glm::ivec3(cursorPosition[0], cursorPosition[1], cursorPosition[2]), 1);
         }else if(deleteCube == true){
-            myCubeList.deleteCube(selectedCube);
-            currentActive = -1;
+            sceneThread.deleteCube(selectedCell);
         }
 
         // Rendu lumière
-        glUniform3f(uKd, 0.6, 0.6, 0.6);
-        glUniform3f(uKs, 0, 0.0, 0.0);
-        glUniform1f(uShininess, 32.0);
-        glm::vec4 LightPos = ViewMatrix * glm::vec4((float) positionLightP[0], (float) positionLightP[1], (float) positionLightP[2], 1);
-        glUniform3f(uLightPos_vs, LightPos.x, LightPos.y, LightPos.z);
-        glm::vec4 LightDir = ViewMatrix * glm::vec4((float) positionLightD[0], (float) positionLightD[1], (float) positionLightD[2], 1);
-        glUniform3f(uLightDir_vs, LightDir.x, LightDir.y, LightDir.z);
+        FrameData frame;
+        frame.view = ViewMatrix;
+        frame.projection = ProjectionMatrix;
+        frame.viewProjection = ProjectionMatrix * ViewMatrix;
+        // The coordinates point towards the directional light, which travels the opposite way
+        glm::vec3 lightDirection = -glm::vec3((float) positionLightD[0], (float) positionLightD[1], (float) positionLightD[2]);
+        if(lightDirection == glm::vec3(0.0f)){
+            lightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+        }
+        frame.lightDirection_vs = ViewMatrix * glm::vec4(lightDirection, 0);
+
+        // Chunk meshes first : the shadow cascades only redraw the chunks changed under them
+        chunkRenderer.update(sceneFrame ? sceneFrame->meshes : noMeshUpdate);
+        shadowCascades.update(chunkRenderer, ViewMatrix, ProjectionMatrix, lightDirection);
         
         // On/Off lights
         if (item_LightD == 0){
-            glUniform3f(uLightIntensityD, 2.0, 2.0, 2.0);   
+            frame.lightIntensityD = glm::vec4(2.0, 2.0, 2.0, 0.0);
+            shadowProgram.use();
+            shadowCascades.render(chunkRenderer, uLightViewProjection);
+            program.use();
+            shadowCascades.fillFrameData(frame);
+            shadowCascades.bind();
         }
         else {
-            glUniform3f(uLightIntensityD, 0.0, 0.0, 0.0);
+            frame.lightIntensityD = glm::vec4(0.0);
+            frame.shadowSplits = glm::vec4(0.0);
         }
+        sceneLights.clear();
         if (item_LightP == 0){
-            glUniform3f(uLightIntensityP, 5.0, 5.0, 5.0);   
-        }
-        else {
-            glUniform3f(uLightIntensityP, 0.0, 0.0, 0.0);
+            sceneLights.push_back(PointLight(glm::vec3(positionLightP[0], positionLightP[1], positionLightP[2]), glm::vec3(1.0f), 5.0f, 16.0f));
         }
+        sceneLights.insert(sceneLights.end(), torches.begin(), torches.end());
+        lightClusters.update(sceneLights, ViewMatrix, ProjectionMatrix);
+        lightClusters.fillFrameData(frame);
+        lightClusters.bind();
+        frameUniforms.update(&frame);
 
         // Cursor move
         cursor.setTrans(cursorPosition[0], cursorPosition[1], cursorPosition[2]);
 
-        // Reset MVP
+        // Reset model matrix (chunk meshes are in world space)
         glm::mat4 ModelMatrix = glm::mat4(1.0f);
-        glm::mat4 NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrix));
-        glUniformMatrix4fv(uMVPMatrix, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix * ViewMatrix * ModelMatrix)); //Model View Projection
-        glUniformMatrix4fv(uMVMatrix, 1, GL_FALSE, glm::value_ptr(ViewMatrix * ModelMatrix));
-        glUniformMatrix4fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+        glUniformMatrix4fv(uModelMatrix, 1, GL_FALSE, glm::value_ptr(ModelMatrix));
+        glUniformMatrix3fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(glm::mat3(ViewMatrix * ModelMatrix)))));
         
         // Enable depth test
         glEnable(GL_DEPTH_TEST);
         // Accept fragment if it closer to the camera than the former one
         glDepthFunc(GL_LESS);
 
-        // Draw cube list
-
-        // Active first texture
-        int currentTexture = myCubeList.getTextureIndex(0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textures[myCubeList.getTextureIndex(0)].getTexture()); // bind texture on GL_TEXTURE0
-        glUniform1i(textures[myCubeList.getTextureIndex(0)].getUniformLocation(), 0);
-        
-        // Reset variables
-        currentActive = -1;
-        thereIsACubeAbove = false;
-        thereIsACubeUnder = false;
+        // Draw cube list : one mesh per chunk, only the edited chunks (or those changing level of detail) are rebuilt
+        chunkRenderer.cull(occlusionCuller, ProjectionMatrix * ViewMatrix, c.getPosition());
+        glUniform1i(uPackedVertices, 1);
+        chunkRenderer.draw(textures);
+        glUniform1i(uPackedVertices, 0);
 
-        // Loop on cubes
-        for(int i=0; i<myCubeList.getSize(); i++){
+        // Draw props : one instanced draw per model
+        glUniform1i(uInstanced, 1);
+        propList.draw();
+        glUniform1i(uInstanced, 0);
 
-            // Get current cube
-            if ((myCubeList.getTrans(i).x == cursor.getTrans().x) && (myCubeList.getTrans(i).y == cursor.getTrans().y) && (myCubeList.getTrans(i).z == cursor.getTrans().z)){
-                currentActive = myCubeList.getCubeIndex(i);
-            }
-            // Is there a cube above current ?
-            if ((myCubeList.getTrans(i).x == cursor.getTrans().x) && (myCubeList.getTrans(i).y == cursor.getTrans().y+1) && (myCubeList.getTrans(i).z == cursor.getTrans().z)){
-                thereIsACubeAbove = true;
-            }
-            // Is there a cube under current ?
-            if ((myCubeList.getTrans(i).x == cursor.getTrans().x) && (myCubeList.getTrans(i).y == cursor.getTrans().y-1) && (myCubeList.getTrans(i).z == cursor.getTrans().z)){
-                thereIsACubeUnder = true;
-            }
-
-            // Active another texture if needed
-            if(currentTexture != myCubeList.getTextureIndex(i)){
-                currentTexture = myCubeList.getTextureIndex(i);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, textures[myCubeList.getTextureIndex(i)].getTexture());
-                glUniform1i(textures[myCubeList.getTextureIndex(i)].getUniformLocation(), 0);
-            }
-
-            // Bind VAO
-            glBindVertexArray(*myCubeList.getVAOListItem(myCubeList.getCubeIndex(i)+1));
-
-            // Transform
-            ModelMatrix = glm::scale(glm::mat4(1.0f), myCubeList.getScale(myCubeList.getCubeIndex(i)));
-            ModelMatrix = glm::rotate(ModelMatrix, myCubeList.getRotDeg(myCubeList.getCubeIndex(i)), myCubeList.getRot(myCubeList.getCubeIndex(i)));
-            ModelMatrix = glm::translate(ModelMatrix, myCubeList.getTrans(myCubeList.getCubeIndex(i)));
-            // Reset ModelViewProjection matrices
-            glUniformMatrix4fv(uMVPMatrix, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix * ViewMatrix * ModelMatrix)); //Model View Projection
-            glUniformMatrix4fv(uMVMatrix, 1, GL_FALSE, glm::value_ptr( ViewMatrix * ModelMatrix)); //Model View Projection
-            glUniformMatrix4fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(ViewMatrix * ModelMatrix)))); //Model View Projection
-
-            // Draw cube
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *myCubeList.getIBOListItem(myCubeList.getCubeIndex(i)+1));
-            glDrawElements(GL_TRIANGLES, myCubeList.getIBOCount(i), GL_UNSIGNED_INT, (void *)0);
-        }
-        
         // Disable depth for cursor
         glDisable(GL_DEPTH_TEST);
 
         // Repeat for drawing the cursor alone
-        glBindVertexArray(*myCubeList.getVAOListItem(0));
+        glBindVertexArray(cursorVAO);
 
         glBindTexture(GL_TEXTURE_2D, textures[cursor.getTextureIndex()].getTexture()); // la texture est bindée sur l'unité GL_TEXTURE0
         glUniform1i(textures[cursor.getTextureIndex()].getUniformLocation(), 0);
@@ -860,10 +897,11 @@ int main(int argc, char** argv) {
         ModelMatrix = glm::rotate(ModelMatrix, cursor.getRotDeg(), cursor.getRot());
         ModelMatrix = glm::translate(ModelMatrix, cursor.getTrans());
         
-        glUniformMatrix4fv(uMVPMatrix, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix * ViewMatrix * ModelMatrix)); //Model View Projection
+        glUniformMatrix4fv(uModelMatrix, 1, GL_FALSE, glm::value_ptr(ModelMatrix));
+        glUniformMatrix3fv(uNormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(glm::mat3(ViewMatrix * ModelMatrix)))));
 
         // Draw cursor
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *myCubeList.getIBOListItem(0));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cursorIBO);
         glLineWidth(5.0);
         glDrawElements(GL_LINES, cursor.getIBOCountBorder(), GL_UNSIGNED_INT, (void *)0);
 
@@ -873,57 +911,6 @@ int main(int argc, char** argv) {
         glBindTexture(GL_TEXTURE_2D, 0);
 
 
-        /*** Load 3D object ***/
-        // NormalMatrix, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(ViewMatrix * ModelMatrix)))); //Model View Projection
-        // Bind our texture in Texture Unit 0
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, Texture);
-        // Set our "myTextureSampler" sampler to use Texture Unit 0
-        glUniform1i(TextureID, 0);
-
-        // 1rst attribute buffer : vertices
-        glEnableVertexAttribArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-        glVertexAttribPointer(
-            0,                  // attribute
-            3,                  // size
-            GL_FLOAT,           // type
-            GL_FALSE,           // normalized?
-            0,                  // stride
-            (void*)0            // array buffer offset
-        );
-
-        // 2nd attribute buffer : UVs
-        glEnableVertexAttribArray(2);
-        glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-        glVertexAttribPointer(
-            2,                                // attribute
-            2,                                // size
-            GL_FLOAT,                         // type
-            GL_FALSE,                         // normalized?
-            0,                                // stride
-            (void*)0                          // array buffer offset
-        );
-
-        // 3rd attribute buffer : normals
-        glEnableVertexAttribArray(1);
-        glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-        glVertexAttribPointer(
-            1,                                // attribute
-            3,                                // size
-            GL_FLOAT,                         // type
-            GL_FALSE,                         // normalized?
-            0,                                // stride
-            (void*)0                          // array buffer offset
-        );
-
-        // Draw the triangles !
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size() );
-
-        glDisableVertexAttribArray(0);
-        glDisableVertexAttribArray(1);
-        glDisableVertexAttribArray(2);
-    
         // Render ImGui
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -933,6 +920,10 @@ int main(int argc, char** argv) {
     }
 
     // Destroy ImGui
+    glDeleteBuffers(1, &cursorIBO);
+    glDeleteVertexArrays(1, &cursorVAO);
+    glDeleteBuffers(1, &cursorVBO);
+    glDeleteTextures(propTextures.size(), propTextures.data());
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
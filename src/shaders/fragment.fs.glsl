@@ -4,40 +4,121 @@
 in vec3 vPosition_vs; // Position du sommet transformé dans l'espace View
 in vec3 vNormal_vs; // Normale du sommet transformé dans l'espace View
 in vec2 vUV;
+in float vOcclusion; // Occlusion ambiante (0 = aucune, 1 = coin fermé)
+in vec2 vVoxelLight; // Niveaux du ciel et des blocs lumineux (0 à 1, voir glimac::VoxelLight)
 
 
 // Values that stay constant for the whole mesh.
 uniform sampler2D uTextureSampler;
 
-uniform vec3 uKd;
-uniform vec3 uKs;
-uniform float uShininess;
-uniform vec3 uLightPos_vs;
-uniform vec3 uLightDir_vs;
-uniform vec3 uLightIntensityP;
-uniform vec3 uLightIntensityD;
-
-vec3 blinnPhongP(vec3 position_vs, vec3 normal_vs){
-    float d = distance(uLightPos_vs, position_vs);
+// Point lights binned per cluster (see glimac::LightClusters), on their own texture units
+uniform samplerBuffer uLightData; // 2 texels per light : position_vs + radius, color * intensity
+uniform usamplerBuffer uClusterRanges; // first index, count
+uniform usamplerBuffer uLightIndices;
+
+// Directional light shadow cascades, one layer each (see glimac::ShadowCascades)
+uniform sampler2DArrayShadow uShadowMap;
+
+// Shared by every program (see glimac::UniformBuffer)
+layout(std140) uniform FrameData {
+    mat4 uViewMatrix;
+    mat4 uProjectionMatrix;
+    mat4 uViewProjectionMatrix;
+    vec4 uClusterGrid; // tiles x, tiles y, depth slices, w = point light count
+    vec4 uClusterDepth; // near, far, slice scale (see glimac::LightClusters)
+    vec4 uLightDir_vs;
+    vec4 uLightIntensityD;
+    mat4 uShadowMatrices[3]; // view space to the shadow map of each cascade (see glimac::ShadowCascades)
+    vec4 uShadowSplits; // view depth where each cascade ends, w = shadows enabled
+};
+
+layout(std140) uniform MaterialData {
+    vec4 uKd;
+    vec4 uKs; // w = shininess
+};
+
+vec3 blinnPhongP(vec3 position_vs, vec3 normal_vs, vec3 lightPos_vs, float radius, vec3 intensity){
+    float d = distance(lightPos_vs, position_vs);
 	vec3 w_zero = normalize(-position_vs);
-	vec3 w_i = (normalize(uLightPos_vs - position_vs));
+	vec3 w_i = (normalize(lightPos_vs - position_vs));
 	vec3 halfVector = (w_zero + w_i) / 2;
 
-	return (uLightIntensityP / (d * d)) * ( uKd * ( dot(w_i, normal_vs ) ) + uKs * ( pow( dot(halfVector, normal_vs), uShininess ) ) );
+	// Smooth cut at the radius the light was binned with
+	float ratio = d / radius;
+	float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+	float attenuation = window * window / max(d * d, 0.01);
+
+	return (intensity * attenuation) * ( uKd.rgb * max( dot(w_i, normal_vs ), 0.0 ) + uKs.rgb * ( pow( max( dot(halfVector, normal_vs), 0.0 ), uKs.w ) ) );
 }
 
+// Sum of the point lights of the cluster containing the fragment
+vec3 clusteredLights(vec3 position_vs, vec3 normal_vs){
+    vec4 clip = uProjectionMatrix * vec4(position_vs, 1.0);
+    vec2 tile = clamp(floor((clip.xy / clip.w * 0.5 + 0.5) * uClusterGrid.xy), vec2(0.0), uClusterGrid.xy - 1.0);
+    float depth = max(-position_vs.z, uClusterDepth.x);
+    float slice = clamp(floor(log(depth / uClusterDepth.x) * uClusterDepth.z), 0.0, uClusterGrid.z - 1.0);
+    int cluster = int((slice * uClusterGrid.y + tile.y) * uClusterGrid.x + tile.x);
+
+    uvec2 range = texelFetch(uClusterRanges, cluster).xy;
+    vec3 result = vec3(0.0);
+    for(uint i = 0u; i < range.y; ++i){
+        int light = int(texelFetch(uLightIndices, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(uLightData, 2 * light);
+        vec3 intensity = texelFetch(uLightData, 2 * light + 1).rgb;
+        result += blinnPhongP(position_vs, normal_vs, positionRadius.xyz, positionRadius.w, intensity);
+    }
+    return result;
+}
+
+
+// Offset along the normal, in world units, against acne on surfaces facing away from the light
+const float SHADOW_NORMAL_OFFSET = 0.05;
+const vec2 SHADOW_TAPS[4] = vec2[4](vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(-0.5, 0.5), vec2(0.5, 0.5));
+
+// 1 if lit, 0 if in the shadow of the directional light
+float directionalShadow(vec3 position_vs, vec3 normal_vs){
+    float depth = -position_vs.z;
+    if(uShadowSplits.w == 0.0 || depth >= uShadowSplits.z){
+        return 1.0;
+    }
+    int cascade = (depth < uShadowSplits.x) ? 0 : ((depth < uShadowSplits.y) ? 1 : 2);
+    vec4 coord = uShadowMatrices[cascade] * vec4(position_vs + normal_vs * SHADOW_NORMAL_OFFSET * float(cascade + 1), 1.0);
+    // Beyond the casters of the cascade
+    if(coord.z >= 1.0){
+        return 1.0;
+    }
+
+    // 4 taps, each one filtered 2x2 by the comparison sampler
+    vec2 texel = 1.0 / vec2(textureSize(uShadowMap, 0).xy);
+    float lit = 0.0;
+    for(int i = 0; i < 4; ++i){
+        lit += texture(uShadowMap, vec4(coord.xy + SHADOW_TAPS[i] * texel, float(cascade), coord.z));
+    }
+    return lit * 0.25;
+}
 
 vec3 blinnPhongD(vec3 position_vs, vec3 normal_vs){
 
 	vec3 w_zero = normalize(-position_vs);
-	vec3 w_i = normalize(-uLightDir_vs);
+	vec3 w_i = normalize(-uLightDir_vs.xyz);
 	vec3 halfVector = (w_zero + w_i) / 2;
 
-	return uLightIntensityD * ( uKd * ( dot(w_i, normal_vs ) ) + uKs * ( pow( dot(halfVector, normal_vs), uShininess ) ) );
+	return directionalShadow(position_vs, normal_vs) * uLightIntensityD.rgb * ( uKd.rgb * max( dot(w_i, normal_vs ), 0.0 ) + uKs.rgb * ( pow( max( dot(halfVector, normal_vs), 0.0 ), uKs.w ) ) );
 }
 
 
 
+// Share of the light removed in a fully occluded corner
+const float AO_STRENGTH = 0.6;
+
+// Flood-filled voxel light : each step away from the source keeps 80% of the light
+const vec3 SKY_AMBIENT = vec3(0.15);
+const vec3 BLOCK_LIGHT_COLOR = vec3(1.0, 0.75, 0.45);
+
+float voxelLightCurve(float level){
+    return (level > 0.0) ? pow(0.8, 15.0 * (1.0 - level)) : 0.0;
+}
+
 // Ouput data
 out vec3 fFragColor;
 
@@ -51,7 +132,9 @@ void main(){
 	
 
     //fFragColor += color.rgb * (blinnPhongP(vPosition_vs, normalize(vNormal_vs)));
-	fFragColor = color.rgb * (blinnPhongP(vPosition_vs, normalize(vNormal_vs)) + blinnPhongD(vPosition_vs, normalize(vNormal_vs)));
+	vec3 voxelLight = SKY_AMBIENT * voxelLightCurve(vVoxelLight.x) + BLOCK_LIGHT_COLOR * voxelLightCurve(vVoxelLight.y);
+	fFragColor = color.rgb * (clusteredLights(vPosition_vs, normalize(vNormal_vs)) + blinnPhongD(vPosition_vs, normalize(vNormal_vs)) + voxelLight);
+	fFragColor *= 1.0 - AO_STRENGTH * vOcclusion;
     //fFragColor += color.rgb * blinnPhongD(vPosition_vs, normalize(vNormal_vs));
 }
 
@@ -0,0 +1,15 @@
+#version 330 core
+
+// Depth pass of the shadow cascades : chunk meshes only (see glimac::ShadowCascades)
+layout(location = 3) in uvec2 aPackedVertex; // 8 bytes vertex (see PackedVoxelVertex)
+layout(location = 4) in ivec4 aChunkOrigin; // world position of the chunk minimal corner, w = level of detail
+
+uniform mat4 uLightViewProjection;
+
+void main(){
+    // Same position decoding as vertex.vs.glsl
+    uint word = aPackedVertex.x;
+    vec3 local = vec3(uvec3(word, word >> 5u, word >> 10u) & uvec3(31u));
+    vec3 position = vec3(aChunkOrigin.xyz) + local * float(1 << aChunkOrigin.w) - vec3(0.5);
+    gl_Position = uLightViewProjection * vec4(position, 1);
+}
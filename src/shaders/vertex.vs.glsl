@@ -4,11 +4,16 @@
 layout(location = 0) in vec3 aVertexPosition_modelspace;
 layout(location = 1) in vec3 aVertexNormal;
 layout(location = 2) in vec2 aVertexUV;
+layout(location = 3) in uvec2 aPackedVertex; // Chunk meshes : 8 bytes vertex (see PackedVoxelVertex)
+layout(location = 4) in ivec4 aChunkOrigin; // Chunk meshes : world position of the chunk minimal corner, w = level of detail
+layout(location = 5) in mat4 aInstanceMatrix; // Props : model matrix of the instance, locations 5 to 8 (see PropList)
 
 // Output data ; will be interpolated for each fragment.
 out vec2 vUV;
 out vec3 vPosition_vs; //position du sommet transformée dans le view space
 out vec3 vNormal_vs; //normale du sommet transformée dans le view space
+out float vOcclusion; //occlusion ambiante du sommet
+out vec2 vVoxelLight; //lumière du ciel et des blocs (0 à 1), calculée sur le CPU
 
 
 mat3 translate(float tx, float ty){
@@ -16,25 +21,68 @@ mat3 translate(float tx, float ty){
     return M;
 }
 
+// Values that stay constant for the whole frame, shared by every program (see glimac::UniformBuffer)
+layout(std140) uniform FrameData {
+    mat4 uViewMatrix;
+    mat4 uProjectionMatrix;
+    mat4 uViewProjectionMatrix;
+    vec4 uClusterGrid; // tiles x, tiles y, depth slices, w = point light count
+    vec4 uClusterDepth; // near, far, slice scale (see glimac::LightClusters)
+    vec4 uLightDir_vs;
+    vec4 uLightIntensityD;
+    mat4 uShadowMatrices[3]; // view space to the shadow map of each cascade (see glimac::ShadowCascades)
+    vec4 uShadowSplits; // view depth where each cascade ends, w = shadows enabled
+};
+
 // Values that stay constant for the whole mesh.
-uniform mat4 uMVPMatrix;
-uniform mat4 uMVMatrix;
-uniform mat4 uNormalMatrix;
+uniform mat4 uModelMatrix;
+uniform mat3 uNormalMatrix; // transpose(inverse(mat3(View * uModelMatrix))), computed once per draw on the CPU
+uniform bool uPackedVertices; // true to decode aPackedVertex instead of the float attributes
+uniform bool uInstanced; // true to take the model matrix from aInstanceMatrix instead of uModelMatrix
+
+// Face order of ChunkMesh.cpp
+const vec3 FACE_NORMALS[6] = vec3[6](vec3(0,-1,0), vec3(0,0,1), vec3(-1,0,0), vec3(0,0,-1), vec3(1,0,0), vec3(0,1,0));
+const vec2 CORNER_UVS[4] = vec2[4](vec2(0,0), vec2(1,0), vec2(1,1), vec2(0,1));
 
 void main(){
 
-    vec4 vertexPosition = vec4(aVertexPosition_modelspace, 1);
-	vec4 vertexNormal = vec4(aVertexNormal, 0);
+    vec3 position = aVertexPosition_modelspace;
+    vec3 normal = aVertexNormal;
+    vec2 uv = aVertexUV;
+    float occlusion = 0.0;
+    vec2 voxelLight = vec2(1.0, 0.0);
+    if(uPackedVertices){
+        uint word = aPackedVertex.x;
+        vec3 local = vec3(uvec3(word, word >> 5u, word >> 10u) & uvec3(31u));
+        position = vec3(aChunkOrigin.xyz) + local * float(1 << aChunkOrigin.w) - vec3(0.5);
+        normal = FACE_NORMALS[int((word >> 15u) & 7u)];
+        uv = CORNER_UVS[int((word >> 18u) & 3u)];
+        occlusion = float((word >> 20u) & 3u) / 3.0;
+        voxelLight = vec2(uvec2(aPackedVertex.y >> 12u, aPackedVertex.y >> 8u) & uvec2(15u)) / 15.0;
+    }
+
+    mat4 modelMatrix = uInstanced ? aInstanceMatrix : uModelMatrix;
+    vec4 vertexPosition = modelMatrix * vec4(position, 1);
+    // No inverse per vertex : chunks are in world space and the view is orthonormal,
+    // props only have a uniform scale (the fragment shader normalizes the normal)
+    mat3 normalMatrix = uNormalMatrix;
+    if(uPackedVertices){
+        normalMatrix = mat3(uViewMatrix);
+    }else if(uInstanced){
+        normalMatrix = mat3(uViewMatrix * aInstanceMatrix);
+    }
 
 	//Valeurs de sortie
-	vPosition_vs = vec3(uMVMatrix * vertexPosition);
-    vNormal_vs = vec3(uNormalMatrix * vertexNormal);
+	vPosition_vs = vec3(uViewMatrix * vertexPosition);
+    vNormal_vs = normalMatrix * normal;
 
     // Output position of the vertex, in clip space : MVP * position
-    gl_Position = uMVPMatrix * vec4(aVertexPosition_modelspace, 1);
+    gl_Position = uViewProjectionMatrix * vertexPosition;
 
     // UV of the vertex. No special space for this one.
-    vUV = aVertexUV;
+    vUV = uv;
+    vOcclusion = occlusion;
+    vVoxelLight = voxelLight;
 }
 
 
@@ -0,0 +1,196 @@
+/**
+ * \file MeshBVHTest.cpp
+ * \brief Vérification de la BVH des maillages
+ * \author MANSION Amélia & SGRO' Manon
+ * \version 0.1
+ * \date 20 décembre 2019
+ *
+ * Compare les requêtes de MeshBVH (rayon le plus proche, triangles d'une boîte) à un parcours de tous
+ * les triangles, et la construction parallèle à la construction sur un seul thread. CPU seulement.
+ *
+ */
+
+#include <glimac/MeshBVH.hpp>
+#include <algorithm>
+#include <random>
+
+using namespace glimac;
+
+namespace {
+
+    // Random triangles of varying sizes
+    void makeSoup(std::mt19937& random, uint32_t triangleCount, std::vector<ShapeVertex>& vertices, std::vector<uint32_t>& indices){
+        std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+        for(uint32_t i=0; i<triangleCount; i++){
+            const glm::vec3 center(position(random), position(random), position(random));
+            const float size = (i%10 == 0) ? 4.0f : 0.5f;
+            for(int j=0; j<3; j++){
+                ShapeVertex vertex;
+                vertex.position = center + size*glm::vec3(offset(random), offset(random), offset(random));
+                vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                vertex.texCoords = glm::vec2(0.0f);
+                indices.push_back(vertices.size());
+                vertices.push_back(vertex);
+            }
+        }
+    }
+
+    // Closed sphere with shared vertices, as an imported mesh would be
+    void makeSphere(uint32_t rings, uint32_t sectors, std::vector<ShapeVertex>& vertices, std::vector<uint32_t>& indices){
+        for(uint32_t i=0; i<=rings; i++){
+            const float theta = glm::pi<float>()*i/rings;
+            for(uint32_t j=0; j<=sectors; j++){
+                const float phi = 2.0f*glm::pi<float>()*j/sectors;
+                ShapeVertex vertex;
+                vertex.normal = glm::vec3(std::sin(theta)*std::cos(phi), std::cos(theta), std::sin(theta)*std::sin(phi));
+                vertex.position = 3.0f*vertex.normal;
+                vertex.texCoords = glm::vec2(float(j)/sectors, float(i)/rings);
+                vertices.push_back(vertex);
+            }
+        }
+        for(uint32_t i=0; i<rings; i++){
+            for(uint32_t j=0; j<sectors; j++){
+                const uint32_t first = i*(sectors + 1) + j, second = first + sectors + 1;
+                const uint32_t quad[6] = {first, second, first + 1, second, second + 1, first + 1};
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+
+    // Same Möller-Trumbore test as the BVH, on every triangle
+    bool bruteForceRay(const std::vector<ShapeVertex>& vertices, const std::vector<uint32_t>& indices,
+                       const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance){
+        bool found = false;
+        distance = maxDistance;
+        for(size_t i=0; i<indices.size(); i+=3){
+            const glm::vec3& a = vertices[indices[i]].position;
+            const glm::vec3 edge1 = vertices[indices[i + 1]].position - a;
+            const glm::vec3 edge2 = vertices[indices[i + 2]].position - a;
+            const glm::vec3 p = glm::cross(direction, edge2);
+            const float determinant = glm::dot(edge1, p);
+            if(determinant == 0.0f){
+                continue;
+            }
+            const float inverse = 1.0f/determinant;
+            const glm::vec3 s = origin - a;
+            const float u = glm::dot(s, p)*inverse;
+            if(u < 0.0f || u > 1.0f){
+                continue;
+            }
+            const glm::vec3 q = glm::cross(s, edge1);
+            const float v = glm::dot(direction, q)*inverse;
+            if(v < 0.0f || u + v > 1.0f){
+                continue;
+            }
+            const float t = glm::dot(edge2, q)*inverse;
+            if(t >= 0.0f && t < distance){
+                distance = t;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // parallelSubtrees : the mesh is large enough for the pool to build subtrees (splice checked)
+    int checkMesh(const char* name, const std::vector<ShapeVertex>& vertices, const std::vector<uint32_t>& indices, ThreadPool& pool, bool parallelSubtrees){
+        const uint32_t triangleCount = indices.size()/3;
+        MeshBVH serial, parallel;
+        serial.build(vertices.data(), indices.data(), triangleCount);
+        parallel.build(vertices.data(), indices.data(), triangleCount, &pool);
+        int errors = 0;
+        if(!serial.isValid(vertices.size()) || !parallel.isValid(vertices.size())){
+            std::cerr << "[ERROR] " << name << " : invalid BVH" << std::endl;
+            return 1;
+        }
+        if(parallelSubtrees && parallel.getSubtreeCount() == 0){
+            std::cerr << "[ERROR] " << name << " : no subtree built on the pool" << std::endl;
+            errors++;
+        }
+
+        const glm::vec3 boundsMin = serial.getNodes()[0].boundsMin, boundsMax = serial.getNodes()[0].boundsMax;
+        const glm::vec3 center = 0.5f*(boundsMin + boundsMax), size = boundsMax - boundsMin;
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        // Brute force : about 1e8 ray/triangle tests at most, whatever the mesh size
+        const int RAY_COUNT = std::min<uint32_t>(2000, 100000000/triangleCount);
+        int hits = 0;
+        for(int i=0; i<RAY_COUNT; i++){
+            const glm::vec3 origin = center + 1.5f*size*glm::vec3(unit(random), unit(random), unit(random));
+            const glm::vec3 target = center + 0.5f*size*glm::vec3(unit(random), unit(random), unit(random));
+            const glm::vec3 direction = target - origin;
+            // Some rays stop before the mesh
+            const float maxDistance = (i%4 == 0) ? 0.5f : 1e9f;
+            float expected;
+            const bool found = bruteForceRay(vertices, indices, origin, direction, maxDistance, expected);
+            MeshRayHit serialHit, parallelHit;
+            const bool serialFound = serial.intersectRay(origin, direction, maxDistance, serialHit);
+            const bool parallelFound = parallel.intersectRay(origin, direction, maxDistance, parallelHit);
+            if(serialFound != found || parallelFound != found){
+                errors++;
+                continue;
+            }
+            if(found){
+                hits++;
+                if(serialHit.distance != expected || parallelHit.distance != expected){
+                    errors++;
+                }
+            }
+        }
+
+        const int BOX_COUNT = std::min<uint32_t>(300, 30000000/triangleCount);
+        for(int i=0; i<BOX_COUNT; i++){
+            const glm::vec3 boxCenter = center + 0.5f*size*glm::vec3(unit(random), unit(random), unit(random));
+            const glm::vec3 halfSize = 0.1f*size*glm::abs(glm::vec3(unit(random), unit(random), unit(random)));
+            std::vector<uint32_t> expected;
+            for(uint32_t t=0; t<triangleCount; t++){
+                if(triangleOverlapsBox(vertices[indices[3*t]].position, vertices[indices[3*t + 1]].position,
+                                       vertices[indices[3*t + 2]].position, boxCenter - halfSize, boxCenter + halfSize)){
+                    expected.push_back(t);
+                }
+            }
+            std::vector<uint32_t> serialTriangles, parallelTriangles;
+            serial.queryBox(boxCenter - halfSize, boxCenter + halfSize, serialTriangles);
+            parallel.queryBox(boxCenter - halfSize, boxCenter + halfSize, parallelTriangles);
+            std::sort(serialTriangles.begin(), serialTriangles.end());
+            std::sort(parallelTriangles.begin(), parallelTriangles.end());
+            if(serialTriangles != expected || parallelTriangles != expected){
+                errors++;
+            }
+        }
+
+        std::cout << name << " : " << triangleCount << " triangles, " << serial.getNodeCount() << " nodes, "
+                  << parallel.getSubtreeCount() << " subtrees on the pool, "
+                  << hits << "/" << RAY_COUNT << " rays hit, " << errors << " errors" << std::endl;
+        return errors;
+    }
+
+}
+
+int main(){
+    ThreadPool pool(4);
+    std::mt19937 random(7);
+    int errors = 0;
+
+    std::vector<ShapeVertex> vertices;
+    std::vector<uint32_t> indices;
+    // Subtrees are only deferred above 4096 triangles at depth 3 (4 threads) : 200000 gives several
+    makeSoup(random, 200000, vertices, indices);
+    errors += checkMesh("soup", vertices, indices, pool, true);
+
+    vertices.clear();
+    indices.clear();
+    makeSphere(64, 128, vertices, indices);
+    errors += checkMesh("sphere", vertices, indices, pool, false);
+
+    // Triangle and boxes that do or do not touch
+    const glm::vec3 a(0.0f, 0.0f, 0.0f), b(1.0f, 0.0f, 0.0f), c(0.0f, 1.0f, 0.0f);
+    if(!triangleOverlapsBox(a, b, c, glm::vec3(0.1f, 0.1f, -0.1f), glm::vec3(0.2f, 0.2f, 0.1f))
+       || triangleOverlapsBox(a, b, c, glm::vec3(0.6f, 0.6f, -0.1f), glm::vec3(0.9f, 0.9f, 0.1f))){
+        std::cerr << "[ERROR] triangleOverlapsBox" << std::endl;
+        errors++;
+    }
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}